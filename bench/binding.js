@@ -0,0 +1,195 @@
+'use strict';
+
+// Замер стоимости слоя привязки к JS: передачи результатов в observer.cc, Promise-оберток
+// lib/observer.js и объединения одновременных опросов. Для каждого сценария выводятся опросы
+// в секунду, задержки (p50, p99), утилизация основного потока, сборки мусора и прирост кучи.
+// Стоимость самого опроса без Node.JS замеряет build/Release/testtools-bench (bench/observer.cc),
+// поэтому разница между ними - стоимость привязки.
+//
+// Сценарии выполняются для /proc и для синтетического дерева процессов (bench/fixture.js, только Linux):
+// опрос наблюдателей за системой, процессом и процессами по имени (poll и pollInto),
+// одновременные опросы одного наблюдателя и Observer.pollAll, Observer.processes() на 1000
+// и 10000 процессов синтетического дерева.
+//
+// Использование: node --expose-gc bench/binding.js [--iterations N] [--concurrency N] [--source S] [--dir DIR]
+//   --iterations N   количество опросов в каждом сценарии (по умолчанию 2000, для processes() - 20)
+//   --concurrency N  количество одновременных опросов (по умолчанию 8)
+//   --source S       real, fixture или both (по умолчанию both; fixture - только Linux)
+//   --dir DIR        каталог синтетических деревьев (по умолчанию - во временном каталоге)
+// С --expose-gc прирост кучи измеряется после сборки мусора, иначе он включает еще не собранный мусор.
+
+const os = require('os');
+const path = require('path');
+const { constants, performance, PerformanceObserver } = require('perf_hooks');
+
+const Observer = require('../lib/observer.js');
+const { createFixture } = require('./fixture.js');
+
+// Все счетчики наблюдателей
+const SYSTEM_MASK = 0x3FFF;
+const PROCESS_MASK = 0x7F;
+
+function option(name, fallback) {
+    const index = process.argv.indexOf(name);
+    return -1 === index ? fallback : process.argv[index + 1];
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+function round(value) {
+    return Math.round(value * 1000) / 1000;
+}
+
+// Сборки мусора во время замера (performance entries типа 'gc'), кроме вызванных global.gc()
+const gc = { count: 0, duration: 0 };
+new PerformanceObserver(list => {
+    for (const entry of list.getEntries()) {
+        const flags = entry.detail ? entry.detail.flags : entry.flags;
+        if (flags & constants.NODE_PERFORMANCE_GC_FLAGS_FORCED) continue;
+        gc.count++;
+        gc.duration += entry.duration;
+    }
+}).observe({ entryTypes: ['gc'] });
+
+function collectGarbage() {
+    if ('function' === typeof global.gc) global.gc();
+}
+
+// Ждет доставки записей PerformanceObserver о сборках мусора, выполненных в сценарии
+function flushEntries() {
+    return new Promise(resolve => setImmediate(resolve));
+}
+
+// Выполняет сценарий: concurrency цепочек вызовов fn, всего iterations вызовов
+async function measure(name, iterations, concurrency, fn) {
+    // Прогрев: компиляция JS, кэши модуля и первые опросы наблюдателей
+    for (let i = 0; i < Math.min(10, iterations); ++i) await fn();
+
+    collectGarbage();
+    await flushEntries();
+    const heap = process.memoryUsage().heapUsed;
+    const gcCount = gc.count;
+    const gcDuration = gc.duration;
+
+    const latencies = [];
+    let started = 0;
+    const chain = async () => {
+        while (started < iterations) {
+            started++;
+            const start = performance.now();
+            await fn();
+            latencies.push(performance.now() - start);
+        }
+    };
+
+    const elu = performance.eventLoopUtilization();
+    const start = performance.now();
+    await Promise.all(new Array(concurrency).fill(0).map(chain));
+    const wall = performance.now() - start;
+    const busy = performance.eventLoopUtilization(elu);
+
+    await flushEntries();
+    const gcs = gc.count - gcCount;
+    const gcMs = gc.duration - gcDuration;
+    collectGarbage();
+    const heapDelta = process.memoryUsage().heapUsed - heap;
+
+    latencies.sort((a, b) => a - b);
+    return {
+        name,
+        iterations,
+        concurrency,
+        pollsPerSec: round(iterations * 1000 / wall),
+        latencyMs: { p50: round(percentile(latencies, 0.5)), p99: round(percentile(latencies, 0.99)) },
+        mainThreadUsPerCall: round(busy.active * 1000 / iterations),
+        eventLoopUtilization: round(busy.utilization),
+        gc: { count: gcs, ms: round(gcMs), per1000Calls: round(gcs * 1000 / iterations) },
+        heapDeltaKb: round(heapDelta / 1024)
+    };
+}
+
+// Сценарии опроса наблюдателей одного источника
+async function pollScenarios(iterations, concurrency, pid, name) {
+    const system = new Observer();
+    const byId = new Observer(pid);
+    const byName = new Observer(name);
+    const results = [];
+
+    const observers = [['system', system, SYSTEM_MASK], ['pid', byId, PROCESS_MASK], ['name', byName, PROCESS_MASK]];
+    for (const [type, observer, mask] of observers) {
+        results.push(await measure(`${type}.poll`, iterations, 1, () => observer.poll(mask)));
+
+        const target = new Float64Array(Observer.STRIDE * 4096);
+        results.push(await measure(`${type}.pollInto`, iterations, 1, () => observer.pollInto(mask, target)));
+
+        // Одновременные опросы одного наблюдателя объединяются в один опрос (см. Observer#CompletePoll)
+        results.push(await measure(`${type}.poll x${concurrency}`, iterations, concurrency, () => observer.poll(mask)));
+    }
+
+    const items = observers.map(([, observer, mask]) => ({ observer, mask }));
+    results.push(await measure('pollAll', iterations, 1, () => Observer.pollAll(items)));
+    results.push(await measure(`pollAll x${concurrency}`, iterations, concurrency, () => Observer.pollAll(items)));
+    results.push(await measure(`Promise.all(poll) x${concurrency}`, iterations, concurrency,
+        () => Promise.all(observers.map(([, observer, mask]) => observer.poll(mask)))));
+
+    return results;
+}
+
+async function processesScenario(label, iterations) {
+    const count = (await Observer.processes()).length;
+    const result = await measure(label, iterations, 1, () => Observer.processes());
+    result.processes = count;
+    return result;
+}
+
+async function real(iterations, concurrency) {
+    if ('linux' === process.platform) Observer.setProcRoot('');
+    const name = (await Observer.processes()).find(item => item.pid === process.pid).name;
+    return {
+        source: 'real',
+        scenarios: (await pollScenarios(iterations, concurrency, process.pid, name))
+            .concat(await processesScenario('processes', Math.max(1, Math.floor(iterations / 100))))
+    };
+}
+
+async function fixture(iterations, concurrency, dir) {
+    const scenarios = [];
+
+    // Наблюдатели опрашивают дерево из 1000 процессов; процессы с именем kserver - по 64 потока
+    const small = createFixture(path.join(dir, 'proc-1k'), { processes: 1000 });
+    Observer.setProcRoot(small.root);
+    scenarios.push(...await pollScenarios(iterations, concurrency, small.instances[0], small.name));
+    scenarios.push(await processesScenario('processes 1k', Math.max(1, Math.floor(iterations / 100))));
+
+    const large = createFixture(path.join(dir, 'proc-10k'), { processes: 10000 });
+    Observer.setProcRoot(large.root);
+    scenarios.push(await processesScenario('processes 10k', Math.max(1, Math.floor(iterations / 100))));
+
+    Observer.setProcRoot('');
+    return { source: 'fixture', root: dir, scenarios };
+}
+
+async function main() {
+    const iterations = Number(option('--iterations', 2000));
+    const concurrency = Number(option('--concurrency', 8));
+    const source = option('--source', 'both');
+    const dir = path.resolve(option('--dir', path.join(os.tmpdir(), 'testtools-fixture')));
+
+    const results = [];
+    if ('fixture' !== source)
+        results.push(await real(iterations, concurrency));
+    if ('real' !== source && 'linux' === process.platform)
+        results.push(await fixture(iterations, concurrency, dir));
+
+    console.log(JSON.stringify({
+        node: process.version,
+        platform: process.platform,
+        cpus: os.cpus().length,
+        exposeGc: 'function' === typeof global.gc,
+        results
+    }, null, 2));
+}
+
+main().catch(error => { console.error(error); process.exit(1); });
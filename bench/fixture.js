@@ -0,0 +1,349 @@
+'use strict';
+
+// Синтетическое дерево procfs для замеров и проверок на заданном количестве процессов и потоков
+// (см. Observer.setProcRoot). Содержимое файлов stat, status, statm, cmdline, fd и task повторяет
+// формат ядра и однозначно определяется параметрами (включая seed), поэтому результаты опроса
+// воспроизводимы. Файлы /proc/self в дерево не входят - наблюдатели считают, что cgroup нет.
+//
+// Использование: node bench/fixture.js --dir DIR [--processes N] [--threads N] [--fds N]
+//                    [--name NAME --instances N --instance-threads N] [--cpus N] [--seed N]
+//   --dir DIR               каталог дерева (будет создан, существующее содержимое удаляется)
+//   --processes N           количество процессов (по умолчанию 1000), из них 10% - потоки ядра
+//   --threads N             количество потоков каждого процесса (по умолчанию 1)
+//   --fds N                 среднее количество открытых дескрипторов процесса (по умолчанию 8)
+//   --name NAME             имя процессов для ProcessNameObserver (по умолчанию kserver)
+//   --instances N           количество процессов с этим именем (по умолчанию 4)
+//   --instance-threads N    количество потоков каждого из них (по умолчанию 64)
+//   --cpus N                количество процессоров в /proc/stat (по умолчанию 8)
+//   --seed N                начальное значение генератора случайных чисел (по умолчанию 1)
+
+const fs = require('fs');
+const path = require('path');
+
+// Время загрузки системы (btime) и количество тиков в секунду
+const BOOT_TIME = 1700000000;
+const CLOCK_TICKS = 100;
+const PAGE_KBYTES = 4;
+const MEMORY_KBYTES = 32 * 1024 * 1024;
+
+// Имена пользовательских процессов: [comm, путь к исполняемому файлу, uid]
+const PROGRAMS = [
+    ['systemd-journal', '/usr/lib/systemd/systemd-journald', 0],
+    ['systemd-udevd', '/usr/lib/systemd/systemd-udevd', 0],
+    ['sshd', '/usr/sbin/sshd', 0],
+    ['cron', '/usr/sbin/cron', 0],
+    ['rsyslogd', '/usr/sbin/rsyslogd', 104],
+    ['dbus-daemon', '/usr/bin/dbus-daemon', 103],
+    ['bash', '/usr/bin/bash', 1000],
+    ['sleep', '/usr/bin/sleep', 1000],
+    ['node', '/usr/bin/node', 1000],
+    ['python3', '/usr/bin/python3.10', 1000],
+    ['java', '/usr/lib/jvm/java-17-openjdk-amd64/bin/java', 1001],
+    ['postgres', '/usr/lib/postgresql/14/bin/postgres', 113],
+    ['nginx', '/usr/sbin/nginx', 33],
+    ['containerd-shim', '/usr/bin/containerd-shim-runc-v2', 0]
+];
+
+// Имена потоков ядра
+const KERNEL_THREADS = ['kworker/0:1', 'ksoftirqd/0', 'migration/0', 'rcu_preempt', 'kswapd0', 'jbd2/sda1-8'];
+
+function option(name, fallback) {
+    const index = process.argv.indexOf(name);
+    return -1 === index ? fallback : process.argv[index + 1];
+}
+
+// Генератор псевдослучайных чисел (mulberry32): одинаковые параметры - одинаковое дерево
+function random(seed) {
+    let state = seed >>> 0;
+    const next = () => {
+        state = (state + 0x6D2B79F5) >>> 0;
+        let t = state;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+    next.int = (min, max) => min + Math.floor(next() * (max - min + 1));
+    return next;
+}
+
+function stat(task) {
+    // Поля 2-52 согласно proc(5), начиная с comm
+    const code = task.kernel ? [0, 0, 0] : [94371840000000, 94371840123456, 140720000000000];
+    const data = task.kernel ? [0, 0, 0, 0, 0, 0, 0] :
+        [94371840200000, 94371840210000, 94371860000000, 140720000100000, 140720000100200, 140720000100200, 140720000101000];
+    const fields = [
+        `(${task.comm})`, task.state, task.ppid, task.tgid, task.tgid, 0, -1, task.kernel ? 2129984 : 4194560,
+        task.minflt, 0, task.majflt, 0, task.utime, task.stime, 0, 0, 20, 0, task.threads, 0, task.start,
+        task.vsize * 1024, task.rss, '18446744073709551615', ...code, 0, 0, 0, 0,
+        task.kernel ? 2147483647 : 4096, task.kernel ? 0 : 134234626, 1, 0, 0, 17, task.cpu, 0, 0, 0, 0, 0,
+        ...data, 0
+    ];
+    return `${task.pid} ${fields.join(' ')}\n`;
+}
+
+function status(task) {
+    const kb = value => `${String(value).padStart(8)} kB`;
+    const lines = [
+        `Name:\t${task.comm}`,
+        `Umask:\t${task.kernel ? '0000' : '0022'}`,
+        `State:\t${'R' === task.state ? 'R (running)' : 'S (sleeping)'}`,
+        `Tgid:\t${task.tgid}`,
+        'Ngid:\t0',
+        `Pid:\t${task.pid}`,
+        `PPid:\t${task.ppid}`,
+        'TracerPid:\t0',
+        `Uid:\t${task.uid}\t${task.uid}\t${task.uid}\t${task.uid}`,
+        `Gid:\t${task.uid}\t${task.uid}\t${task.uid}\t${task.uid}`,
+        `FDSize:\t${task.kernel ? 64 : Math.max(64, 1 << Math.ceil(Math.log2(task.fds + 1)))}`,
+        'Groups:\t',
+        `NStgid:\t${task.tgid}`,
+        `NSpid:\t${task.pid}`,
+        `NSpgid:\t${task.tgid}`,
+        `NSsid:\t${task.tgid}`
+    ];
+    if (!task.kernel) {
+        lines.push(
+            `VmPeak:\t${kb(task.vsize + 4096)}`,
+            `VmSize:\t${kb(task.vsize)}`,
+            `VmLck:\t${kb(0)}`,
+            `VmPin:\t${kb(0)}`,
+            `VmHWM:\t${kb(task.rss * PAGE_KBYTES + 512)}`,
+            `VmRSS:\t${kb(task.rss * PAGE_KBYTES)}`,
+            `RssAnon:\t${kb(task.anon)}`,
+            `RssFile:\t${kb(task.rss * PAGE_KBYTES - task.anon)}`,
+            `RssShmem:\t${kb(0)}`,
+            `VmData:\t${kb(Math.floor(task.vsize / 2))}`,
+            `VmStk:\t${kb(132)}`,
+            `VmExe:\t${kb(2148)}`,
+            `VmLib:\t${kb(8456)}`,
+            `VmPTE:\t${kb(Math.ceil(task.vsize / 4096))}`,
+            `VmSwap:\t${kb(task.swap)}`,
+            `HugetlbPages:\t${kb(0)}`,
+            'CoreDumping:\t0',
+            'THP_enabled:\t1');
+    }
+    lines.push(
+        `Threads:\t${task.threads}`,
+        'SigQ:\t0/127573',
+        'SigPnd:\t0000000000000000',
+        'ShdPnd:\t0000000000000000',
+        'SigBlk:\t0000000000000000',
+        `SigIgn:\t${task.kernel ? 'ffffffffffffffff' : '0000000000001000'}`,
+        `SigCgt:\t${task.kernel ? '0000000000000000' : '0000000188004602'}`,
+        'CapInh:\t0000000000000000',
+        `CapPrm:\t${0 === task.uid ? '000001ffffffffff' : '0000000000000000'}`,
+        `CapEff:\t${0 === task.uid ? '000001ffffffffff' : '0000000000000000'}`,
+        'CapBnd:\t000001ffffffffff',
+        'CapAmb:\t0000000000000000',
+        'NoNewPrivs:\t0',
+        'Seccomp:\t0',
+        'Seccomp_filters:\t0',
+        'Speculation_Store_Bypass:\tthread vulnerable',
+        'SpeculationIndirectBranch:\tconditional enabled',
+        `Cpus_allowed:\t${task.cpusMask}`,
+        `Cpus_allowed_list:\t${task.cpusList}`,
+        'Mems_allowed:\t00000000,00000001',
+        'Mems_allowed_list:\t0',
+        `voluntary_ctxt_switches:\t${task.minflt * 3}`,
+        `nonvoluntary_ctxt_switches:\t${task.majflt}`);
+    return lines.join('\n') + '\n';
+}
+
+function statm(task) {
+    if (task.kernel) return '0 0 0 0 0 0 0\n';
+    const shared = Math.floor(task.rss / 3);
+    return `${task.vsize / PAGE_KBYTES} ${task.rss} ${shared} 537 0 ${Math.floor(task.vsize / 8)} 0\n`;
+}
+
+function write(dir, name, content) {
+    fs.writeFileSync(path.join(dir, name), content);
+}
+
+function writeTask(dir, task) {
+    fs.mkdirSync(dir);
+    write(dir, 'stat', stat(task));
+    write(dir, 'status', status(task));
+    write(dir, 'statm', statm(task));
+    write(dir, 'comm', task.comm + '\n');
+    write(dir, 'cmdline', task.cmdline);
+}
+
+function writeSystem(root, options, summary, rnd) {
+    const cpu = () => [rnd.int(1e6, 5e6), rnd.int(0, 1e4), rnd.int(1e5, 1e6), rnd.int(1e7, 5e7),
+        rnd.int(1e3, 1e5), 0, rnd.int(1e3, 1e4), 0, 0, 0];
+    const cpus = [];
+    for (let i = 0; i < options.cpus; ++i) cpus.push(cpu());
+    const total = cpus.reduce((sum, times) => sum.map((value, i) => value + times[i]), new Array(10).fill(0));
+    write(root, 'stat', [
+        `cpu  ${total.join(' ')}`,
+        ...cpus.map((times, i) => `cpu${i} ${times.join(' ')}`),
+        `intr ${rnd.int(1e8, 1e9)} ${new Array(64).fill(0).join(' ')}`,
+        `ctxt ${rnd.int(1e8, 1e9)}`,
+        `btime ${BOOT_TIME}`,
+        `processes ${summary.lastPid + 1000}`,
+        `procs_running ${summary.running}`,
+        'procs_blocked 0',
+        `softirq ${rnd.int(1e7, 1e8)} 0 0 0 0 0 0 0 0 0 0`
+    ].join('\n') + '\n');
+
+    const used = Math.min(summary.rss, Math.floor(MEMORY_KBYTES * 0.6));
+    const free = Math.floor((MEMORY_KBYTES - used) / 2);
+    const cached = MEMORY_KBYTES - used - free - 262144;
+    const kb = value => `${String(value).padStart(8)} kB`;
+    write(root, 'meminfo', [
+        `MemTotal:       ${kb(MEMORY_KBYTES)}`,
+        `MemFree:        ${kb(free)}`,
+        `MemAvailable:   ${kb(free + cached)}`,
+        `Buffers:        ${kb(262144)}`,
+        `Cached:         ${kb(cached)}`,
+        `SwapCached:     ${kb(0)}`,
+        `Active:         ${kb(Math.floor(used * 0.7))}`,
+        `Inactive:       ${kb(Math.floor(used * 0.3) + cached)}`,
+        `Shmem:          ${kb(65536)}`,
+        `Slab:           ${kb(524288)}`,
+        `SwapTotal:      ${kb(8 * 1024 * 1024)}`,
+        `SwapFree:       ${kb(8 * 1024 * 1024 - summary.swap)}`,
+        `Dirty:          ${kb(128)}`,
+        `Writeback:      ${kb(0)}`,
+        `AnonPages:      ${kb(summary.anon)}`,
+        `Mapped:         ${kb(Math.floor(used / 4))}`,
+        `PageTables:     ${kb(Math.floor(summary.threads / 4))}`,
+        `CommitLimit:    ${kb(MEMORY_KBYTES / 2 + 8 * 1024 * 1024)}`,
+        `Committed_AS:   ${kb(summary.vsize)}`,
+        `VmallocTotal:   ${kb(34359738367)}`,
+        `HugePages_Total:       0`,
+        `Hugepagesize:   ${kb(2048)}`
+    ].join('\n') + '\n');
+
+    write(root, 'loadavg', `0.52 0.58 0.59 ${summary.running}/${summary.threads} ${summary.lastPid}\n`);
+    write(root, 'uptime', '86400.00 600000.00\n');
+
+    fs.mkdirSync(path.join(root, 'pressure'));
+    for (const resource of ['cpu', 'memory', 'io']) {
+        write(path.join(root, 'pressure'), resource,
+            'some avg10=0.12 avg60=0.25 avg300=0.31 total=123456789\n' +
+            'full avg10=0.00 avg60=0.01 avg300=0.02 total=1234567\n');
+    }
+
+    fs.mkdirSync(path.join(root, 'net'));
+    write(path.join(root, 'net'), 'dev',
+        'Inter-|   Receive                                                |  Transmit\n' +
+        ' face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n' +
+        '    lo: 123456789  654321    0    0    0     0          0         0 123456789  654321    0    0    0     0       0          0\n' +
+        '  eth0: 987654321 1234567    0    2    0     0          0      1024 456789123  987654    0    0    0     0       0          0\n');
+}
+
+// Создает дерево и возвращает сводку: корневой каталог, количество процессов и потоков,
+// идентификаторы процессов с именем options.name
+function createFixture(dir, options) {
+    options = Object.assign({
+        processes: 1000, threads: 1, fds: 8, name: 'kserver', instances: 4, instanceThreads: 64, cpus: 8, seed: 1
+    }, options);
+
+    const root = path.resolve(dir);
+    fs.rmSync(root, { recursive: true, force: true });
+    fs.mkdirSync(root, { recursive: true });
+
+    const rnd = random(options.seed);
+    const cpusMask = (2 ** options.cpus - 1).toString(16);
+    const cpusList = 1 === options.cpus ? '0' : `0-${options.cpus - 1}`;
+    const summary = {
+        root, processes: 0, threads: 0, instances: [], lastPid: 0, running: 0, rss: 0, anon: 0, swap: 0, vsize: 0
+    };
+
+    // Процессы с искомым именем распределяются по всему списку, а не идут подряд
+    const instanceEvery = Math.max(1, Math.floor(options.processes / Math.max(1, options.instances)));
+    let nextPid = 1;
+    let kthreadd = 0;
+    for (let i = 0; i < options.processes; ++i) {
+        const pid = nextPid;
+        const kernel = 0 !== i && 1 !== i && 0 === i % 10;
+        const instance = summary.instances.length < options.instances && instanceEvery - 1 === i % instanceEvery;
+        const program = PROGRAMS[rnd.int(0, PROGRAMS.length - 1)];
+        let comm = kernel ? KERNEL_THREADS[rnd.int(0, KERNEL_THREADS.length - 1)] : program[0];
+        let exe = program[1];
+        let uid = program[2];
+        if (0 === i) [comm, exe, uid] = ['systemd', '/usr/lib/systemd/systemd', 0];
+        else if (1 === i) [comm, kthreadd] = ['kthreadd', pid];
+        else if (instance) [comm, exe, uid] = [options.name, `/opt/kodeks/bin/${options.name}`, 1000];
+        // Ядро хранит только первые 15 символов имени
+        comm = comm.slice(0, 15);
+
+        const isKernel = kernel || 1 === i;
+        const threads = isKernel ? 1 : (instance ? options.instanceThreads : options.threads);
+        const rss = isKernel ? 0 : rnd.int(256, 65536);
+        const task = {
+            pid, tgid: pid, ppid: 1 >= i ? 0 : (isKernel ? kthreadd : 1), comm, kernel: isKernel, uid,
+            state: 0 === rnd.int(0, 49) ? 'R' : 'S', threads, cpu: rnd.int(0, options.cpus - 1),
+            minflt: rnd.int(100, 1e6), majflt: rnd.int(0, 1000), utime: rnd.int(0, 1e6), stime: rnd.int(0, 1e5),
+            start: rnd.int(0, 86400 * CLOCK_TICKS), vsize: isKernel ? 0 : rnd.int(16384, 4194304) * PAGE_KBYTES,
+            rss, anon: Math.floor(rss * PAGE_KBYTES * 0.8), swap: isKernel ? 0 : rnd.int(0, 4) * 1024,
+            fds: isKernel ? 0 : rnd.int(3, options.fds * 2), cpusMask, cpusList,
+            cmdline: isKernel ? '' : `${exe}\0--config\0/etc/${comm}.conf\0`
+        };
+
+        const processDir = path.join(root, String(pid));
+        writeTask(processDir, task);
+        if (!isKernel) fs.symlinkSync(exe, path.join(processDir, 'exe'));
+
+        fs.mkdirSync(path.join(processDir, 'fd'));
+        for (let fd = 0; fd < task.fds; ++fd) {
+            const target = 3 > fd ? '/dev/null' : (0 === fd % 3 ? `socket:[${rnd.int(1e4, 1e7)}]` : `pipe:[${rnd.int(1e4, 1e7)}]`);
+            fs.symlinkSync(target, path.join(processDir, 'fd', String(fd)));
+        }
+
+        // Идентификаторы потоков выделяются из того же пространства, что и идентификаторы процессов
+        fs.mkdirSync(path.join(processDir, 'task'));
+        for (let t = 0; t < threads; ++t) {
+            const tid = pid + t;
+            writeTask(path.join(processDir, 'task', String(tid)), Object.assign({}, task, {
+                pid: tid, comm: 0 === t ? comm : `${comm.slice(0, 8)}-w${t}`.slice(0, 15),
+                utime: Math.floor(task.utime / threads), stime: Math.floor(task.stime / threads)
+            }));
+        }
+        nextPid += threads;
+
+        summary.processes++;
+        summary.threads += threads;
+        summary.lastPid = pid + threads - 1;
+        if ('R' === task.state) summary.running++;
+        if (instance) summary.instances.push(pid);
+        summary.rss += rss * PAGE_KBYTES;
+        summary.anon += task.anon;
+        summary.swap += task.swap;
+        summary.vsize += task.vsize;
+    }
+
+    writeSystem(root, options, summary, rnd);
+
+    return {
+        root, processes: summary.processes, threads: summary.threads, name: options.name, instances: summary.instances
+    };
+}
+
+module.exports = { createFixture };
+
+if (require.main === module) {
+    const dir = option('--dir', null);
+    if (null === dir) {
+        console.error('Usage: node bench/fixture.js --dir DIR [--processes N] [--threads N] [--fds N] ' +
+            '[--name NAME --instances N --instance-threads N] [--cpus N] [--seed N]');
+        process.exit(1);
+    }
+
+    const start = Date.now();
+    const fixture = createFixture(dir, {
+        processes: Number(option('--processes', 1000)),
+        threads: Number(option('--threads', 1)),
+        fds: Number(option('--fds', 8)),
+        name: option('--name', 'kserver'),
+        instances: Number(option('--instances', 4)),
+        instanceThreads: Number(option('--instance-threads', 64)),
+        cpus: Number(option('--cpus', 8)),
+        seed: Number(option('--seed', 1))
+    });
+    fixture.seconds = (Date.now() - start) / 1000;
+    console.log(JSON.stringify(Object.assign({}, fixture, {
+        instances: fixture.instances.length > 16 ? fixture.instances.slice(0, 16).concat('...') : fixture.instances
+    }), null, 2));
+}
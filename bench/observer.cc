@@ -0,0 +1,505 @@
+/// @file
+/// Замер стоимости опроса наблюдателей без Node.JS: задержка вызова (перцентили), количество
+/// выделений памяти и системных вызовов на вызов. Результат выводится в JSON, чтобы его можно
+/// было сохранить и сравнить с результатом другой версии модуля.
+///
+/// Использование: testtools-bench [--iterations N] [--list-iterations N] [--warmup N] [--pid PID] [--name NAME]
+///                                [--proc-root DIR]
+///   --iterations N       количество вызовов Poll каждого наблюдателя (по умолчанию 1000)
+///   --list-iterations N  количество вызовов GetProcessList (по умолчанию 50)
+///   --warmup N           количество вызовов перед замером (по умолчанию 10)
+///   --pid PID            процесс для ProcessIdObserver (по умолчанию - сам замер или первый процесс с именем NAME)
+///   --name NAME          имя процессов для ProcessNameObserver (по умолчанию - имя процесса PID)
+///   --proc-root DIR      корневой каталог procfs, например - синтетическое дерево bench/fixture.js (только Linux)
+///   --help               вывести эту справку и завершиться
+///
+/// Выделения памяти считаются заменой глобальных operator new и operator delete, поэтому
+/// выделения через malloc внутри библиотек ОС (например, opendir) не учитываются.
+/// Системные вызовы (только Linux) считает ядро: все вызовы - по точке трассировки
+/// raw_syscalls:sys_enter (нужны tracefs и права на perf_event_open, иначе @b null),
+/// вызовы чтения и записи - по /proc/self/io (syscr, syscw). Учитываются и вызовы
+/// рабочих потоков GetProcessList.
+
+#include "../src/processobserver.h"
+#include "../src/systemobserver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(TESTTOOLS_LINUX)
+#include <linux/perf_event.h> // perf_event_attr
+#include <sys/syscall.h> // SYS_perf_event_open
+#endif
+
+/// Счетчики выделений памяти (заменяют глобальные operator new и operator delete)
+namespace
+{
+
+/// Количество выделений памяти
+std::atomic<uint64_t> allocations(0);
+/// Количество выделенных байт
+std::atomic<uint64_t> allocatedBytes(0);
+
+/// Выделяет память и учитывает выделение
+/// @throw std::bad_alloc
+inline void* Allocate(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(0 == size ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace testtools
+{
+
+/// Функции-помощники замера
+namespace
+{
+
+/// Количество системных вызовов
+struct SyscallCounts
+{
+    double total;   ///< Все системные вызовы (отрицательное значение - неизвестно)
+    double reads;   ///< Вызовы чтения (read, pread, readv)
+    double writes;  ///< Вызовы записи (write, pwrite, writev)
+};
+
+/// Счетчик системных вызовов процесса.
+/// Чтение счетчика само выполняет системные вызовы, поэтому их количество
+/// измеряется при создании объекта и вычитается из результата замера.
+class SyscallCounter final
+{
+public:
+    SyscallCounter() noexcept
+        : overhead_()
+#if defined(TESTTOOLS_LINUX)
+        , io_(::open("/proc/self/io", O_RDONLY | O_CLOEXEC))
+        , perf_(OpenTracepoint())
+#endif
+    {
+        SyscallCounts before = {};
+        SyscallCounts after = {};
+        if (!Read(before) || !Read(after)) return;
+        overhead_ = Difference(before, after);
+    }
+
+    SyscallCounter(const SyscallCounter&) = delete;
+    SyscallCounter& operator=(const SyscallCounter&) = delete;
+
+    ~SyscallCounter()
+    {
+#if defined(TESTTOOLS_LINUX)
+        if (-1 != io_) ::close(io_);
+        if (-1 != perf_) ::close(perf_);
+#endif
+    }
+
+    /// Проверяет, доступен ли подсчет всех системных вызовов
+    inline bool HasTotal() const noexcept
+    {
+#if defined(TESTTOOLS_LINUX)
+        return -1 != perf_;
+#else
+        return false;
+#endif
+    }
+
+    /// Считывает количество системных вызовов с начала работы процесса
+    /// @param[out] counts Количество вызовов
+    /// @return @b false, если подсчет недоступен
+    bool Read(SyscallCounts& counts) const noexcept
+    {
+        counts = { -1., -1., -1. };
+#if defined(TESTTOOLS_LINUX)
+        if (-1 == io_) return false;
+
+        uint64_t total = 0;
+        if (-1 != perf_ && sizeof(total) == ::read(perf_, &total, sizeof(total)))
+            counts.total = static_cast<double>(total);
+
+        procfs::Buffer<512> buffer = { '\0' };
+        const ssize_t size = ::pread(io_, buffer.data(), buffer.size() - 1, 0);
+        if (0 >= size) return false;
+        buffer[static_cast<size_t>(size)] = '\0';
+
+        const char* syscr = std::strstr(buffer.data(), "syscr: ");
+        const char* syscw = std::strstr(buffer.data(), "syscw: ");
+        if (nullptr == syscr || nullptr == syscw) return false;
+        counts.reads = std::strtod(syscr + 7, nullptr);
+        counts.writes = std::strtod(syscw + 7, nullptr);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Возвращает количество системных вызовов между двумя чтениями счетчика без учета самих чтений
+    /// @param[in] before Результат чтения до замера
+    /// @param[in] after Результат чтения после замера
+    /// @return Количество вызовов (отрицательное значение - неизвестно)
+    SyscallCounts Difference(const SyscallCounts& before, const SyscallCounts& after) const noexcept
+    {
+        auto diff = [](double from, double to, double overhead) {
+            return 0. > from || 0. > to ? -1. : std::max(0., to - from - overhead);
+        };
+        return {
+            diff(before.total, after.total, overhead_.total),
+            diff(before.reads, after.reads, overhead_.reads),
+            diff(before.writes, after.writes, overhead_.writes)
+        };
+    }
+
+private:
+#if defined(TESTTOOLS_LINUX)
+    /// Открывает счетчик perf по точке трассировки входа в системный вызов.
+    /// Счетчик наследуется потоками, созданными после его открытия.
+    /// @return Дескриптор счетчика или @b -1, если tracefs или perf_event_open недоступны
+    static int OpenTracepoint() noexcept
+    {
+        const char* const paths[] = {
+            "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+            "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"
+        };
+
+        uint64_t id = 0;
+        for (const char* path : paths) {
+            procfs::File file;
+            procfs::Buffer<32> buffer = { '\0' };
+            if (file.Open(path) && 0 < file.Read(buffer)) {
+                procfs::ParseUInt(buffer.data(), id);
+                break;
+            }
+        }
+        if (0 == id) return -1;
+
+        struct perf_event_attr attr = {};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = id;
+        attr.inherit = 1;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+#endif
+
+    /// Системные вызовы, выполняемые чтением счетчика
+    SyscallCounts overhead_;
+#if defined(TESTTOOLS_LINUX)
+    /// Дескриптор /proc/self/io
+    int io_;
+    /// Дескриптор счетчика perf
+    int perf_;
+#endif
+}; // class SyscallCounter
+
+/// Параметры замера
+struct Options
+{
+    size_t iterations;      ///< Количество вызовов Poll
+    size_t listIterations;  ///< Количество вызовов GetProcessList
+    size_t warmup;          ///< Количество вызовов перед замером
+    uint32_t pid;           ///< Процесс для ProcessIdObserver
+    std::string name;       ///< Имя процессов для ProcessNameObserver
+};
+
+/// Результат замера одной функции
+struct Result
+{
+    std::string name;               ///< Название функции
+    std::string error;              ///< Текст ошибки, если замер не выполнен
+    size_t calls;                   ///< Количество вызовов
+    std::vector<double> latencies;  ///< Длительность вызовов в микросекундах (по возрастанию)
+    double allocations;             ///< Выделений памяти на вызов
+    double allocatedBytes;          ///< Выделенных байт на вызов
+    SyscallCounts syscalls;         ///< Системных вызовов на вызов
+    double items;                   ///< Количество элементов результата последнего вызова
+};
+
+/// Возвращает значение перцентиля
+/// @param[in] sorted Значения, упорядоченные по возрастанию
+/// @param[in] p Перцентиль (от 0 до 1)
+inline double Percentile(const std::vector<double>& sorted, double p) noexcept
+{
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(static_cast<double>(sorted.size()) * p))];
+}
+
+/// Справка по параметрам командной строки (--help)
+const char* const kUsage =
+    "Usage: testtools-bench [--iterations N] [--list-iterations N] [--warmup N] [--pid PID] [--name NAME]\n"
+    "                       [--proc-root DIR]\n"
+    "  --iterations N       Poll calls per observer (default 1000)\n"
+    "  --list-iterations N  GetProcessList calls (default 50)\n"
+    "  --warmup N           calls before measuring (default 10)\n"
+    "  --pid PID            process for ProcessIdObserver (default - the benchmark itself\n"
+    "                       or the first process named NAME)\n"
+    "  --name NAME          process name for ProcessNameObserver (default - name of PID)\n"
+    "  --proc-root DIR      procfs root, e.g. a synthetic tree from bench/fixture.js (Linux only)\n"
+    "  --help               print this help and exit\n";
+
+/// Проверяет наличие флага в командной строке
+/// @param[in] argc Количество параметров
+/// @param[in] argv Параметры
+/// @param[in] name Имя флага
+bool HasFlag(int argc, char** argv, const char* name) noexcept
+{
+    for (int i = 1; i < argc; ++i) {
+        if (0 == std::strcmp(argv[i], name)) return true;
+    }
+    return false;
+}
+
+/// Возвращает значение параметра командной строки
+/// @param[in] argc Количество параметров
+/// @param[in] argv Параметры
+/// @param[in] name Имя параметра
+/// @param[in] fallback Значение по умолчанию
+const char* GetOption(int argc, char** argv, const char* name, const char* fallback) noexcept
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (0 == std::strcmp(argv[i], name)) return argv[i + 1];
+    }
+    return fallback;
+}
+
+/// Возвращает идентификатор процесса замера
+inline uint32_t GetCurrentPid() noexcept
+{
+#if defined(TESTTOOLS_WIN)
+    return static_cast<uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(::getpid());
+#endif
+}
+
+/// Возвращает имя процесса в том виде, в котором его сравнивает ProcessNameObserver
+/// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+/// @param[in] pid Идентификатор процесса
+std::string GetProcessName(uint32_t pid)
+{
+    for (const AbstractObserver::ProcessEntry& entry : AbstractObserver::GetProcessSnapshot()) {
+        if (pid == entry.pid) return entry.name;
+    }
+    throw AbstractObserver::Exception("Process not found.");
+}
+
+/// Возвращает идентификатор первого процесса с указанным именем
+/// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+/// @param[in] name Имя процесса (пустая строка - любой процесс)
+uint32_t GetProcessId(const std::string& name)
+{
+    for (const AbstractObserver::ProcessEntry& entry : AbstractObserver::GetProcessSnapshot()) {
+        if (name.empty() || name == entry.name) return entry.pid;
+    }
+    throw AbstractObserver::Exception("Process not found.");
+}
+
+/// Замеряет функцию: сначала прогрев, затем замер каждого вызова; выделения памяти и
+/// системные вызовы подсчитываются за все вызовы замера и делятся на их количество
+/// @param[in] name Название функции
+/// @param[in] calls Количество вызовов
+/// @param[in] warmup Количество вызовов перед замером
+/// @param[in] counter Счетчик системных вызовов
+/// @param[in] fn Функция (возвращает количество элементов результата)
+Result Measure(const char* name, size_t calls, size_t warmup, const SyscallCounter& counter,
+    const std::function<size_t()>& fn)
+{
+    Result result = { name, std::string(), calls, {}, 0., 0., { -1., -1., -1. }, 0. };
+    result.latencies.reserve(calls);
+    try {
+        for (size_t i = 0; i < warmup; ++i) fn();
+
+        SyscallCounts before = {};
+        SyscallCounts after = {};
+        counter.Read(before);
+        const uint64_t allocated = allocations.load(std::memory_order_relaxed);
+        const uint64_t bytes = allocatedBytes.load(std::memory_order_relaxed);
+
+        // Результаты замера выделены заранее, поэтому в цикле выделяет память только fn
+        size_t items = 0;
+        for (size_t i = 0; i < calls; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            items = fn();
+            const auto end = std::chrono::steady_clock::now();
+            result.latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        const double count = static_cast<double>(calls);
+        result.allocations = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocated) / count;
+        result.allocatedBytes = static_cast<double>(allocatedBytes.load(std::memory_order_relaxed) - bytes) / count;
+        counter.Read(after);
+        result.syscalls = counter.Difference(before, after);
+        if (0. <= result.syscalls.total) result.syscalls.total /= count;
+        if (0. <= result.syscalls.reads) result.syscalls.reads /= count;
+        if (0. <= result.syscalls.writes) result.syscalls.writes /= count;
+        result.items = static_cast<double>(items);
+
+        std::sort(result.latencies.begin(), result.latencies.end());
+    }
+    catch (const std::exception& e) {
+        result.error = e.what();
+        result.latencies.clear();
+    }
+
+    return result;
+}
+
+/// Возвращает строку в формате JSON
+std::string Quote(const std::string& value)
+{
+    std::string quoted = "\"";
+    for (const char c : value) {
+        if ('"' == c || '\\' == c) {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (0x20 > static_cast<unsigned char>(c)) {
+            char escaped[8] = { '\0' };
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            quoted += escaped;
+        }
+        else {
+            quoted += c;
+        }
+    }
+    return quoted + '"';
+}
+
+/// Возвращает число в формате JSON (отрицательное значение - неизвестно, @b null)
+std::string Number(double value)
+{
+    if (0. > value) return "null";
+    char buffer[32] = { '\0' };
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    return buffer;
+}
+
+/// Выводит результаты замера в формате JSON
+void Print(const Options& options, const SyscallCounter& counter, const std::vector<Result>& results)
+{
+#if defined(TESTTOOLS_WIN)
+    const char* const platform = "win32";
+#else
+    const char* const platform = "linux";
+#endif
+
+    std::printf("{\n");
+    std::printf("  \"platform\": \"%s\",\n", platform);
+#if defined(TESTTOOLS_LINUX)
+    std::printf("  \"procRoot\": %s,\n", Quote(procfs::GetRoot()).data());
+#endif
+    std::printf("  \"pid\": %u,\n", options.pid);
+    std::printf("  \"name\": %s,\n", Quote(options.name).data());
+    std::printf("  \"syscallTotals\": %s,\n", counter.HasTotal() ? "true" : "false");
+    std::printf("  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::printf("    {\n");
+        std::printf("      \"name\": %s,\n", Quote(result.name).data());
+        if (!result.error.empty()) {
+            std::printf("      \"error\": %s\n", Quote(result.error).data());
+        }
+        else {
+            const std::vector<double>& sorted = result.latencies;
+            double sum = 0.;
+            for (const double latency : sorted) sum += latency;
+
+            std::printf("      \"calls\": %zu,\n", result.calls);
+            std::printf("      \"items\": %s,\n", Number(result.items).data());
+            std::printf("      \"latencyUs\": { \"min\": %s, \"p50\": %s, \"p90\": %s, \"p99\": %s, \"max\": %s, \"mean\": %s },\n",
+                Number(sorted.front()).data(), Number(Percentile(sorted, 0.5)).data(), Number(Percentile(sorted, 0.9)).data(),
+                Number(Percentile(sorted, 0.99)).data(), Number(sorted.back()).data(),
+                Number(sum / static_cast<double>(sorted.size())).data());
+            std::printf("      \"allocationsPerCall\": %s,\n", Number(result.allocations).data());
+            std::printf("      \"allocatedBytesPerCall\": %s,\n", Number(result.allocatedBytes).data());
+            std::printf("      \"syscallsPerCall\": { \"total\": %s, \"reads\": %s, \"writes\": %s }\n",
+                Number(result.syscalls.total).data(), Number(result.syscalls.reads).data(),
+                Number(result.syscalls.writes).data());
+        }
+        std::printf("    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+} // namespace
+
+} // namespace testtools
+
+int main(int argc, char** argv)
+{
+    using namespace testtools;
+
+    if (HasFlag(argc, argv, "--help") || HasFlag(argc, argv, "-h")) {
+        std::fputs(kUsage, stdout);
+        return 0;
+    }
+
+    try {
+        Options options = {};
+        options.iterations = std::max<size_t>(1, std::strtoul(GetOption(argc, argv, "--iterations", "1000"), nullptr, 10));
+        options.listIterations = std::max<size_t>(1, std::strtoul(GetOption(argc, argv, "--list-iterations", "50"), nullptr, 10));
+        options.warmup = std::strtoul(GetOption(argc, argv, "--warmup", "10"), nullptr, 10);
+
+        // В синтетическом дереве procfs процесса замера нет - наблюдаем процесс из дерева
+        bool systemRoot = true;
+#if defined(TESTTOOLS_LINUX)
+        procfs::SetRoot(GetOption(argc, argv, "--proc-root", ""));
+        systemRoot = procfs::IsSystemRoot();
+#endif
+        options.pid = static_cast<uint32_t>(std::strtoul(GetOption(argc, argv, "--pid", "0"), nullptr, 10));
+        options.name = GetOption(argc, argv, "--name", "");
+        if (0 == options.pid) options.pid = systemRoot && options.name.empty() ? GetCurrentPid() : GetProcessId(options.name);
+        if (options.name.empty()) options.name = GetProcessName(options.pid);
+
+        // Счетчик открывается до создания наблюдателей и рабочих потоков, чтобы они его унаследовали
+        const SyscallCounter counter;
+        std::vector<Result> results = {};
+
+        const AbstractObserver::Mask systemMask = 0x3FFF;
+        const AbstractObserver::Mask processMask = 0x7F;
+
+        SystemObserver system;
+        results.push_back(Measure("SystemObserver::Poll", options.iterations, options.warmup, counter, [&]() {
+            return static_cast<size_t>(system.Poll(systemMask).mask != 0);
+        }));
+
+        ProcessIdObserver process(options.pid);
+        results.push_back(Measure("ProcessIdObserver::Poll", options.iterations, options.warmup, counter, [&]() {
+            return static_cast<size_t>(process.Poll(processMask).mask != 0);
+        }));
+
+        ProcessNameObserver processes(options.name);
+        results.push_back(Measure("ProcessNameObserver::Poll", options.iterations, options.warmup, counter, [&]() {
+            return processes.Poll(processMask).size();
+        }));
+
+        results.push_back(Measure("GetProcessList", options.listIterations, std::min<size_t>(options.warmup, 3), counter, []() {
+            return AbstractObserver::GetProcessList().size();
+        }));
+
+        Print(options, counter, results);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
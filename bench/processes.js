@@ -0,0 +1,68 @@
+'use strict';
+
+// Замер стоимости передачи списка процессов из модуля в JS (Observer.processes()).
+//
+// Время основного потока оценивается по утилизации цикла событий (Node.JS 14.10 и выше):
+// пока список процессов собирается в пуле потоков, основной поток простаивает, поэтому
+// активное время цикла событий - это время создания JS объектов в HandleOKCallback.
+//
+// Использование: node bench/processes.js [--iterations N] [--spawn N] [--proc-root DIR]
+//   --iterations N  количество вызовов Observer.processes() (по умолчанию 50)
+//   --spawn N       дополнительно запустить N простаивающих процессов (только Linux),
+//                   чтобы оценить стоимость на списках из тысяч процессов
+//   --proc-root DIR читать синтетическое дерево procfs (bench/fixture.js) вместо /proc (только Linux)
+
+const { spawn } = require('child_process');
+const { performance } = require('perf_hooks');
+
+const Observer = require('../lib/observer.js');
+
+function option(name, fallback) {
+    const index = process.argv.indexOf(name);
+    return -1 === index ? fallback : Number(process.argv[index + 1]);
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+async function main() {
+    const iterations = option('--iterations', 50);
+    const index = process.argv.indexOf('--proc-root');
+    if (-1 !== index) Observer.setProcRoot(process.argv[index + 1]);
+    const children = [];
+    for (let i = 0; i < option('--spawn', 0); ++i)
+        children.push(spawn('sleep', ['600'], { stdio: 'ignore' }));
+
+    try {
+        // Прогрев: первые вызовы включают компиляцию JS и заполнение кэшей модуля
+        for (let i = 0; i < 3; ++i) await Observer.processes();
+
+        const wall = [];
+        const busy = [];
+        let count = 0;
+        for (let i = 0; i < iterations; ++i) {
+            const elu = performance.eventLoopUtilization();
+            const start = performance.now();
+            const list = await Observer.processes();
+            wall.push(performance.now() - start);
+            busy.push(performance.eventLoopUtilization(elu).active);
+            count = list.length;
+        }
+
+        wall.sort((a, b) => a - b);
+        busy.sort((a, b) => a - b);
+        console.log(JSON.stringify({
+            processes: count,
+            iterations,
+            wall: { p50: percentile(wall, 0.5), p99: percentile(wall, 0.99) },
+            mainThread: { p50: percentile(busy, 0.5), p99: percentile(busy, 0.99) },
+            mainThreadPerProcessUs: percentile(busy, 0.5) * 1000 / count
+        }, null, 2));
+    }
+    finally {
+        children.forEach(child => child.kill());
+    }
+}
+
+main().catch(error => { console.error(error); process.exit(1); });
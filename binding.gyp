@@ -5,10 +5,24 @@
 
             "sources": [
                 "src/abstractobserver.h",
+                "src/cgroupobserver.h",
                 "src/processobserver.h",
+                "src/ringbuffer.h",
+                "src/sampler.h",
+                "src/sampler.cc",
+                "src/livepublisher.h",
+                "src/livepublisher.cc",
+                "src/livesegment.h",
+                "src/samplefile.h",
+                "src/samplefile.cc",
+                "src/history.h",
+                "src/history.cc",
+                "src/summary.h",
+                "src/summary.cc",
                 "src/systemobserver.h",
                 "src/observer.cc",
                 "src/observer.h",
+                "src/pressuretrigger.h",
             ],
 
             "cflags_cc!": [
@@ -17,7 +31,7 @@
 
             "cflags_cc+": [
                 "-fexceptions",
-                "-std=c++11"
+                "-std=c++14"
             ],
 
             "include_dirs": [
@@ -33,7 +47,11 @@
 
                         "sources": [
                             "src/abstractobserver_win.cc",
+                            "src/cgroupobserver_win.cc",
+                            "src/livepublisher_win.cc",
+                            "src/pressuretrigger_win.cc",
                             "src/processobserver_win.cc",
+                            "src/samplefile_win.cc",
                             "src/systemobserver_win.cc"
                         ],
 
@@ -49,23 +67,164 @@
                 ["OS == 'linux'",
                     {
                         "cflags_cc+": [
+                            "-pthread",
                             "-Wno-missing-field-initializers",
                             "-Wno-missing-braces",
                             "-Wno-unused-result"
                         ],
 
+                        "ldflags": [
+                            "-pthread"
+                        ],
+
+                        # shm_open и shm_unlink до glibc 2.34 находятся в librt
+                        "libraries": [
+                            "-lrt"
+                        ],
+
+                        "defines": [
+                            "TESTTOOLS_LINUX"
+                        ],
+
+                        "sources": [
+                            "src/abstractobserver_linux.cc",
+                            "src/cgroup.h",
+                            "src/cgroup_linux.cc",
+                            "src/cgroupobserver_linux.cc",
+                            "src/livepublisher_linux.cc",
+                            "src/pressuretrigger_linux.cc",
+                            "src/processobserver_linux.cc",
+                            "src/processtable.h",
+                            "src/processtable_linux.cc",
+                            "src/samplefile_linux.cc",
+                            "src/systemobserver_linux.cc"
+                        ]
+                    }
+                 ]
+            ]
+        },
+
+        # Замер стоимости опроса наблюдателей без Node.JS (bench/observer.cc)
+        {
+            "target_name": "testtools-bench",
+            "type": "executable",
+
+            "sources": [
+                "bench/observer.cc",
+                "src/abstractobserver.h",
+                "src/processobserver.h",
+                "src/systemobserver.h",
+                "src/history.h",
+                "src/history.cc",
+                "src/summary.h",
+                "src/summary.cc"
+            ],
+
+            "cflags_cc!": [
+                "-fno-exceptions"
+            ],
+
+            "cflags_cc+": [
+                "-fexceptions",
+                "-std=c++14"
+            ],
+
+            "conditions": [
+                ["OS == 'win'",
+                    {
+                        "defines": [
+                            "TESTTOOLS_WIN"
+                        ],
+
+                        "sources": [
+                            "src/abstractobserver_win.cc",
+                            "src/processobserver_win.cc",
+                            "src/systemobserver_win.cc"
+                        ],
+
+                        "msvs_settings": {
+                            "VCCLCompilerTool": {
+                                "WarningLevel": 3,
+                                "ExceptionHandling": 2  # /EHsc
+                            },
+                        }
+                    }
+                 ],
+
+                ["OS == 'linux'",
+                    {
+                        "cflags_cc+": [
+                            "-pthread",
+                            "-Wno-missing-field-initializers",
+                            "-Wno-missing-braces",
+                            "-Wno-unused-result"
+                        ],
+
+                        "ldflags": [
+                            "-pthread"
+                        ],
+
                         "defines": [
                             "TESTTOOLS_LINUX"
                         ],
 
                         "sources": [
                             "src/abstractobserver_linux.cc",
+                            "src/cgroup.h",
+                            "src/cgroup_linux.cc",
                             "src/processobserver_linux.cc",
+                            "src/processtable.h",
+                            "src/processtable_linux.cc",
                             "src/systemobserver_linux.cc"
                         ]
                     }
                  ]
             ]
         }
+    ],
+
+    "conditions": [
+        ["OS == 'linux'",
+            {
+                "targets": [
+                    # Проверка чтения таблиц procfs больше страницы (check/procfs.cc)
+                    {
+                        "target_name": "testtools-procfs-check",
+                        "type": "executable",
+
+                        "sources": [
+                            "check/procfs.cc",
+                            "src/abstractobserver.h",
+                            "src/abstractobserver_linux.cc",
+                            "src/history.h",
+                            "src/history.cc",
+                            "src/summary.h",
+                            "src/summary.cc"
+                        ],
+
+                        "cflags_cc!": [
+                            "-fno-exceptions"
+                        ],
+
+                        "cflags_cc+": [
+                            "-fexceptions",
+                            "-std=c++14",
+                            "-pthread",
+                            "-Wno-missing-field-initializers",
+                            "-Wno-missing-braces",
+                            "-Wno-unused-result"
+                        ],
+
+                        "ldflags": [
+                            "-pthread"
+                        ],
+
+                        "defines": [
+                            "TESTTOOLS_LINUX"
+                        ]
+                    }
+                ]
+            }
+        ]
     ]
 }
@@ -0,0 +1,128 @@
+/// @file
+/// Проверка чтения таблиц procfs целиком (procfs::File::Read с буфером std::vector).
+///
+/// Таблицы procfs (seq_file: /proc/net/dev, /proc/diskstats, /proc/self/mountinfo) ядро отдает
+/// не больше страницы записей за один вызов, поэтому однократный pread молча теряет записи,
+/// не поместившиеся в первую страницу. Проверка сравнивает результат procfs::File::Read
+/// с последовательным чтением read до конца файла. Таблица /proc/self/maps заранее
+/// увеличивается до нескольких страниц, чтобы проверка не зависела от количества
+/// сетевых интерфейсов и дисков хоста.
+///
+/// Использование: testtools-procfs-check
+/// Код завершения: 0 - все таблицы прочитаны целиком, 1 - есть расхождения.
+
+#include "../src/abstractobserver.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h> // mmap, mprotect
+
+/// Функции-помощники проверки
+namespace
+{
+
+/// Количество отдельных отображений памяти, добавляемых в /proc/self/maps
+const size_t kMappings = 1024;
+/// Минимальный размер буфера последовательного чтения
+const size_t kSequentialBufferSize = 1024 * 1024;
+
+/// Создает отображения памяти с чередующимися правами доступа: каждое из них - отдельная строка
+/// /proc/self/maps (около 70 байт), поэтому таблица занимает несколько страниц
+/// @return @b true в случае успеха, иначе - @b false
+bool GrowMaps() noexcept
+{
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    void* memory = ::mmap(nullptr, page * kMappings * 2, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == memory) return false;
+
+    char* p = static_cast<char*>(memory);
+    for (size_t i = 0; i < kMappings; ++i) {
+        if (0 != ::mprotect(p + i * 2 * page, page, PROT_NONE)) return false;
+    }
+
+    return true;
+}
+
+/// Считывает файл последовательными вызовами read до конца файла
+/// @param[in] path Путь к файлу
+/// @param[in,out] content Буфер, выделенный заранее, чтобы чтение не изменяло /proc/self/maps;
+/// после чтения - содержимое файла
+/// @return @b true в случае успеха, иначе - @b false (в том числе, если файл не поместился в буфер)
+bool ReadSequential(const char* path, std::string& content)
+{
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return false;
+
+    size_t length = 0;
+    ssize_t size = 0;
+    while (length < content.size() && 0 < (size = ::read(fd, &content[length], content.size() - length)))
+        length += static_cast<size_t>(size);
+    ::close(fd);
+
+    if (0 != size) return false;
+    content.resize(length);
+    return true;
+}
+
+/// Сравнивает чтение procfs::File::Read с последовательным чтением файла
+/// @param[in] path Путь к файлу
+/// @param[in] exact Требовать побайтного совпадения (иначе - совпадения количества строк)
+/// @param[in] minimum Минимальный размер файла, при котором проверка имеет смысл
+/// @return @b true, если содержимое совпадает
+bool Check(const char* path, bool exact, size_t minimum)
+{
+    testtools::procfs::File file;
+    if (!file.Open(path)) {
+        std::printf("skip %s (not available)\n", path);
+        return true;
+    }
+
+    // Первое чтение увеличивает буфер до нужного размера, повторное уже не выделяет память
+    std::vector<char> buffer;
+    if (-1 == file.Read(buffer)) return false;
+
+    std::string expected(std::max<size_t>(buffer.size() * 2, kSequentialBufferSize), '\0');
+    if (!ReadSequential(path, expected)) {
+        std::fprintf(stderr, "fail %s: sequential read error\n", path);
+        return false;
+    }
+
+    const ssize_t length = file.Read(buffer);
+    if (-1 == length) {
+        std::fprintf(stderr, "fail %s: File::Read error\n", path);
+        return false;
+    }
+
+    const std::string actual(buffer.data(), static_cast<size_t>(length));
+    const bool equal = exact ? actual == expected
+        : std::count(actual.begin(), actual.end(), '\n') == std::count(expected.begin(), expected.end(), '\n');
+    if (!equal || actual.size() < minimum) {
+        std::fprintf(stderr, "fail %s: File::Read %zu bytes, read %zu bytes (at least %zu expected)\n",
+            path, actual.size(), expected.size(), minimum);
+        return false;
+    }
+
+    std::printf("ok %s (%zu bytes)\n", path, actual.size());
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    if (!GrowMaps()) {
+        std::fprintf(stderr, "fail: unable to create memory mappings\n");
+        return 1;
+    }
+
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    bool passed = Check("/proc/self/maps", true, page * 4);
+    passed = Check("/proc/self/mountinfo", false, 0) && passed;
+    passed = Check("/proc/net/dev", false, 0) && passed;
+    passed = Check("/proc/diskstats", false, 0) && passed;
+
+    return passed ? 0 : 1;
+}
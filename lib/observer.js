@@ -6,6 +6,7 @@ const Observer = require('bindings')('testtools-observer');
 Object.defineProperty(Observer, 'System', { configurable: false, enumerable: true, value: 0 });
 Object.defineProperty(Observer, 'ProcessId', { configurable: false, enumerable: true, value: 1 });
 Object.defineProperty(Observer, 'ProcessName', { configurable: false, enumerable: true, value: 2 });
+Object.defineProperty(Observer, 'CGroup', { configurable: false, enumerable: true, value: 3 });
 
 Observer.prototype.type = function type() { return this._type(); }
 Observer.prototype.object = function object() { return this._object(); }
@@ -21,6 +22,236 @@ Observer.prototype.poll = function poll(mask) {
     });
 }
 
+Object.defineProperty(Observer, 'STRIDE', { configurable: false, enumerable: true, value: 15 });
+
+Observer.prototype.pollInto = function pollInto(mask, target) {
+    return new Promise((resolve, reject) => {
+        if ('number' !== typeof mask)
+            return reject(new Error('Observer#pollInto - "mask" is not a number.'));
+        if (!(target instanceof Float64Array))
+            return reject(new Error('Observer#pollInto - "target" is not a Float64Array.'));
+
+        this._pollInto(mask, target, (error, count) => {
+            error === null ? resolve(count) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.pollThreads = function pollThreads(top) {
+    return new Promise((resolve, reject) => {
+        if (undefined !== top && ('number' !== typeof top || top < 0))
+            return reject(new Error('Observer#pollThreads - "top" is not a non-negative number.'));
+
+        this._pollThreads(undefined === top ? 0 : Math.floor(top), (error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.pollCores = function pollCores() {
+    return new Promise((resolve, reject) => {
+        this._pollCores((error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.pollDisks = function pollDisks(filter) {
+    return new Promise((resolve, reject) => {
+        // Фильтр - RegExp или строка с регулярным выражением; без фильтра - только физические диски
+        let pattern = '';
+        let ignoreCase = false;
+        if (filter instanceof RegExp) {
+            pattern = filter.source;
+            ignoreCase = filter.ignoreCase;
+        }
+        else if ('string' === typeof filter) {
+            pattern = filter;
+        }
+        else if (undefined !== filter) {
+            return reject(new Error('Observer#pollDisks - "filter" is not a RegExp or string.'));
+        }
+
+        this._pollDisks(pattern, ignoreCase, (error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.pollNetwork = function pollNetwork() {
+    return new Promise((resolve, reject) => {
+        this._pollNetwork((error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.pollPressure = function pollPressure() {
+    return new Promise((resolve, reject) => {
+        this._pollPressure((error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+// Окна статистики по умолчанию: 1 минута, 5 минут и 1 час (в миллисекундах)
+const SUMMARY_WINDOWS = [60000, 300000, 3600000];
+
+Observer.prototype.enableSummary = function enableSummary(windows) {
+    windows = undefined === windows ? SUMMARY_WINDOWS : windows;
+    if (!Array.isArray(windows) || windows.some(window => 'number' !== typeof window || !(window > 0)))
+        throw new Error('Observer#enableSummary - "windows" must be an array of positive numbers.');
+
+    this._summarize(windows);
+}
+
+Observer.prototype.disableSummary = function disableSummary() { this._summarize([]); }
+
+// Счетчик задается битом маски или ключом из Observer.masks() (например - 'procusage')
+function resolveCounter(observer, counter, method) {
+    if ('string' === typeof counter) {
+        const masks = Observer.masks();
+        const list = [masks.system, masks.process, masks.process, masks.cgroup][observer.type()];
+        const item = list.find(item => item.key === counter);
+        if (!item)
+            throw new Error(`Observer#${method} - unknown counter "${counter}".`);
+        counter = item.mask;
+    }
+    if ('number' !== typeof counter)
+        throw new Error(`Observer#${method} - "counter" is not a number or string.`);
+
+    return counter;
+}
+
+Observer.prototype.summary = function summary(counter, window) {
+    counter = resolveCounter(this, counter, 'summary');
+    return this._summary(counter, undefined === window ? SUMMARY_WINDOWS[0] : window);
+}
+
+// Срок хранения истории по умолчанию: 7 дней (в миллисекундах)
+const HISTORY_RETENTION = 7 * 24 * 3600 * 1000;
+
+Observer.prototype.enableHistory = function enableHistory(retention) {
+    retention = undefined === retention ? HISTORY_RETENTION : retention;
+    if ('number' !== typeof retention || !(retention > 0))
+        throw new Error('Observer#enableHistory - "retention" must be a positive number.');
+
+    this._historyConfigure(retention);
+}
+
+Observer.prototype.disableHistory = function disableHistory() { this._historyConfigure(0); }
+
+Observer.prototype.history = function history(counter, from, to, buckets) {
+    return new Promise((resolve, reject) => {
+        try {
+            counter = resolveCounter(this, counter, 'history');
+        }
+        catch (error) {
+            return reject(error);
+        }
+
+        // Время задается числом миллисекунд или объектом Date; по умолчанию - вся история
+        from = from instanceof Date ? from.getTime() : (undefined === from ? 0 : from);
+        to = to instanceof Date ? to.getTime() : (undefined === to ? Date.now() : to);
+        buckets = undefined === buckets ? 0 : buckets;
+        if ('number' !== typeof from || 'number' !== typeof to)
+            return reject(new Error('Observer#history - "from" and "to" must be numbers or dates.'));
+        if (!Number.isInteger(buckets) || buckets < 0)
+            return reject(new Error('Observer#history - "buckets" must be a non-negative integer.'));
+
+        this._history(counter, from, to, buckets, (error, result) => {
+            error === null ? resolve(result) : reject(error);
+        });
+    });
+}
+
+Observer.prototype.historyUsage = function historyUsage() { return this._historyUsage(); }
+
+Observer.prototype.start = function start(mask, interval, capacity, options) {
+    if ('number' !== typeof mask)
+        throw new Error('Observer#start - "mask" is not a number.');
+    if ('number' !== typeof interval || !(interval >= 1))
+        throw new Error('Observer#start - "interval" must be a number not less than 1.');
+
+    capacity = undefined === capacity ? 1024 : capacity;
+
+    // Файл результатов опроса: при повторном запуске с теми же параметрами запись продолжается
+    const file = options && options.file;
+    const records = options && undefined !== options.records ? options.records : 86400;
+    if (file && (!Number.isInteger(records) || !(records > 1)))
+        throw new Error('Observer#start - "records" must be an integer greater than 1.');
+    this._persist(mask, file ? String(file) : '', file ? records : 0);
+
+    // Публикация результатов каждого опроса в разделяемой памяти для других процессов (см. Observer.readShared)
+    const publish = options && options.publish;
+    this._publish(mask, interval, publish ? String(publish) : '');
+
+    const trigger = options && options.trigger;
+    if (!trigger)
+        return this._start(mask, interval, capacity);
+
+    // Порог и окно триггера задаются в миллисекундах, ядро принимает микросекунды
+    if ('number' !== typeof trigger.stall || 'number' !== typeof trigger.window)
+        throw new Error('Observer#start - "trigger.stall" and "trigger.window" must be numbers.');
+    this._start(mask, interval, capacity, String(trigger.resource), Boolean(trigger.full),
+        Math.round(trigger.stall * 1000), Math.round(trigger.window * 1000));
+}
+
+Observer.prototype.drain = function drain() { return this._drain(); }
+
+// Результат последнего фонового опроса синхронно, без обращения к пулу потоков (null - опрос не запущен)
+Observer.prototype.latest = function latest(mask) {
+    if ('number' !== typeof mask)
+        throw new Error('Observer#latest - "mask" is not a number.');
+
+    return this._latest(mask >>> 0);
+}
+Observer.prototype.stop = function stop() { this._stop(); }
+
+// Названия ячеек записи файла результатов опроса: служебные ячейки и счетчики маски по возрастанию бит
+function withColumns(view, type) {
+    if (null === view)
+        return null;
+
+    const masks = Observer.masks();
+    const list = [masks.system, masks.process, masks.process, masks.cgroup][type];
+    const counters = [];
+    for (let bit = 1; 0 !== bit && bit <= view.mask; bit = (bit << 1) >>> 0) {
+        if (0 !== (view.mask & bit)) {
+            const item = list.find(item => item.mask === bit);
+            counters.push(item ? item.key : String(bit));
+        }
+    }
+    view.columns = ['timestamp', 'pid', 'triggered'].concat(counters);
+    return view;
+}
+
+Observer.prototype.samples = function samples() { return withColumns(this._samples(), this.type()); }
+
+Observer.readShared = function readShared(name) {
+    if ('string' !== typeof name)
+        throw new Error('Observer.readShared - "name" is not a string.');
+
+    return this._readShared(name);
+}
+
+Observer.openSamples = function openSamples(path) {
+    if ('string' !== typeof path)
+        throw new Error('Observer.openSamples - "path" is not a string.');
+
+    const view = this._openSamples(path);
+    return withColumns(view, view.type);
+}
+
+// Корневой каталог procfs для наблюдателей, созданных после вызова (только Linux): позволяет
+// опрашивать синтетическое дерево процессов (bench/fixture.js). Пустая строка - /proc.
+Observer.setProcRoot = function setProcRoot(path) {
+    if ('string' !== typeof path)
+        throw new Error('Observer.setProcRoot - "path" is not a string.');
+
+    this._setProcRoot(path);
+}
+
 Observer.processes = function processes() {
     return new Promise((resolve, reject) => {
         Observer._processes((error, result) => {
@@ -29,6 +260,17 @@ Observer.processes = function processes() {
     });
 }
 
+Observer.pollAll = function pollAll(items) {
+    return new Promise((resolve, reject) => {
+        if (!Array.isArray(items))
+            return reject(new Error('Observer.pollAll - "items" is not an array.'));
+
+        this._pollAll(items.map(item => item.observer), items.map(item => item.mask), (error, result) => {
+            null === error ? resolve(result) : reject(error);
+        });
+    });
+}
+
 Observer.masks = function masks() {
     return {
         system: [
@@ -39,7 +281,13 @@ Observer.masks = function masks() {
             { mask: 16, key: 'pmemusagekb', title: '' },
             { mask: 32, key: 'vmemusage', title: '' },
             { mask: 64, key: 'vmemusagekb', title: '' },
-            { mask: 128, key: 'diskusage', title: '' }
+            { mask: 128, key: 'diskusage', title: '' },
+            { mask: 256, key: 'cpupressure', title: '' },
+            { mask: 512, key: 'cpupressurefull', title: '' },
+            { mask: 1024, key: 'mempressure', title: '' },
+            { mask: 2048, key: 'mempressurefull', title: '' },
+            { mask: 4096, key: 'iopressure', title: '' },
+            { mask: 8192, key: 'iopressurefull', title: '' }
         ],
         process: [
             { mask: 1, key: 'handles', title: '' },
@@ -49,6 +297,14 @@ Observer.masks = function masks() {
             { mask: 16, key: 'pmemusagekb', title: '' },
             { mask: 32, key: 'vmemusage', title: '' },
             { mask: 64, key: 'vmemusagekb', title: '' },
+        ],
+        cgroup: [
+            { mask: 1, key: 'processes', title: '' },
+            { mask: 2, key: 'procusage', title: '' },
+            { mask: 4, key: 'pmemusage', title: '' },
+            { mask: 8, key: 'pmemusagekb', title: '' },
+            { mask: 16, key: 'readkb', title: '' },
+            { mask: 32, key: 'writekb', title: '' }
         ]
     }
 }
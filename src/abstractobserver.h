@@ -58,15 +58,27 @@
 
 #elif defined(TESTTOOLS_LINUX)
 
+#include <fcntl.h> // open, openat
+#include <unistd.h> // pread, close, lseek
+#include <sys/syscall.h> // SYS_getdents64
+
 #else
 #error Platform not supported
 #endif
 
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <list>
 #include <string>
+#include <vector>
+
+#include "history.h"
+#include "summary.h"
 
 /// Корневое пространство имен проекта.
 namespace testtools
@@ -106,9 +118,19 @@ typedef PDH_HCOUNTER Counter;
 /// Умный указатель на дескриптор счетчика
 typedef std::unique_ptr<Counter, CounterDeleter> UniqueCounter;
 
+/// Возвращает текущее значение монотонных часов в миллисекундах
+/// (для вычисления скорости по накопленным значениям счетчиков)
+/// @return Количество миллисекунд
+double GetMonotonicTime() noexcept;
+
 } // namespace pdh
 #endif
 
+#if defined(TESTTOOLS_LINUX)
+/// Код системной ошибки (аналог errno_t из MSVC)
+typedef int errno_t;
+#endif
+
 /// Абстрактный наблюдатель за производительностью. 
 /// Является базовым для всех остальных классов наблюдателей.
 class AbstractObserver
@@ -119,7 +141,8 @@ public:
     { 
         System = 0,     ///< Система
         ProcessId,      ///< Конкретный процесс (по идентификатору)
-        ProcessName     ///< Список процессов (по имени)
+        ProcessName,    ///< Список процессов (по имени)
+        CGroup          ///< Группа процессов cgroup v2 (только Linux)
     };
 
     /// Структура для хранения данных о процессе
@@ -144,23 +167,83 @@ public:
     /// Маска элементов опроса
     typedef uint32_t Mask;
 
+    /// Элемент снимка списка процессов
+    struct ProcessEntry
+    {
+        uint32_t pid;       ///< Идентификатор процесса
+        std::string name;   ///< Имя процесса (в Linux - первые 15 символов, как хранит ядро)
+    };
+
+    /// Снимок списка процессов, общий для нескольких наблюдателей при совместном опросе
+    typedef std::vector<ProcessEntry> ProcessSnapshot;
+
+    /// Результат опроса счетчиков.
+    /// Значения хранятся в массиве фиксированного размера по номеру бита счетчика в маске,
+    /// поэтому опрос не выделяет память и не хеширует строковые ключи. Ключи для Node.JS
+    /// формируются уже при передаче результата в JS (см. observer.cc).
+    struct Sample
+    {
+        /// Максимальное количество счетчиков (разрядность маски)
+        static const size_t kMaxCounters = sizeof(Mask) * 8;
+
+        /// @param[in] id Идентификатор процесса (@b 0 для наблюдателя за системой)
+        explicit Sample(uint32_t id = 0) noexcept
+            : mask(0)
+            , pid(id)
+            , triggered(false)
+            , timestamp(static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()))
+            , values() {}
+
+        /// Возвращает номер бита счетчика в маске
+        /// @param[in] counter Счетчик (один бит маски)
+        /// @return Номер бита
+        static inline size_t IndexOf(Mask counter) noexcept {
+            size_t index = 0;
+            while (1 < counter) { counter >>= 1; ++index; }
+            return index;
+        }
+
+        /// Устанавливает значение счетчика
+        /// @param[in] counter Счетчик (один бит маски)
+        /// @param[in] value Значение счетчика
+        inline void Set(Mask counter, double value) noexcept { values[IndexOf(counter)] = value; mask |= counter; }
+        /// Проверяет, присутствует ли значение счетчика в результате
+        /// @param[in] counter Счетчик (один бит маски)
+        inline bool Has(Mask counter) const noexcept { return 0 != (mask & counter); }
+        /// Возвращает значение счетчика
+        /// @param[in] counter Счетчик (один бит маски)
+        inline double Get(Mask counter) const noexcept { return values[IndexOf(counter)]; }
+
+        /// Маска счетчиков, значения которых присутствуют в результате
+        Mask mask;
+        /// Идентификатор процесса (@b 0 для наблюдателя за системой)
+        uint32_t pid;
+        /// Опрос выполнен фоновым опросом по срабатыванию триггера PSI, а не по расписанию
+        bool triggered;
+        /// Время опроса в миллисекундах с начала эпохи UNIX
+        double timestamp;
+        /// Значения счетчиков по номеру бита в маске
+        std::array<double, kMaxCounters> values;
+    };
+
     /// Базовый класс исключения.
     class Exception : public std::exception
     {
     public:
         /// @param[in] message Текст сообщения об ошибке
         explicit Exception(const std::string& message)
-            : exception(nullptr)
+            : exception()
             , message_(message) {}
         /// @param[in] message Текст сообщения об ошибке
         explicit Exception(const char* message)
-            : exception(nullptr)
+            : exception()
             , message_(message) {}
         virtual ~Exception() = default;
 
         /// Возвращает текст сообщения об ошибке
         /// @return Текст сообщения об ошибке
-        inline virtual const char* what() const override { return message_.data(); };
+        inline virtual const char* what() const noexcept override { return message_.data(); };
 
     protected:
         /// Текст ошибки
@@ -177,12 +260,10 @@ public:
     }; // class SystemError
 
 public:
-#if defined(TESTTOOLS_WIN)
     /// @throw SystemError
     /// @param[in] type Тип наблюдателя
     /// @param[in] object Название объекта наблюдения
     AbstractObserver(uint8_t type, const std::string& object);
-#endif
     virtual ~AbstractObserver() = default;
 
     /// Возвращает тип наблюдателя
@@ -191,13 +272,55 @@ public:
 
     /// Возвращает название объекта наблюдения (например - "kserver.exe")
     /// @return Название объекта наблюдения
-    inline std::string GetObject() const noexcept { return object_; }
+    inline const std::string& GetObject() const noexcept { return object_; }
+
+    /// Опрашивает счетчики и добавляет результаты опроса в конец массива.
+    /// Наблюдатель может опрашиваться одновременно из пула потоков Node.JS и из потока
+    /// фонового опроса (см. Sampler), поэтому вызовы упорядочиваются блокировкой.
+    /// @throw SystemError
+    /// @param[in] mask Маска счетчиков
+    /// @param[in,out] samples Массив результатов опроса
+    /// @param[in] snapshot Снимок списка процессов, если он уже получен для другого наблюдателя,
+    /// или @b nullptr, если наблюдатель должен получить список процессов самостоятельно
+    inline void Collect(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot* snapshot = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t first = samples.size();
+        CollectSamples(mask, samples, snapshot);
+        if (first < samples.size() && (summary_.IsEnabled() || history_.IsEnabled())) Record(samples, first);
+    }
+
+    /// Возвращает статистику значений счетчиков в скользящих окнах, которая пополняется
+    /// при каждом опросе (по умолчанию отключена, см. Summary#Configure)
+    /// @return Статистика значений счетчиков
+    inline Summary& GetSummary() noexcept { return summary_; }
+
+    /// Возвращает сжатую историю значений счетчиков, которая пополняется при каждом опросе
+    /// (по умолчанию отключена, см. History#Configure)
+    /// @return История значений счетчиков
+    inline History& GetHistory() noexcept { return history_; }
+
+    /// Проверяет, требуется ли наблюдателю список процессов при опросе
+    /// @return @b true, если наблюдатель может использовать снимок списка процессов (см. Collect)
+    virtual bool NeedsProcessSnapshot() const noexcept { return false; }
+
+protected:
+    /// Опрашивает счетчики и добавляет результаты опроса в конец массива (вызывается под блокировкой)
+    /// @throw SystemError
+    /// @param[in] mask Маска счетчиков
+    /// @param[in,out] samples Массив результатов опроса
+    /// @param[in] snapshot Снимок списка процессов или @b nullptr
+    virtual void CollectSamples(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot* snapshot) = 0;
 
 public:
     /// Возвращет список запущенных в системе процессов
     /// @throw SystemError
-    /// @return Список структур с информацией о каждом процессе
-    static std::list<Process> GetProcessList();
+    /// @return Массив структур с информацией о каждом процессе
+    static std::vector<Process> GetProcessList();
+
+    /// Возвращает снимок списка процессов (только идентификаторы и имена)
+    /// @throw SystemError
+    /// @return Снимок списка процессов
+    static ProcessSnapshot GetProcessSnapshot();
 
 #if defined(TESTTOOLS_WIN)
 protected:
@@ -223,13 +346,312 @@ protected:
         decltype(&::PdhCloseQuery)> query_;
 #endif
 
+protected:
+    /// Блокировка опроса счетчиков
+    mutable std::mutex mutex_;
+    /// Статистика значений счетчиков в скользящих окнах
+    Summary summary_;
+    /// История значений счетчиков
+    History history_;
+
 private:
+    /// Передает результаты опроса в статистику и историю. Если опрос вернул несколько
+    /// результатов (список процессов), записывается сумма значений по всем процессам.
+    /// @param[in] samples Массив результатов опроса
+    /// @param[in] first Номер первого результата текущего опроса
+    inline void Record(const std::vector<Sample>& samples, size_t first) {
+        Sample total = samples[first];
+        for (size_t i = first + 1; i < samples.size(); ++i) {
+            total.mask |= samples[i].mask;
+            for (Mask bits = samples[i].mask; 0 != bits; bits &= bits - 1) {
+                const size_t index = Sample::IndexOf(bits & (~bits + 1));
+                total.values[index] += samples[i].values[index];
+            }
+        }
+
+        summary_.Add(total.mask, total.values.data());
+        history_.Add(total.timestamp, total.mask, total.values.data());
+    }
+
     /// Тип наблюдателя
     uint8_t type_;
     /// Название наблюдаемого объекта
     std::string object_;
 }; // class AbstractObserver
 
+#if defined(TESTTOOLS_LINUX)
+/// Вспомогательные классы и функции для чтения procfs.
+namespace procfs
+{
+
+/// Корневой каталог procfs по умолчанию
+const char* const kRoot = "/proc";
+
+/// Возвращает корневой каталог procfs, из которого читают наблюдатели (по умолчанию - kRoot)
+/// @return Путь к каталогу
+const char* GetRoot() noexcept;
+
+/// Задает корневой каталог procfs. Позволяет читать синтетическое дерево процессов
+/// (см. bench/fixture.js) для замеров и проверок на заданном количестве процессов.
+/// Действует на наблюдателей и списки процессов, созданных после вызова.
+/// @param[in] path Путь к каталогу (пустая строка - kRoot)
+void SetRoot(const std::string& path);
+
+/// Проверяет, читают ли наблюдатели procfs ядра. Для синтетического дерева идентификаторы
+/// процессов не соответствуют процессам системы, поэтому, например, pidfd не используется.
+/// @return @b true, если корневой каталог - kRoot
+bool IsSystemRoot() noexcept;
+
+/// Буфер фиксированного размера для чтения файлов procfs
+template <size_t Size = 4096>
+using Buffer = std::array<char, Size>;
+
+/// Файл procfs, открытый на все время жизни наблюдателя.
+/// Содержимое файла перечитывается с помощью @e pread без повторного открытия,
+/// что избавляет от вызовов open/close и выделения памяти при каждом опросе.
+class File
+{
+public:
+    File() noexcept : fd_(-1) {}
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] path Полный путь к файлу
+    explicit File(const char* path);
+    File(File&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    File(const File&) = delete;
+    ~File() { Close(); }
+
+    File& operator=(File&& other) noexcept;
+    File& operator=(const File&) = delete;
+
+    /// Открывает файл, закрывая ранее открытый
+    /// @param[in] path Полный путь к файлу
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    bool Open(const char* path) noexcept;
+    /// Открывает файл относительно открытого каталога, закрывая ранее открытый
+    /// @param[in] dirfd Дескриптор каталога
+    /// @param[in] path Путь к файлу относительно каталога
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    bool Open(int dirfd, const char* path) noexcept;
+    /// Принимает во владение уже открытый дескриптор, закрывая ранее открытый
+    /// @param[in] fd Файловый дескриптор
+    void Reset(int fd) noexcept;
+    /// Закрывает файл
+    void Close() noexcept;
+
+    /// Проверяет, открыт ли файл
+    inline bool IsOpen() const noexcept { return -1 != fd_; }
+    /// Возвращает файловый дескриптор
+    inline int Get() const noexcept { return fd_; }
+
+    /// Считывает содержимое файла с начала в буфер и завершает его нулевым символом.
+    /// Если файл больше буфера - считывается только его начало.
+    /// @param[out] buffer Буфер
+    /// @param[in] size Размер буфера
+    /// @return Количество считанных байт или @b -1 в случае ошибки (код ошибки в errno)
+    ssize_t Read(char* buffer, size_t size) const noexcept;
+
+    /// @copydoc Read(char*, size_t) const
+    template <size_t Size>
+    inline ssize_t Read(Buffer<Size>& buffer) const noexcept { return Read(buffer.data(), buffer.size()); }
+
+    /// Считывает содержимое файла целиком: до конца файла, увеличивая буфер по мере заполнения.
+    /// Используется для таблиц, размер которых зависит от количества устройств.
+    /// @param[in,out] buffer Буфер
+    /// @return Количество считанных байт или @b -1 в случае ошибки (код ошибки в errno)
+    ssize_t Read(std::vector<char>& buffer) const;
+
+private:
+    /// Файловый дескриптор
+    int fd_;
+}; // class File
+
+/// Каталог procfs, открытый на все время жизни наблюдателя.
+/// Элементы каталога перечитываются напрямую системным вызовом @e getdents64.
+class Directory
+{
+public:
+    Directory() noexcept : fd_(-1) {}
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] path Полный путь к каталогу
+    explicit Directory(const char* path);
+    Directory(Directory&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    Directory(const Directory&) = delete;
+    ~Directory() { Close(); }
+
+    Directory& operator=(Directory&& other) noexcept;
+    Directory& operator=(const Directory&) = delete;
+
+    /// Открывает каталог, закрывая ранее открытый
+    /// @param[in] path Полный путь к каталогу
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    bool Open(const char* path) noexcept;
+    /// Открывает каталог относительно открытого каталога, закрывая ранее открытый
+    /// @param[in] dirfd Дескриптор каталога
+    /// @param[in] path Путь к каталогу относительно каталога
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    bool Open(int dirfd, const char* path) noexcept;
+    /// Закрывает каталог
+    void Close() noexcept;
+
+    /// Проверяет, открыт ли каталог
+    inline bool IsOpen() const noexcept { return -1 != fd_; }
+    /// Возвращает файловый дескриптор каталога
+    inline int Get() const noexcept { return fd_; }
+
+    /// Вызывает функтор для каждого элемента каталога, кроме "." и ".."
+    /// @param[in] fn Функтор вида void(const char* name)
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    template <typename Fn>
+    bool ForEach(Fn fn) const;
+
+    /// Вызывает функтор для каждого элемента каталога, имя которого является числом
+    /// (идентификатором процесса или потока)
+    /// @param[in] fn Функтор вида void(uint32_t id)
+    /// @return @b true в случае успеха, иначе - @b false (код ошибки в errno)
+    template <typename Fn>
+    bool ForEachId(Fn fn) const;
+
+    /// Возвращает количество элементов каталога, кроме "." и ".."
+    /// @return Количество элементов или @b -1 в случае ошибки (код ошибки в errno)
+    ssize_t Count() const noexcept;
+
+private:
+    /// Файловый дескриптор каталога
+    int fd_;
+}; // class Directory
+
+/// Пропускает пробелы и символы табуляции
+/// @param[in] p Указатель на текущую позицию
+/// @return Указатель на первый непробельный символ
+inline const char* SkipSpaces(const char* p) noexcept
+{
+    while (' ' == *p || '\t' == *p) ++p;
+    return p;
+}
+
+/// Пропускает текущее поле (последовательность непробельных символов) и пробелы за ним
+/// @param[in] p Указатель на текущую позицию
+/// @return Указатель на начало следующего поля
+inline const char* SkipField(const char* p) noexcept
+{
+    p = SkipSpaces(p);
+    while ('\0' != *p && ' ' != *p && '\t' != *p && '\n' != *p) ++p;
+    return SkipSpaces(p);
+}
+
+/// Разбирает беззнаковое целое число, пропуская пробелы перед ним
+/// @param[in] p Указатель на текущую позицию
+/// @param[out] value Значение числа (@b 0, если число отсутствует)
+/// @return Указатель на символ, следующий за числом
+inline const char* ParseUInt(const char* p, uint64_t& value) noexcept
+{
+    p = SkipSpaces(p);
+    uint64_t result = 0;
+    while ('0' <= *p && '9' >= *p) result = result * 10 + static_cast<uint64_t>(*p++ - '0');
+    value = result;
+    return p;
+}
+
+/// Переходит к началу следующей строки
+/// @param[in] p Указатель на текущую позицию
+/// @return Указатель на начало следующей строки или на завершающий нулевой символ
+inline const char* NextLine(const char* p) noexcept
+{
+    const char* eol = std::strchr(p, '\n');
+    return nullptr == eol ? p + std::strlen(p) : eol + 1;
+}
+
+/// Ищет строку, начинающуюся с ключа
+/// @param[in] p Указатель на позицию, с которой начинается поиск
+/// @param[in] key Ключ (например - "MemTotal:")
+/// @return Указатель на символ, следующий за ключом, или @b nullptr, если строка не найдена
+inline const char* FindLine(const char* p, const char* key) noexcept
+{
+    const size_t length = std::strlen(key);
+    for (; '\0' != *p; p = NextLine(p))
+        if (0 == std::strncmp(p, key, length)) return p + length;
+    return nullptr;
+}
+
+/// Значения полей из файла /proc/<pid>/stat
+struct ProcessStat
+{
+    char name[64];          ///< Имя исполняемого файла (comm)
+    char state;             ///< Состояние процесса (R, S, D, Z, ...)
+    uint32_t ppid;          ///< Идентификатор родительского процесса
+    int64_t priority;       ///< Приоритет
+    int64_t nice;           ///< Значение nice
+    uint64_t utime;         ///< Время в режиме пользователя (в тиках)
+    uint64_t stime;         ///< Время в режиме ядра (в тиках)
+    uint64_t threads;       ///< Количество потоков
+    uint64_t start;         ///< Время запуска с момента загрузки системы (в тиках)
+    uint64_t vsize;         ///< Размер виртуального адресного пространства в байтах
+    uint64_t rss;           ///< Размер резидентной памяти в страницах
+};
+
+/// Разбирает содержимое файла /proc/<pid>/stat (или /proc/<pid>/task/<tid>/stat)
+/// @param[in] buffer Содержимое файла
+/// @param[out] stat Значения полей
+/// @return @b true в случае успеха, иначе - @b false
+bool ParseProcessStat(const char* buffer, ProcessStat& stat) noexcept;
+
+/// Считывает и разбирает файл /proc/<pid>/stat процесса
+/// @param[in] proc Дескриптор каталога /proc
+/// @param[in] pid Идентификатор процесса
+/// @param[out] stat Значения полей
+/// @return @b true в случае успеха, иначе - @b false (процесс завершен или недоступен)
+bool ReadProcessStat(int proc, uint32_t pid, ProcessStat& stat) noexcept;
+
+/// Возвращает текущее значение монотонных часов в миллисекундах
+/// @return Количество миллисекунд
+double GetMonotonicTime() noexcept;
+
+/// Структура записи каталога, возвращаемой системным вызовом getdents64
+struct DirectoryEntry
+{
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[1];
+};
+
+template <typename Fn>
+bool Directory::ForEach(Fn fn) const
+{
+    if (-1 == ::lseek(fd_, 0, SEEK_SET)) return false;
+
+    alignas(DirectoryEntry) char buffer[32768];
+    for (;;) {
+        const long length = ::syscall(SYS_getdents64, fd_, buffer, sizeof(buffer));
+        if (0 == length) break;
+        if (0 > length) return false;
+
+        for (long offset = 0; offset < length;) {
+            const DirectoryEntry* entry = reinterpret_cast<const DirectoryEntry*>(buffer + offset);
+            offset += entry->reclen;
+            const char* name = entry->name;
+            if ('.' == name[0] && ('\0' == name[1] || ('.' == name[1] && '\0' == name[2]))) continue;
+            fn(name);
+        }
+    }
+
+    return true;
+}
+
+template <typename Fn>
+bool Directory::ForEachId(Fn fn) const
+{
+    return ForEach([&fn](const char* name) {
+        if ('0' > name[0] || '9' < name[0]) return;
+        uint64_t id = 0;
+        if ('\0' == *ParseUInt(name, id)) fn(static_cast<uint32_t>(id));
+    });
+}
+
+} // namespace procfs
+#endif
+
 } // namespace testtools
 
 #endif // TESTTOOLS_ABSTRACTOBSERVER_H
@@ -0,0 +1,477 @@
+/// @file
+/// Реализация класса абстрактного наблюдателя для Linux.
+
+#include "abstractobserver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <ctime>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <pwd.h>
+#include <sched.h> // sched_getaffinity
+
+// Константа и макрос для перевода тиков системного таймера в милисекунды
+#define TICKS_PER_SEC ::sysconf(_SC_CLK_TCK)
+#define TO_MS(var) (static_cast<double>(var) * 1000. / TICKS_PER_SEC)
+
+// Делитель для перевода байт в килобайты
+#define KBYTE 1024
+
+namespace testtools
+{
+
+using std::string;
+using std::vector;
+
+/// Функции-помощники AbstractObserver
+namespace
+{
+
+/// Возвращает тект сообщения об ошибке по ее коду
+/// @param[in] code Код ошибки
+/// @return Сообщение соответствующее переданному коду
+std::string GetErrorMessage(errno_t code)
+{
+    std::array<char, 256> buffer = { '\0' };
+    // GNU версия strerror_r может вернуть указатель на статическую строку, а не на буфер
+    const char* message = ::strerror_r(code, buffer.data(), buffer.size());
+    return nullptr == message ? std::string() : std::string(message);
+}
+
+/// Минимальное количество процессов, обрабатываемых одним потоком
+const size_t kProcessesPerWorker = 128;
+
+/// Начальный размер буфера для чтения таблиц procfs целиком (см. procfs::File::Read)
+const size_t kTableBufferSize = 32768;
+
+/// Возвращает количество процессоров, на которых разрешено выполняться текущему процессу
+/// (с учетом привязки к процессорам, например, taskset или cpuset контейнера)
+size_t GetAvailableCores() noexcept
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 == ::sched_getaffinity(0, sizeof(set), &set))
+        return std::max(1, CPU_COUNT(&set));
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Возвращает время загрузки системы
+/// @throw AbstractObserver#SystemError
+/// @return Количество милисекунд с начала эпохи Unix
+double GetBootTime()
+{
+    procfs::File file((string(procfs::GetRoot()) + "/stat").data());
+    procfs::Buffer<32768> buffer;
+    if (-1 == file.Read(buffer))
+        throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    uint64_t btime = 0;
+    const char* p = procfs::FindLine(buffer.data(), "btime ");
+    if (nullptr != p) procfs::ParseUInt(p, btime);
+
+    return static_cast<double>(btime) * 1000.;
+}
+
+/// Возвращает имя пользователя по его идентификатору
+/// @param[in] uid Идентификатор пользователя
+/// @return Имя пользователя или его идентификатор, если пользователь не найден
+std::string GetUserName(uint32_t uid)
+{
+    struct passwd pwd = { 0 };
+    struct passwd* result = nullptr;
+    std::array<char, 4096> buffer = { '\0' };
+    if (0 == ::getpwuid_r(static_cast<uid_t>(uid), &pwd, buffer.data(), buffer.size(), &result) && nullptr != result)
+        return pwd.pw_name;
+
+    return std::to_string(uid);
+}
+
+/// Буферы потока, заполняющего информацию о процессах
+struct ProcessReader
+{
+    /// Буфер для чтения файлов stat и status
+    procfs::Buffer<4096> buffer;
+    /// Буфер для формирования путей
+    procfs::Buffer<64> path;
+    /// Буфер для чтения ссылки на исполняемый файл
+    procfs::Buffer<PATH_MAX> exe;
+};
+
+/// Заполняет информацию о процессе из файлов /proc/<pid>/*
+/// @param[in] proc Дескриптор каталога /proc
+/// @param[in] pid Идентификатор процесса
+/// @param[in] boot Время загрузки системы в милисекундах с начала эпохи Unix
+/// @param[in,out] reader Буферы потока
+/// @param[out] process Стуктура для хранения информации о процессе
+/// @param[out] uid Идентификатор владельца процесса
+/// @return @b true в случае успеха или @b false, если процесс успел завершиться
+bool FillProcess(int proc, uint32_t pid, double boot, ProcessReader& reader,
+    AbstractObserver::Process& process, uint32_t& uid)
+{
+    procfs::File file;
+    std::snprintf(reader.path.data(), reader.path.size(), "%u/stat", pid);
+    if (!file.Open(proc, reader.path.data()) || 0 >= file.Read(reader.buffer)) return false;
+
+    procfs::ProcessStat stat = { 0 };
+    if (!procfs::ParseProcessStat(reader.buffer.data(), stat)) return false;
+
+    process.pid = pid;
+    process.ppid = stat.ppid;
+    process.name = stat.name;
+    process.priority = static_cast<uint32_t>(stat.priority);
+    process.status = static_cast<uint32_t>(stat.state);
+    process.threads = static_cast<uint32_t>(stat.threads);
+    process.ktime = TO_MS(stat.stime);
+    process.utime = TO_MS(stat.utime);
+    process.start = boot + TO_MS(stat.start);
+    process.pmemory = static_cast<double>(stat.rss * ::sysconf(_SC_PAGESIZE) / KBYTE);
+
+    std::snprintf(reader.path.data(), reader.path.size(), "%u/status", pid);
+    if (file.Open(proc, reader.path.data()) && 0 < file.Read(reader.buffer)) {
+        uint64_t value = 0;
+        const char* p = procfs::FindLine(reader.buffer.data(), "Uid:");
+        if (nullptr != p) procfs::ParseUInt(p, value);
+        uid = static_cast<uint32_t>(value);
+
+        // Аналогично ProcessObserver: закрытая память - анонимная резидентная и выгруженная
+        uint64_t anonymous = 0;
+        uint64_t swap = 0;
+        if (nullptr != (p = procfs::FindLine(reader.buffer.data(), "RssAnon:"))) procfs::ParseUInt(p, anonymous);
+        if (nullptr != (p = procfs::FindLine(reader.buffer.data(), "VmSwap:"))) procfs::ParseUInt(p, swap);
+        process.vmemory = static_cast<double>(anonymous + swap);
+    }
+
+    // Ссылка на исполняемый файл и список дескрипторов доступны только владельцу процесса
+    std::snprintf(reader.path.data(), reader.path.size(), "%u/exe", pid);
+    const ssize_t length = ::readlinkat(proc, reader.path.data(), reader.exe.data(), reader.exe.size() - 1);
+    if (0 < length) {
+        reader.exe[length] = '\0';
+        const char* slash = std::strrchr(reader.exe.data(), '/');
+        if (nullptr != slash) {
+            // Ядро хранит только 15 символов имени - восстанавливаем полное имя по исполняемому файлу
+            if (15 == process.name.size() && 0 == std::strncmp(slash + 1, stat.name, 15))
+                process.name = slash + 1;
+            process.path.assign(reader.exe.data(), slash == reader.exe.data() ? 1 : slash - reader.exe.data());
+        }
+    }
+
+    std::snprintf(reader.path.data(), reader.path.size(), "%u/fd", pid);
+    procfs::Directory fd;
+    if (fd.Open(proc, reader.path.data())) {
+        const ssize_t count = fd.Count();
+        process.handles = -1 == count ? 0 : static_cast<uint32_t>(count);
+    }
+
+    return true;
+}
+
+} // namespace
+
+AbstractObserver::SystemError::SystemError(errno_t code)
+    : Exception(GetErrorMessage(code)) {}
+
+AbstractObserver::AbstractObserver(uint8_t type, const string& object)
+    : type_(type)
+    , object_(object) {}
+
+vector<AbstractObserver::Process> AbstractObserver::GetProcessList()
+{
+    procfs::Directory proc(procfs::GetRoot());
+    const double boot = GetBootTime();
+
+    vector<uint32_t> pids = {};
+    pids.reserve(1024);
+    if (!proc.ForEachId([&pids](uint32_t pid) { pids.push_back(pid); }))
+        throw SystemError(static_cast<errno_t>(errno));
+
+    // Делим список процессов на непрерывные части по количеству доступных ядер. Каждый поток
+    // заполняет собственную часть результата своими буферами, поэтому синхронизация не нужна.
+    const size_t workers = std::max<size_t>(1, std::min(GetAvailableCores(), pids.size() / kProcessesPerWorker));
+    const size_t chunk = (pids.size() + workers - 1) / workers;
+
+    vector<Process> processes(pids.size(), Process());
+    vector<uint32_t> uids(pids.size(), 0);
+    vector<char> filled(pids.size(), 0);
+
+    auto work = [&](size_t begin, size_t end) {
+        std::unique_ptr<ProcessReader> reader(new ProcessReader());
+        for (size_t i = begin; i < end; ++i)
+            filled[i] = FillProcess(proc.Get(), pids[i], boot, *reader, processes[i], uids[i]) ? 1 : 0;
+    };
+
+    // Поток может не создаться (например, EAGAIN при достижении pids.max группы),
+    // тогда части, оставшиеся без потоков, обрабатываются текущим потоком
+    vector<std::thread> threads = {};
+    threads.reserve(workers - 1);
+    try {
+        for (size_t worker = 1; worker < workers; ++worker)
+            threads.emplace_back(work, worker * chunk, std::min(pids.size(), (worker + 1) * chunk));
+    } catch (const std::system_error&) {}
+
+    try {
+        work(std::min(pids.size(), (threads.size() + 1) * chunk), pids.size());
+        work(0, std::min(pids.size(), chunk));
+    } catch (...) {
+        for (auto& thread : threads)
+            thread.join();
+        throw;
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    // Убираем успевшие завершиться процессы и заполняем имена владельцев:
+    // их разрешение может обращаться к NSS, поэтому выполняется один раз на пользователя.
+    std::unordered_map<uint32_t, string> owners = {};
+    size_t count = 0;
+    for (size_t i = 0; i < processes.size(); ++i) {
+        if (!filled[i]) continue;
+
+        auto owner = owners.find(uids[i]);
+        if (owners.end() == owner)
+            owner = owners.emplace(uids[i], GetUserName(uids[i])).first;
+        processes[i].owner = owner->second;
+
+        if (count != i) processes[count] = std::move(processes[i]);
+        count++;
+    }
+    processes.resize(count);
+
+    return processes;
+}
+
+AbstractObserver::ProcessSnapshot AbstractObserver::GetProcessSnapshot()
+{
+    procfs::Directory proc(procfs::GetRoot());
+
+    ProcessSnapshot snapshot = {};
+    snapshot.reserve(1024);
+    const int dirfd = proc.Get();
+    const bool listed = proc.ForEachId([dirfd, &snapshot](uint32_t pid) {
+        procfs::ProcessStat stat = { 0 };
+        if (procfs::ReadProcessStat(dirfd, pid, stat))
+            snapshot.push_back(ProcessEntry{ pid, stat.name });
+    });
+    if (!listed) throw SystemError(static_cast<errno_t>(errno));
+
+    return snapshot;
+}
+
+namespace procfs
+{
+
+/// Корневой каталог procfs. Строка, на которую указывал прежний корневой каталог,
+/// не освобождается: ее может использовать поток, формирующий путь в этот момент.
+static std::atomic<const char*> root(kRoot);
+
+const char* GetRoot() noexcept
+{
+    return root.load(std::memory_order_acquire);
+}
+
+void SetRoot(const string& path)
+{
+    if (path.empty() || path == kRoot) {
+        root.store(kRoot, std::memory_order_release);
+        return;
+    }
+
+    char* copy = new char[path.size() + 1];
+    std::memcpy(copy, path.data(), path.size() + 1);
+    root.store(copy, std::memory_order_release);
+}
+
+bool IsSystemRoot() noexcept
+{
+    return kRoot == GetRoot();
+}
+
+File::File(const char* path)
+    : fd_(-1)
+{
+    if (!Open(path)) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+}
+
+File& File::operator=(File&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+
+    return *this;
+}
+
+bool File::Open(const char* path) noexcept
+{
+    Close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    return -1 != fd_;
+}
+
+bool File::Open(int dirfd, const char* path) noexcept
+{
+    Close();
+    fd_ = ::openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    return -1 != fd_;
+}
+
+void File::Reset(int fd) noexcept
+{
+    Close();
+    fd_ = fd;
+}
+
+void File::Close() noexcept
+{
+    if (-1 != fd_) ::close(fd_);
+    fd_ = -1;
+}
+
+ssize_t File::Read(char* buffer, size_t size) const noexcept
+{
+    /// @note Файлы procfs формируются ядром заново при чтении с нулевого смещения,
+    /// поэтому @e pread с нулевым смещением всегда возвращает актуальное содержимое.
+    ssize_t length = 0;
+    do length = ::pread(fd_, buffer, size - 1, 0);
+    while (-1 == length && EINTR == errno);
+
+    buffer[-1 == length ? 0 : length] = '\0';
+    return length;
+}
+
+ssize_t File::Read(vector<char>& buffer) const
+{
+    if (buffer.size() < kTableBufferSize) buffer.resize(kTableBufferSize);
+
+    // Таблицы procfs (seq_file) за один вызов возвращают не больше страницы записей,
+    // поэтому читаем с увеличивающимся смещением до конца файла, увеличивая буфер по мере заполнения
+    size_t length = 0;
+    for (;;) {
+        if (buffer.size() - 1 == length) buffer.resize(buffer.size() * 2);
+
+        ssize_t size = 0;
+        do size = ::pread(fd_, buffer.data() + length, buffer.size() - 1 - length, static_cast<off_t>(length));
+        while (-1 == size && EINTR == errno);
+
+        if (-1 == size) {
+            buffer[0] = '\0';
+            return -1;
+        }
+        if (0 == size) break;
+        length += static_cast<size_t>(size);
+    }
+
+    buffer[length] = '\0';
+    return static_cast<ssize_t>(length);
+}
+
+Directory::Directory(const char* path)
+    : fd_(-1)
+{
+    if (!Open(path)) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+}
+
+Directory& Directory::operator=(Directory&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+
+    return *this;
+}
+
+bool Directory::Open(const char* path) noexcept
+{
+    Close();
+    fd_ = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return -1 != fd_;
+}
+
+bool Directory::Open(int dirfd, const char* path) noexcept
+{
+    Close();
+    fd_ = ::openat(dirfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return -1 != fd_;
+}
+
+void Directory::Close() noexcept
+{
+    if (-1 != fd_) ::close(fd_);
+    fd_ = -1;
+}
+
+ssize_t Directory::Count() const noexcept
+{
+    ssize_t count = 0;
+    return ForEach([&count](const char*) { count++; }) ? count : -1;
+}
+
+bool ParseProcessStat(const char* buffer, ProcessStat& stat) noexcept
+{
+    // Формат: "pid (comm) state ppid ...". Имя может содержать пробелы и скобки,
+    // поэтому ищем его конец по последней закрывающей скобке.
+    const char* begin = std::strchr(buffer, '(');
+    const char* end = std::strrchr(buffer, ')');
+    if (nullptr == begin || nullptr == end || end < begin) return false;
+
+    const size_t length = std::min(static_cast<size_t>(end - begin - 1), sizeof(stat.name) - 1);
+    std::memcpy(stat.name, begin + 1, length);
+    stat.name[length] = '\0';
+
+    const char* p = SkipSpaces(end + 1);
+    stat.state = *p;
+
+    // Поля нумеруются с единицы согласно proc(5): state - 3, ppid - 4, ...
+    uint64_t fields[22] = { 0 };
+    p = SkipField(p);
+    for (size_t i = 4; i <= 24 && '\0' != *p; ++i) {
+        // Приоритет и nice могут быть отрицательными
+        const bool negative = '-' == *p;
+        p = ParseUInt(negative ? p + 1 : p, fields[i - 4]);
+        if (negative) fields[i - 4] = static_cast<uint64_t>(-static_cast<int64_t>(fields[i - 4]));
+        p = SkipSpaces(p);
+    }
+
+    stat.ppid = static_cast<uint32_t>(fields[4 - 4]);
+    stat.utime = fields[14 - 4];
+    stat.stime = fields[15 - 4];
+    stat.priority = static_cast<int64_t>(fields[18 - 4]);
+    stat.nice = static_cast<int64_t>(fields[19 - 4]);
+    stat.threads = fields[20 - 4];
+    stat.start = fields[22 - 4];
+    stat.vsize = fields[23 - 4];
+    stat.rss = fields[24 - 4];
+
+    return true;
+}
+
+bool ReadProcessStat(int proc, uint32_t pid, ProcessStat& stat) noexcept
+{
+    Buffer<1024> buffer;
+    std::snprintf(buffer.data(), buffer.size(), "%u/stat", pid);
+
+    File file;
+    if (!file.Open(proc, buffer.data()) || 0 >= file.Read(buffer)) return false;
+
+    return ParseProcessStat(buffer.data(), stat);
+}
+
+double GetMonotonicTime() noexcept
+{
+    struct timespec ts = { 0 };
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000. + static_cast<double>(ts.tv_nsec) / 1000000.;
+}
+
+} // namespace procfs
+
+} // namespace testtools
@@ -16,8 +16,8 @@
 namespace testtools
 {
 
-using std::list;
 using std::string;
+using std::vector;
 
 /// Функции-помощники AbstractObserver
 namespace
@@ -233,6 +233,19 @@ AbstractObserver::AbstractObserver(uint8_t type, const string& object)
     else throw SystemError(static_cast<errno_t>(result));
 }
 
+double pdh::GetMonotonicTime() noexcept
+{
+    static const double frequency = []() {
+        LARGE_INTEGER value = { 0 };
+        ::QueryPerformanceFrequency(&value);
+        return static_cast<double>(value.QuadPart);
+    }();
+
+    LARGE_INTEGER counter = { 0 };
+    ::QueryPerformanceCounter(&counter);
+    return static_cast<double>(counter.QuadPart) * 1000. / frequency;
+}
+
 pdh::Counter AbstractObserver::AddPdhCounter(pdh::Query query, const string& path)
 {
     static const bool isWindowsVistaOrGreater = static_cast<bool>(IsWindowsVistaOrGreater());
@@ -277,7 +290,7 @@ double AbstractObserver::GetPdhValue(pdh::Counter handle)
     return 0.;
 }
 
-list<AbstractObserver::Process> AbstractObserver::GetProcessList()
+vector<AbstractObserver::Process> AbstractObserver::GetProcessList()
 {
     EnableDebugPrivelege();
 
@@ -292,7 +305,8 @@ list<AbstractObserver::Process> AbstractObserver::GetProcessList()
         throw SystemError(static_cast<errno_t>(::GetLastError()));
     }
 
-    list<Process> plist = {};
+    vector<Process> plist = {};
+    plist.reserve(256);
     do {
         if (0 == entry.th32ProcessID || 4 == entry.th32ProcessID) continue;
 
@@ -325,4 +339,27 @@ list<AbstractObserver::Process> AbstractObserver::GetProcessList()
     return plist;
 }
 
+AbstractObserver::ProcessSnapshot AbstractObserver::GetProcessSnapshot()
+{
+    HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (INVALID_HANDLE_VALUE == snapshot)
+        throw SystemError(static_cast<errno_t>(::GetLastError()));
+
+    PROCESSENTRY32 entry = { 0 };
+    entry.dwSize = sizeof(entry);
+    if (!::Process32First(snapshot, &entry)) {
+        ::CloseHandle(snapshot);
+        throw SystemError(static_cast<errno_t>(::GetLastError()));
+    }
+
+    ProcessSnapshot psnapshot = {};
+    psnapshot.reserve(256);
+    do psnapshot.push_back(ProcessEntry{ static_cast<uint32_t>(entry.th32ProcessID), entry.szExeFile });
+    while (::Process32Next(snapshot, &entry));
+
+    ::CloseHandle(snapshot);
+
+    return psnapshot;
+}
+
 } // namespace testtools
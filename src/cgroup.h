@@ -0,0 +1,96 @@
+/// @file
+/// Объявление доступа к лимитам и потреблению ресурсов группы cgroup v2 (только Linux).
+
+#pragma once
+
+#ifndef TESTTOOLS_CGROUP_H
+#define TESTTOOLS_CGROUP_H
+
+#include "abstractobserver.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace testtools
+{
+
+/// Группа cgroup v2, ограничивающая ресурсы процесса (например, контейнера).
+///
+/// Действующие лимиты памяти (memory.max) и процессора (cpu.max) определяются как минимум
+/// по группе и всем ее предкам. Лимиты перечитываются только после того, как inotify сообщит
+/// об изменении одного из этих файлов, поэтому опрос обходится одним неблокирующим чтением
+/// дескриптора inotify. Текущее потребление (memory.current, cpu.stat) читается при каждом
+/// запросе через постоянно открытые файлы.
+class CGroup final
+{
+public:
+    /// Возвращает общий экземпляр группы текущего процесса для текущего корневого каталога procfs,
+    /// создавая его при первом обращении.
+    /// Группа уничтожается вместе с последним использующим ее наблюдателем.
+    /// @return Умный указатель на группу или @b nullptr, если cgroup v2 не смонтирована
+    /// либо процесс находится в корневой группе хоста (ограничения ресурсов невозможны)
+    static std::shared_ptr<CGroup> GetCurrent();
+
+    /// Ищет точку монтирования cgroup v2
+    /// @param[out] mount Точка монтирования
+    /// @param[out] root Корень иерархии, смонтированный в эту точку
+    /// @return @b true в случае успеха, иначе - @b false
+    static bool FindMount(std::string& mount, std::string& root);
+
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] mount Точка монтирования cgroup v2
+    /// @param[in] path Путь группы относительно точки монтирования
+    CGroup(const std::string& mount, const std::string& path);
+    CGroup(const CGroup&) = delete;
+    CGroup& operator=(const CGroup&) = delete;
+    ~CGroup();
+
+    /// Возвращает действующий лимит памяти
+    /// @return Лимит в байтах или @b 0, если память не ограничена
+    double GetMemoryLimit();
+    /// Возвращает действующий лимит процессора
+    /// @return Доступное количество процессоров (может быть дробным) или @b 0, если не ограничено
+    double GetCpuLimit();
+
+    /// Возвращает объем памяти, потребляемой группой (memory.current)
+    /// @return Объем в байтах или @b -1, если контроллер памяти для группы не включен
+    double GetMemoryUsage() const noexcept;
+    /// Возвращает суммарное время процессора, потребленное группой (usage_usec из cpu.stat)
+    /// @return Время в микросекундах или @b -1, если значение недоступно
+    double GetCpuUsage() const noexcept;
+
+    /// Возвращает полный путь к каталогу группы
+    inline const std::string& GetPath() const noexcept { return path_; }
+
+private:
+    /// Перечитывает лимиты, если inotify сообщил об изменении файлов (вызывается под блокировкой)
+    void Refresh();
+    /// Считывает действующие лимиты группы и ее предков (вызывается под блокировкой)
+    void ReadLimits();
+
+private:
+    /// Полный путь к каталогу группы
+    std::string path_;
+    /// Каталоги группы и ее предков вплоть до корневой группы (не включая ее)
+    /// либо до корня пространства имен cgroup, если он имеет лимиты
+    std::vector<std::string> hierarchy_;
+    /// Файл memory.current
+    procfs::File memoryCurrent_;
+    /// Файл cpu.stat
+    procfs::File cpuStat_;
+    /// Дескриптор inotify, наблюдающий за файлами лимитов, или @b -1
+    int inotify_;
+
+    /// Блокировка лимитов
+    std::mutex mutex_;
+    /// Действующий лимит памяти в байтах (0 - без ограничения)
+    double memoryLimit_;
+    /// Действующий лимит процессора в процессорах (0 - без ограничения)
+    double cpuLimit_;
+}; // class CGroup
+
+} // namespace testtools
+
+#endif // TESTTOOLS_CGROUP_H
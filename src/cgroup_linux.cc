@@ -0,0 +1,246 @@
+/// @file
+/// Реализация доступа к лимитам и потреблению ресурсов группы cgroup v2.
+
+#include "cgroup.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <sys/inotify.h>
+
+namespace testtools
+{
+
+using std::string;
+using std::vector;
+
+/// Функции-помощники CGroup
+namespace
+{
+
+/// Ищет путь группы cgroup v2 текущего процесса
+/// @param[out] path Путь относительно корня иерархии
+/// @return @b true в случае успеха, иначе - @b false
+bool FindPath(string& path)
+{
+    procfs::File file;
+    procfs::Buffer<4096> buffer;
+    if (!file.Open((string(procfs::GetRoot()) + "/self/cgroup").data())) return false;
+    if (0 >= file.Read(buffer)) return false;
+
+    // Группа cgroup v2 описывается строкой "0::<путь>"
+    const char* p = buffer.data();
+    if (0 != std::strncmp(p, "0::", 3) && nullptr == (p = std::strstr(p, "\n0::"))) return false;
+    p = std::strchr(p, ':') + 2;
+
+    const char* eol = std::strchr(p, '\n');
+    path.assign(p, nullptr == eol ? std::strlen(p) : static_cast<size_t>(eol - p));
+    return true;
+}
+
+/// Считывает лимит памяти из файла memory.max
+/// @param[in] path Путь к файлу
+/// @return Лимит в байтах или @b 0, если файл отсутствует или память не ограничена ("max")
+double ReadMemoryLimit(const string& path)
+{
+    procfs::File file;
+    procfs::Buffer<64> buffer;
+    if (!file.Open(path.data()) || 0 >= file.Read(buffer)) return 0.;
+
+    uint64_t value = 0;
+    procfs::ParseUInt(buffer.data(), value);
+    return static_cast<double>(value);
+}
+
+/// Считывает лимит процессора из файла cpu.max
+/// @param[in] path Путь к файлу
+/// @return Количество процессоров или @b 0, если файл отсутствует или процессор не ограничен ("max")
+double ReadCpuLimit(const string& path)
+{
+    procfs::File file;
+    procfs::Buffer<64> buffer;
+    if (!file.Open(path.data()) || 0 >= file.Read(buffer)) return 0.;
+
+    // Формат файла: "<квота> <период>" в микросекундах, квота "max" - без ограничения
+    uint64_t quota = 0;
+    uint64_t period = 0;
+    procfs::ParseUInt(procfs::ParseUInt(buffer.data(), quota), period);
+    return 0 == period ? 0. : static_cast<double>(quota) / static_cast<double>(period);
+}
+
+/// Проверяет наличие файлов лимитов в каталоге группы.
+/// В корневой группе иерархии их нет, а в корне пространства имен cgroup (контейнер) они есть.
+bool HasLimits(const string& dir)
+{
+    return 0 == ::access((dir + "/memory.max").data(), F_OK) || 0 == ::access((dir + "/cpu.max").data(), F_OK);
+}
+
+/// Возвращает меньший из лимитов, считая нулевой лимит отсутствующим
+inline double MinLimit(double a, double b) noexcept
+{
+    return 0. == a ? b : (0. == b ? a : std::min(a, b));
+}
+
+} // namespace
+
+std::shared_ptr<CGroup> CGroup::GetCurrent()
+{
+    static std::mutex mutex;
+    // Экземпляры по корневому каталогу procfs, из которого прочитаны группа и точка монтирования
+    // (см. procfs::SetRoot)
+    static std::unordered_map<string, std::weak_ptr<CGroup>> instances;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<CGroup>& instance = instances[procfs::GetRoot()];
+    std::shared_ptr<CGroup> group = instance.lock();
+    if (group) return group;
+
+    string mount;
+    string root;
+    string path;
+    if (!FindMount(mount, root) || !FindPath(path)) return nullptr;
+
+    // Если в точку монтирования смонтирована не вся иерархия, путь группы указан от ее корня
+    if ("/" != root && 0 == path.compare(0, root.size(), root)) path.erase(0, root.size());
+
+    // Путь "/" означает корень видимой иерархии: на хосте это корневая группа без лимитов,
+    // а в пространстве имен cgroup (по умолчанию в Docker и Kubernetes) - собственная группа контейнера
+    if ("/" == path) path.clear();
+    if (path.empty() && !HasLimits(mount)) return nullptr;
+
+    try {
+        group.reset(new CGroup(mount, path));
+    } catch (const AbstractObserver::SystemError&) {
+        // Каталог группы недоступен (например, группа вне пространства имен cgroup)
+        return nullptr;
+    }
+
+    instance = group;
+    return group;
+}
+
+bool CGroup::FindMount(string& mount, string& root)
+{
+    // На хостах с контейнерами файл занимает много страниц, поэтому считывается целиком
+    procfs::File file;
+    vector<char> buffer;
+    if (!file.Open((string(procfs::GetRoot()) + "/self/mountinfo").data())) return false;
+    if (0 >= file.Read(buffer)) return false;
+
+    // Формат строки: "id parent major:minor root mount options [optional...] - fstype source options"
+    for (const char* p = buffer.data(); '\0' != *p; p = procfs::NextLine(p)) {
+        const char* separator = std::strstr(p, " - ");
+        const char* eol = std::strchr(p, '\n');
+        if (nullptr == separator || (nullptr != eol && separator > eol)) continue;
+        if (0 != std::strncmp(separator + 3, "cgroup2 ", 8)) continue;
+
+        const char* r = procfs::SkipField(procfs::SkipField(procfs::SkipField(p)));
+        const char* m = procfs::SkipField(r);
+        root.assign(r, m - r - 1);
+        mount.assign(m, procfs::SkipField(m) - m - 1);
+        return true;
+    }
+
+    return false;
+}
+
+CGroup::CGroup(const string& mount, const string& path)
+    : path_(mount + path)
+    , hierarchy_()
+    , memoryCurrent_()
+    , cpuStat_()
+    , inotify_(-1)
+    , memoryLimit_(0.)
+    , cpuLimit_(0.)
+{
+    if (0 != ::access(path_.data(), F_OK)) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    // Корневая группа не имеет файлов лимитов, поэтому поднимаемся только до нее.
+    // Точка монтирования включается, если это корень пространства имен cgroup с лимитами.
+    for (string dir = path_; dir.size() > mount.size(); dir.erase(dir.rfind('/')))
+        hierarchy_.push_back(dir);
+    if (HasLimits(mount)) hierarchy_.push_back(mount);
+
+    // Файлы отсутствуют, если соответствующий контроллер не включен для группы
+    memoryCurrent_.Open((path_ + "/memory.current").data());
+    cpuStat_.Open((path_ + "/cpu.stat").data());
+
+    // Запись в файл cgroupfs порождает событие IN_MODIFY, как и для обычного файла.
+    // Без inotify лимиты считываются один раз при создании.
+    inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (-1 != inotify_) {
+        for (const string& dir : hierarchy_) {
+            ::inotify_add_watch(inotify_, (dir + "/memory.max").data(), IN_MODIFY);
+            ::inotify_add_watch(inotify_, (dir + "/cpu.max").data(), IN_MODIFY);
+        }
+    }
+
+    ReadLimits();
+}
+
+CGroup::~CGroup()
+{
+    if (-1 != inotify_) ::close(inotify_);
+}
+
+double CGroup::GetMemoryLimit()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Refresh();
+    return memoryLimit_;
+}
+
+double CGroup::GetCpuLimit()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Refresh();
+    return cpuLimit_;
+}
+
+double CGroup::GetMemoryUsage() const noexcept
+{
+    procfs::Buffer<64> buffer;
+    if (!memoryCurrent_.IsOpen() || 0 >= memoryCurrent_.Read(buffer)) return -1.;
+
+    uint64_t value = 0;
+    procfs::ParseUInt(buffer.data(), value);
+    return static_cast<double>(value);
+}
+
+double CGroup::GetCpuUsage() const noexcept
+{
+    procfs::Buffer<1024> buffer;
+    if (!cpuStat_.IsOpen() || 0 >= cpuStat_.Read(buffer)) return -1.;
+
+    // Поле usage_usec присутствует, даже если контроллер cpu для группы не включен
+    const char* p = procfs::FindLine(buffer.data(), "usage_usec");
+    if (nullptr == p) return -1.;
+
+    uint64_t value = 0;
+    procfs::ParseUInt(p, value);
+    return static_cast<double>(value);
+}
+
+void CGroup::Refresh()
+{
+    if (-1 == inotify_) return;
+
+    // Содержимое событий не важно: любое из них означает, что изменился один из лимитов
+    alignas(struct inotify_event) char buffer[4096];
+    bool modified = false;
+    while (0 < ::read(inotify_, buffer, sizeof(buffer))) modified = true;
+
+    if (modified) ReadLimits();
+}
+
+void CGroup::ReadLimits()
+{
+    memoryLimit_ = 0.;
+    cpuLimit_ = 0.;
+    for (const string& dir : hierarchy_) {
+        memoryLimit_ = MinLimit(memoryLimit_, ReadMemoryLimit(dir + "/memory.max"));
+        cpuLimit_ = MinLimit(cpuLimit_, ReadCpuLimit(dir + "/cpu.max"));
+    }
+}
+
+} // namespace testtools
@@ -0,0 +1,113 @@
+/// @file
+/// Объявление наблюдателя за группой процессов cgroup v2.
+
+#pragma once
+
+#ifndef TESTTOOLS_CGROUPOBSERVER_H
+#define TESTTOOLS_CGROUPOBSERVER_H
+
+#include "abstractobserver.h"
+
+#if defined(TESTTOOLS_LINUX)
+#include "cgroup.h"
+#endif
+
+#include <memory>
+
+namespace testtools
+{
+
+/// Наблюдатель за производительностью группы процессов cgroup v2 (например, службы systemd
+/// или контейнера) в целом. Значения читаются из файлов группы, которые ядро ведет для всех ее
+/// процессов, поэтому опрос читает одно и то же количество файлов, сколько бы процессов ни было
+/// в группе. Поддерживается только в Linux; в Windows конструктор выбрасывает исключение.
+class CGroupObserver final : public AbstractObserver
+{
+public:
+    /// Счетчики доступные для опроса
+    enum Counter
+    {
+        ProcessCount                = 1,    ///< Количество процессов (cgroup.procs, без вложенных групп)
+        ProcessorUsage              = 2,    ///< Процент загрузки процессора (не нормируется на количество процессоров)
+        MemoryUsage                 = 4,    ///< Процент потребления памяти от лимита группы (или от памяти системы)
+        MemoryUsageKBytes           = 8,    ///< Потребление памяти в килобайтах (memory.current)
+        ReadKBytes                  = 16,   ///< Прочитано с блочных устройств килобайт в секунду (io.stat)
+        WriteKBytes                 = 32    ///< Записано на блочные устройства килобайт в секунду (io.stat)
+    };
+
+    /// Результаты опроса счетчиков
+    typedef Sample Result;
+
+public:
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] path Путь группы относительно точки монтирования cgroup v2
+    /// (например - "/system.slice/nginx.service") или полный путь к ее каталогу
+    explicit CGroupObserver(const std::string& path);
+    ~CGroupObserver() = default;
+
+    /// Возвращает результат опроса счетчиков
+    /// @throw SystemError
+    /// @param[in] mask Маска счетчиков
+    /// @return Значения счетчиков
+    Result Poll(Mask mask) const;
+
+protected:
+    /// @copydoc AbstractObserver#CollectSamples
+    inline void CollectSamples(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot*) override {
+        samples.push_back(Poll(mask));
+    }
+
+#if defined(TESTTOOLS_LINUX)
+private:
+    /// Возвращает количество процессов в группе
+    /// @throw AbstractObserver#SystemError
+    /// @return Количество процессов
+    double GetProcessCount() const;
+    /// Возвращает процент загрузки процессора группой с момента предыдущего опроса
+    /// @return Процент загрузки процессора
+    double GetProcessorUsage() const;
+    /// Вычисляет скорости чтения и записи с момента предыдущего опроса
+    /// @param[out] read Прочитано килобайт в секунду
+    /// @param[out] write Записано килобайт в секунду
+    /// @return @b false, если контроллер io для группы не включен
+    bool GetIoRates(double& read, double& write) const;
+    /// Считывает суммарные по всем устройствам объемы ввода-вывода из io.stat
+    /// @param[out] read Прочитано байт
+    /// @param[out] write Записано байт
+    /// @return @b false, если контроллер io для группы не включен
+    bool ReadIoBytes(double& read, double& write) const;
+
+private:
+    /// Группа процессов
+    std::unique_ptr<testtools::CGroup> group_;
+    /// Файл cgroup.procs
+    procfs::File procs_;
+    /// Файл io.stat (закрыт, если контроллер io для группы не включен)
+    procfs::File io_;
+    /// Буфер для чтения файлов группы
+    mutable procfs::Buffer<32768> buffer_;
+    /// Объем физической памяти системы в байтах (для группы без лимита памяти)
+    double totalMemory_;
+
+    /// Время процессора, потребленное группой к моменту предыдущего опроса (в микросекундах)
+    mutable double processorUsec_;
+    /// Время предыдущего опроса процессора в миллисекундах
+    mutable double processorTime_;
+    /// Процент загрузки процессора, вычисленный при предыдущем опросе
+    mutable double processorUsage_;
+    /// Прочитано байт к моменту предыдущего опроса
+    mutable double ioRead_;
+    /// Записано байт к моменту предыдущего опроса
+    mutable double ioWrite_;
+    /// Время предыдущего опроса ввода-вывода в миллисекундах
+    mutable double ioTime_;
+    /// Скорость чтения, вычисленная при предыдущем опросе
+    mutable double ioReadRate_;
+    /// Скорость записи, вычисленная при предыдущем опросе
+    mutable double ioWriteRate_;
+#endif
+}; // class CGroupObserver
+
+} // namespace testtools
+
+#endif // TESTTOOLS_CGROUPOBSERVER_H
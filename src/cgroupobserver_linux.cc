@@ -0,0 +1,201 @@
+/// @file
+/// Реализация работы наблюдателя за группой процессов cgroup v2 для Linux.
+
+#include "cgroupobserver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <sys/sysinfo.h>
+
+/// Делитель для перевода байт в килобайты
+#define KBYTESDIV 1024
+
+namespace testtools
+{
+
+using std::string;
+
+/// Функции-помощники CGroupObserver
+namespace
+{
+
+/// Минимальный интервал вычисления загрузки процессора (в миллисекундах).
+/// Время выполняющихся задач попадает в cpu.stat по тикам планировщика, поэтому на меньших
+/// интервалах значение искажается в разы - в этом случае возвращается предыдущее значение.
+const double kMinProcessorInterval = 100.;
+
+} // namespace
+
+CGroupObserver::CGroupObserver(const string& path)
+    : AbstractObserver(CGroup, path)
+    , group_()
+    , procs_()
+    , io_()
+    , buffer_({ '\0' })
+    , totalMemory_(0.)
+    , processorUsec_(0.)
+    , processorTime_(0.)
+    , processorUsage_(0.)
+    , ioRead_(0.)
+    , ioWrite_(0.)
+    , ioTime_(0.)
+    , ioReadRate_(0.)
+    , ioWriteRate_(0.)
+{
+    string mount;
+    string root;
+    if (!testtools::CGroup::FindMount(mount, root)) throw Exception("cgroup v2 is not mounted.");
+
+    // Путь принимается как от точки монтирования (в формате /proc/<pid>/cgroup), так и полный
+    string relative = path;
+    if (0 == relative.compare(0, mount.size(), mount) && (mount.size() == relative.size() || '/' == relative[mount.size()]))
+        relative.erase(0, mount.size());
+    if (relative.empty() || '/' != relative.front()) relative.insert(0, 1, '/');
+    while (!relative.empty() && '/' == relative.back()) relative.pop_back();
+
+    try {
+        group_.reset(new testtools::CGroup(mount, relative));
+    }
+    catch (const SystemError&) {
+        throw Exception("Control group not found: " + path);
+    }
+
+    if (!procs_.Open((group_->GetPath() + "/cgroup.procs").data()))
+        throw SystemError(static_cast<errno_t>(errno));
+    // io.stat отсутствует, если контроллер io для группы не включен
+    io_.Open((group_->GetPath() + "/io.stat").data());
+
+    struct sysinfo info = { 0 };
+    if (0 != ::sysinfo(&info)) throw SystemError(static_cast<errno_t>(errno));
+    totalMemory_ = static_cast<double>(info.totalram) * info.mem_unit;
+
+    // Запоминаем начальные значения, чтобы первый опрос вернул загрузку с момента создания наблюдателя
+    processorUsec_ = group_->GetCpuUsage();
+    processorTime_ = procfs::GetMonotonicTime();
+    ReadIoBytes(ioRead_, ioWrite_);
+    ioTime_ = processorTime_;
+}
+
+CGroupObserver::Result CGroupObserver::Poll(Mask mask) const
+{
+    Result presult;
+    if (ProcessCount & mask)
+        presult.Set(ProcessCount, GetProcessCount());
+
+    if (ProcessorUsage & mask) {
+        const double usage = GetProcessorUsage();
+        if (0. <= usage) presult.Set(ProcessorUsage, usage);
+    }
+
+    if ((MemoryUsage | MemoryUsageKBytes) & mask) {
+        const double used = group_->GetMemoryUsage();
+        if (0. <= used) {
+            const double limit = group_->GetMemoryLimit();
+            const double total = (0. < limit && limit < totalMemory_) ? limit : totalMemory_;
+            if (MemoryUsage & mask)
+                presult.Set(MemoryUsage, std::floor((used * 100) / total));
+            if (MemoryUsageKBytes & mask)
+                presult.Set(MemoryUsageKBytes, used / KBYTESDIV);
+        }
+    }
+
+    if ((ReadKBytes | WriteKBytes) & mask) {
+        double read = 0.;
+        double write = 0.;
+        if (GetIoRates(read, write)) {
+            if (ReadKBytes & mask) presult.Set(ReadKBytes, read);
+            if (WriteKBytes & mask) presult.Set(WriteKBytes, write);
+        }
+    }
+
+    return presult;
+}
+
+double CGroupObserver::GetProcessCount() const
+{
+    // Процессов может быть больше, чем помещается в буфер, поэтому файл читается частями.
+    // Каждый процесс записан отдельной строкой.
+    double count = 0.;
+    off_t offset = 0;
+    for (;;) {
+        const ssize_t size = ::pread(procs_.Get(), buffer_.data(), buffer_.size(), offset);
+        if (-1 == size) throw SystemError(static_cast<errno_t>(errno));
+        if (0 == size) break;
+
+        count += static_cast<double>(std::count(buffer_.data(), buffer_.data() + size, '\n'));
+        offset += size;
+    }
+
+    return count;
+}
+
+double CGroupObserver::GetProcessorUsage() const
+{
+    const double usec = group_->GetCpuUsage();
+    if (0. > usec) return -1.;
+
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - processorTime_;
+    if (kMinProcessorInterval > elapsed) return processorUsage_;
+
+    /// @note Как и для процесса, значение не нормируется на количество процессоров: загрузка
+    /// группы равна сумме загрузок ее процессов и может превышать 100%.
+    if (0. <= processorUsec_ && usec >= processorUsec_)
+        processorUsage_ = (usec - processorUsec_) * 0.1 / elapsed;
+
+    processorUsec_ = usec;
+    processorTime_ = time;
+    return processorUsage_;
+}
+
+bool CGroupObserver::GetIoRates(double& read, double& write) const
+{
+    double readBytes = 0.;
+    double writeBytes = 0.;
+    if (!ReadIoBytes(readBytes, writeBytes)) return false;
+
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - ioTime_;
+
+    // Счетчики уменьшаются, если устройство было удалено - такой интервал пропускаем
+    if (0. < elapsed && readBytes >= ioRead_ && writeBytes >= ioWrite_) {
+        ioReadRate_ = (readBytes - ioRead_) * 1000. / (KBYTESDIV * elapsed);
+        ioWriteRate_ = (writeBytes - ioWrite_) * 1000. / (KBYTESDIV * elapsed);
+    }
+
+    ioRead_ = readBytes;
+    ioWrite_ = writeBytes;
+    ioTime_ = time;
+
+    read = ioReadRate_;
+    write = ioWriteRate_;
+    return true;
+}
+
+bool CGroupObserver::ReadIoBytes(double& read, double& write) const
+{
+    if (!io_.IsOpen()) return false;
+    if (-1 == io_.Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Формат строки: "<major>:<minor> rbytes=N wbytes=N rios=N wios=N dbytes=N dios=N"
+    uint64_t value = 0;
+    read = 0.;
+    write = 0.;
+    for (const char* p = buffer_.data(); '\0' != *p; p = procfs::NextLine(p)) {
+        for (const char* f = procfs::SkipField(p); '\0' != *f && '\n' != *f; f = procfs::SkipField(f)) {
+            if (0 == std::strncmp(f, "rbytes=", 7)) {
+                procfs::ParseUInt(f + 7, value);
+                read += static_cast<double>(value);
+            }
+            else if (0 == std::strncmp(f, "wbytes=", 7)) {
+                procfs::ParseUInt(f + 7, value);
+                write += static_cast<double>(value);
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace testtools
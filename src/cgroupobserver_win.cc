@@ -0,0 +1,20 @@
+/// @file
+/// Реализация наблюдателя за группой процессов cgroup v2 для Windows (не поддерживается).
+
+#include "cgroupobserver.h"
+
+namespace testtools
+{
+
+CGroupObserver::CGroupObserver(const std::string& path)
+    : AbstractObserver(CGroup, path)
+{
+    throw Exception("CGroup observers are supported only on Linux.");
+}
+
+CGroupObserver::Result CGroupObserver::Poll(Mask) const
+{
+    return Result();
+}
+
+} // namespace testtools
@@ -0,0 +1,306 @@
+/// @file
+/// Реализация сжатого хранилища истории значений счетчиков.
+
+#include "history.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace testtools
+{
+
+/// Функции-помощники History
+namespace
+{
+
+/// Признак отсутствия предыдущего блока значащих бит XOR
+const uint32_t kNoBlock = 0xFFFFFFFF;
+/// Наибольшее количество старших нулевых бит, которое можно записать (5 бит)
+const uint32_t kMaxLeading = 31;
+
+/// Последовательное чтение бит блока (биты записаны от старшего к младшему)
+class BitReader final
+{
+public:
+    /// @param[in] bits Сжатые значения
+    explicit BitReader(const std::vector<uint64_t>& bits) noexcept : bits_(bits.data()), position_(0) {}
+
+    /// Считывает биты
+    /// @param[in] count Количество бит (от 1 до 64)
+    /// @return Значение
+    inline uint64_t Read(uint32_t count) noexcept {
+        const uint64_t* word = bits_ + (position_ >> 6);
+        const uint32_t offset = static_cast<uint32_t>(position_ & 63);
+        uint64_t result = word[0] << offset;
+        if (64 < offset + count) result |= word[1] >> (64 - offset);
+        position_ += count;
+        return result >> (64 - count);
+    }
+
+    /// Считывает один бит
+    inline bool ReadBit() noexcept { return 0 != Read(1); }
+
+private:
+    /// Сжатые значения
+    const uint64_t* bits_;
+    /// Номер следующего бита
+    uint64_t position_;
+}; // class BitReader
+
+/// Возвращает количество старших нулевых бит ненулевого значения
+inline uint32_t CountLeadingZeros(uint64_t value) noexcept
+{
+    uint32_t count = 0;
+    for (uint32_t shift = 32; 0 != shift; shift >>= 1) {
+        if (0 == (value >> (64 - shift))) { count += shift; value <<= shift; }
+    }
+    return count;
+}
+
+/// Возвращает количество младших нулевых бит ненулевого значения
+inline uint32_t CountTrailingZeros(uint64_t value) noexcept
+{
+    uint32_t count = 0;
+    for (uint32_t shift = 32; 0 != shift; shift >>= 1) {
+        if (0 == (value & ((uint64_t(1) << shift) - 1))) { count += shift; value >>= shift; }
+    }
+    return count;
+}
+
+/// Возвращает номер младшего установленного бита маски
+inline size_t IndexOf(uint32_t bits) noexcept
+{
+    return CountTrailingZeros(bits);
+}
+
+} // namespace
+
+void History::Configure(double retention)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    retention_ = 0. < retention ? retention : 0.;
+    for (auto& chunks : series_) chunks.clear();
+    enabled_.store(0. < retention_, std::memory_order_relaxed);
+}
+
+void History::Add(double timestamp, uint32_t mask, const double* values)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (0. >= retention_) return;
+
+    const int64_t time = static_cast<int64_t>(timestamp);
+    const int64_t expired = static_cast<int64_t>(timestamp - retention_);
+    for (uint32_t bits = mask; 0 != bits; bits &= bits - 1) {
+        std::deque<Chunk>& chunks = series_[IndexOf(bits)];
+        if (chunks.empty() || kChunkSamples <= chunks.back().count) {
+            // Заполненный блок больше не изменяется - освобождаем запас памяти вектора
+            if (!chunks.empty()) chunks.back().bits.shrink_to_fit();
+            chunks.emplace_back();
+            chunks.back().count = 0;
+            chunks.back().size = 0;
+        }
+
+        Encode(chunks.back(), time, values[IndexOf(bits)]);
+
+        while (1 < chunks.size() && chunks.front().last < expired) chunks.pop_front();
+    }
+}
+
+bool History::Query(uint32_t counter, double from, double to, size_t buckets, Range& range) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (0 == counter || to < from) return false;
+
+    const std::deque<Chunk>& chunks = series_[IndexOf(counter)];
+    if (chunks.empty()) return false;
+
+    const int64_t first = static_cast<int64_t>(std::ceil(from));
+    const int64_t last = static_cast<int64_t>(std::floor(to));
+    range = Range();
+
+    if (0 == buckets) {
+        for (const Chunk& chunk : chunks) {
+            if (chunk.last < first || chunk.first > last) continue;
+            Decode(chunk, first, last, [&range](int64_t timestamp, double value) {
+                range.timestamps.push_back(static_cast<double>(timestamp));
+                range.values.push_back(value);
+            });
+        }
+        return true;
+    }
+
+    // Прореживание: интервал делится на равные части, для каждой - минимум, максимум и среднее
+    const double width = std::max((to - from) / static_cast<double>(buckets), 1.);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> counts(buckets, 0.);
+    range.timestamps.resize(buckets);
+    range.values.assign(buckets, 0.);
+    range.min.assign(buckets, nan);
+    range.max.assign(buckets, nan);
+    for (size_t i = 0; i < buckets; ++i) range.timestamps[i] = from + static_cast<double>(i) * width;
+
+    for (const Chunk& chunk : chunks) {
+        if (chunk.last < first || chunk.first > last) continue;
+        Decode(chunk, first, last, [&](int64_t timestamp, double value) {
+            const size_t i = std::min(static_cast<size_t>((static_cast<double>(timestamp) - from) / width), buckets - 1);
+            range.values[i] += value;
+            range.min[i] = 0. == counts[i] ? value : std::min(range.min[i], value);
+            range.max[i] = 0. == counts[i] ? value : std::max(range.max[i], value);
+            counts[i] += 1.;
+        });
+    }
+
+    for (size_t i = 0; i < buckets; ++i)
+        range.values[i] = 0. == counts[i] ? nan : range.values[i] / counts[i];
+
+    return true;
+}
+
+History::Usage History::GetUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Usage usage = { 0., 0., 0. };
+    for (const auto& chunks : series_) {
+        if (chunks.empty()) continue;
+        usage.series += 1.;
+        for (const Chunk& chunk : chunks) {
+            usage.samples += chunk.count;
+            usage.bytes += static_cast<double>((chunk.size + 7) / 8);
+        }
+    }
+
+    return usage;
+}
+
+void History::Write(Chunk& chunk, uint64_t value, uint32_t count)
+{
+    if (64 > count) value &= (uint64_t(1) << count) - 1;
+
+    const uint32_t offset = static_cast<uint32_t>(chunk.size & 63);
+    if (0 == offset) chunk.bits.push_back(0);
+
+    const uint32_t free = 64 - offset;
+    if (count <= free) {
+        chunk.bits.back() |= value << (free - count);
+    }
+    else {
+        chunk.bits.back() |= value >> (count - free);
+        chunk.bits.push_back(value << (64 - (count - free)));
+    }
+
+    chunk.size += count;
+}
+
+void History::Encode(Chunk& chunk, int64_t timestamp, double value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    // Первое значение блока записывается целиком, метка времени хранится в заголовке
+    if (0 == chunk.count) {
+        chunk.first = timestamp;
+        chunk.last = timestamp;
+        chunk.delta = 0;
+        chunk.value = bits;
+        chunk.leading = kNoBlock;
+        chunk.trailing = 0;
+        Write(chunk, bits, 64);
+        chunk.count = 1;
+        return;
+    }
+
+    // Метка времени: разность разностей, при постоянном интервале опроса - один нулевой бит
+    const int64_t delta = timestamp - chunk.last;
+    const int64_t dod = delta - chunk.delta;
+    if (0 == dod) {
+        Write(chunk, 0, 1);
+    }
+    else if (-63 <= dod && 64 >= dod) {
+        Write(chunk, 2, 2);
+        Write(chunk, static_cast<uint64_t>(dod + 63), 7);
+    }
+    else if (-255 <= dod && 256 >= dod) {
+        Write(chunk, 6, 3);
+        Write(chunk, static_cast<uint64_t>(dod + 255), 9);
+    }
+    else if (-2047 <= dod && 2048 >= dod) {
+        Write(chunk, 14, 4);
+        Write(chunk, static_cast<uint64_t>(dod + 2047), 12);
+    }
+    else {
+        Write(chunk, 15, 4);
+        Write(chunk, static_cast<uint64_t>(dod), 64);
+    }
+
+    // Значение: XOR с предыдущим; если значащие биты помещаются в блок предыдущего XOR,
+    // записываются только они, иначе - новые границы блока и значащие биты
+    const uint64_t xored = bits ^ chunk.value;
+    if (0 == xored) {
+        Write(chunk, 0, 1);
+    }
+    else {
+        const uint32_t leading = std::min(CountLeadingZeros(xored), kMaxLeading);
+        const uint32_t trailing = CountTrailingZeros(xored);
+        if (kNoBlock != chunk.leading && leading >= chunk.leading && trailing >= chunk.trailing) {
+            Write(chunk, 2, 2);
+            Write(chunk, xored >> chunk.trailing, 64 - chunk.leading - chunk.trailing);
+        }
+        else {
+            const uint32_t significant = 64 - leading - trailing;
+            Write(chunk, 3, 2);
+            Write(chunk, leading, 5);
+            Write(chunk, significant - 1, 6);
+            Write(chunk, xored >> trailing, significant);
+            chunk.leading = leading;
+            chunk.trailing = trailing;
+        }
+    }
+
+    chunk.last = timestamp;
+    chunk.delta = delta;
+    chunk.value = bits;
+    ++chunk.count;
+}
+
+template <typename Fn>
+void History::Decode(const Chunk& chunk, int64_t from, int64_t to, Fn fn)
+{
+    BitReader reader(chunk.bits);
+    int64_t timestamp = chunk.first;
+    int64_t delta = 0;
+    uint64_t bits = reader.Read(64);
+    uint32_t leading = 0;
+    uint32_t trailing = 0;
+
+    for (uint32_t i = 0; i < chunk.count; ++i) {
+        if (0 != i) {
+            int64_t dod = 0;
+            if (!reader.ReadBit()) dod = 0;
+            else if (!reader.ReadBit()) dod = static_cast<int64_t>(reader.Read(7)) - 63;
+            else if (!reader.ReadBit()) dod = static_cast<int64_t>(reader.Read(9)) - 255;
+            else if (!reader.ReadBit()) dod = static_cast<int64_t>(reader.Read(12)) - 2047;
+            else dod = static_cast<int64_t>(reader.Read(64));
+            delta += dod;
+            timestamp += delta;
+
+            if (reader.ReadBit()) {
+                if (reader.ReadBit()) {
+                    leading = static_cast<uint32_t>(reader.Read(5));
+                    trailing = 64 - leading - static_cast<uint32_t>(reader.Read(6) + 1);
+                }
+                bits ^= reader.Read(64 - leading - trailing) << trailing;
+            }
+        }
+
+        if (timestamp > to) break;
+        if (timestamp < from) continue;
+
+        double value = 0.;
+        std::memcpy(&value, &bits, sizeof(value));
+        fn(timestamp, value);
+    }
+}
+
+} // namespace testtools
@@ -0,0 +1,131 @@
+/// @file
+/// Объявление сжатого хранилища истории значений счетчиков.
+
+#pragma once
+
+#ifndef TESTTOOLS_HISTORY_H
+#define TESTTOOLS_HISTORY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace testtools
+{
+
+/// История значений счетчиков (временные ряды), сжатая алгоритмом Gorilla (Facebook):
+/// время опроса кодируется разностью разностей соседних меток, значение - операцией XOR
+/// с предыдущим значением, из которой записываются только значащие биты. При опросе
+/// с постоянным интервалом на одно значение приходится в среднем несколько байт.
+///
+/// Каждый ряд хранится блоками по @e kChunkSamples значений; блоки, целиком вышедшие
+/// за пределы срока хранения, удаляются. При запросе распаковываются только блоки,
+/// пересекающиеся с запрошенным интервалом времени.
+class History final
+{
+public:
+    /// Максимальное количество счетчиков (разрядность маски)
+    static const size_t kMaxCounters = 32;
+    /// Количество значений в блоке
+    static const uint32_t kChunkSamples = 1024;
+
+    /// Результат запроса интервала ряда
+    struct Range
+    {
+        std::vector<double> timestamps;     ///< Метки времени значений или начала интервалов прореживания
+        std::vector<double> values;         ///< Значения или средние значения в интервалах (NaN - нет значений)
+        std::vector<double> min;            ///< Минимумы в интервалах (только при прореживании)
+        std::vector<double> max;            ///< Максимумы в интервалах (только при прореживании)
+    };
+
+    /// Объем хранимых данных
+    struct Usage
+    {
+        double series;      ///< Количество рядов
+        double samples;     ///< Количество значений
+        double bytes;       ///< Объем сжатых данных в байтах
+    };
+
+public:
+    History() = default;
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+    ~History() = default;
+
+    /// Задает срок хранения истории, удаляя накопленные значения
+    /// @param[in] retention Срок хранения в миллисекундах (@b 0 отключает историю)
+    void Configure(double retention);
+
+    /// Проверяет, ведется ли история
+    inline bool IsEnabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /// Добавляет значения счетчиков одного опроса
+    /// @param[in] timestamp Время опроса в миллисекундах с начала эпохи UNIX
+    /// @param[in] mask Маска счетчиков, значения которых присутствуют
+    /// @param[in] values Значения счетчиков по номеру бита в маске
+    void Add(double timestamp, uint32_t mask, const double* values);
+
+    /// Возвращает значения ряда счетчика в интервале времени
+    /// @param[in] counter Счетчик (один бит маски)
+    /// @param[in] from Начало интервала в миллисекундах с начала эпохи UNIX
+    /// @param[in] to Конец интервала (включительно)
+    /// @param[in] buckets Количество интервалов прореживания (@b 0 - вернуть все значения)
+    /// @param[out] range Значения ряда
+    /// @return @b false, если значений счетчика нет
+    bool Query(uint32_t counter, double from, double to, size_t buckets, Range& range) const;
+
+    /// Возвращает объем хранимых данных
+    Usage GetUsage() const;
+
+private:
+    /// Блок ряда: последовательность бит со сжатыми значениями и состояние кодирования
+    struct Chunk
+    {
+        int64_t first;                  ///< Метка времени первого значения
+        int64_t last;                   ///< Метка времени последнего значения
+        uint32_t count;                 ///< Количество значений
+        std::vector<uint64_t> bits;     ///< Сжатые значения
+        uint64_t size;                  ///< Количество записанных бит
+        int64_t delta;                  ///< Разность двух последних меток времени
+        uint64_t value;                 ///< Последнее значение (биты double)
+        uint32_t leading;               ///< Количество старших нулевых бит последнего XOR
+        uint32_t trailing;              ///< Количество младших нулевых бит последнего XOR
+    };
+
+    /// Записывает младшие биты значения в конец блока
+    /// @param[in,out] chunk Блок
+    /// @param[in] value Значение
+    /// @param[in] count Количество бит (от 1 до 64)
+    static void Write(Chunk& chunk, uint64_t value, uint32_t count);
+    /// Кодирует значение в блок
+    /// @param[in,out] chunk Блок
+    /// @param[in] timestamp Метка времени
+    /// @param[in] value Значение
+    static void Encode(Chunk& chunk, int64_t timestamp, double value);
+    /// Распаковывает значения блока в интервале времени
+    /// @param[in] chunk Блок
+    /// @param[in] from Начало интервала
+    /// @param[in] to Конец интервала (включительно)
+    /// @param[in] fn Функция, вызываемая для каждого значения: fn(timestamp, value)
+    template <typename Fn>
+    static void Decode(const Chunk& chunk, int64_t from, int64_t to, Fn fn);
+
+private:
+    /// Блокировка истории (значения добавляются из потока опроса, а читаются из пула потоков)
+    mutable std::mutex mutex_;
+    /// История ведется (задан срок хранения)
+    std::atomic<bool> enabled_{ false };
+    /// Срок хранения в миллисекундах
+    double retention_ = 0.;
+    /// Блоки рядов по номеру бита счетчика
+    std::array<std::deque<Chunk>, kMaxCounters> series_;
+}; // class History
+
+} // namespace testtools
+
+#endif // TESTTOOLS_HISTORY_H
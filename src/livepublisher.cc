@@ -0,0 +1,80 @@
+/// @file
+/// Реализация публикации результатов опроса в сегмент разделяемой памяти (общая часть).
+
+#include "livepublisher.h"
+
+#include <algorithm>
+
+namespace testtools
+{
+
+LivePublisher::LivePublisher(const std::string& name, uint8_t type, AbstractObserver::Mask mask, double interval)
+    : name_(name)
+    , header_(nullptr)
+    , slots_(nullptr)
+#if defined(TESTTOOLS_WIN)
+    , mapping_(nullptr)
+#elif defined(TESTTOOLS_LINUX)
+    , fd_(-1)
+#endif
+{
+    const bool valid = !name.empty() && 200 > name.size() && name.end() == std::find_if(name.begin(), name.end(),
+        [](char c) { return !(('a' <= c && 'z' >= c) || ('A' <= c && 'Z' >= c) || ('0' <= c && '9' >= c)
+            || '-' == c || '_' == c || '.' == c); });
+    if (!valid) throw AbstractObserver::Exception("Invalid live segment name: " + name);
+
+    Create();
+    slots_ = reinterpret_cast<live::Slot*>(header_ + 1);
+
+    // Сегмент мог остаться от аварийно завершенного процесса: счетчик seqlock продолжается
+    // с ближайшего четного значения, чтобы уже открытые отображения не ждали завершения записи.
+    // Сигнатура записывается последней - до этого сегмент не открывается для чтения.
+    std::memset(header_->magic, 0, sizeof(header_->magic));
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->version = live::kVersion;
+    header_->type = type;
+    header_->mask = mask;
+    header_->slots = live::kSlots;
+    header_->closed.store(0, std::memory_order_relaxed);
+    header_->sequence.store((header_->sequence.load(std::memory_order_relaxed) + 1) & ~uint64_t(1),
+        std::memory_order_relaxed);
+    header_->count = 0;
+    header_->total = 0;
+    header_->interval = interval;
+    std::memset(header_->reserved, 0, sizeof(header_->reserved));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, live::kMagic, sizeof(live::kMagic));
+}
+
+LivePublisher::~LivePublisher()
+{
+    header_->closed.store(1, std::memory_order_release);
+    Destroy();
+}
+
+void LivePublisher::Publish(const std::vector<AbstractObserver::Sample>& samples) noexcept
+{
+    Store(*header_, slots_, samples);
+}
+
+void LivePublisher::Store(live::Header& header, live::Slot* slots,
+    const std::vector<AbstractObserver::Sample>& samples) noexcept
+{
+    const uint64_t sequence = live::BeginWrite(header);
+
+    const size_t count = std::min(samples.size(), static_cast<size_t>(live::kSlots));
+    for (size_t i = 0; i < count; ++i) {
+        const AbstractObserver::Sample& sample = samples[i];
+        live::Slot& slot = slots[i];
+        slot.timestamp = sample.timestamp;
+        slot.pid = sample.pid;
+        slot.mask = sample.mask;
+        slot.triggered = sample.triggered ? 1 : 0;
+        slot.reserved = 0;
+        std::memcpy(slot.values, sample.values.data(), sizeof(slot.values));
+    }
+
+    live::EndWrite(header, sequence, static_cast<uint32_t>(count), static_cast<uint32_t>(samples.size()));
+}
+
+} // namespace testtools
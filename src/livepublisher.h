@@ -0,0 +1,76 @@
+/// @file
+/// Объявление публикации результатов опроса в сегмент разделяемой памяти.
+
+#pragma once
+
+#ifndef TESTTOOLS_LIVEPUBLISHER_H
+#define TESTTOOLS_LIVEPUBLISHER_H
+
+#include "abstractobserver.h"
+#include "livesegment.h"
+
+#include <string>
+#include <vector>
+
+namespace testtools
+{
+
+/// Публикация результатов последнего опроса в именованный сегмент разделяемой памяти
+/// (формат и чтение - см. livesegment.h). Другие процессы на том же компьютере читают
+/// результаты из сегмента без собственного опроса счетчиков и без обращения к процессу
+/// публикации. Публикацию с одним именем может вести только один процесс; при уничтожении
+/// объекта сегмент помечается закрытым и удаляется.
+class LivePublisher final
+{
+public:
+    /// Создает сегмент
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] name Имя сегмента (латинские буквы, цифры, '-', '_' и '.')
+    /// @param[in] type Тип наблюдателя
+    /// @param[in] mask Маска опрашиваемых счетчиков
+    /// @param[in] interval Интервал опроса в миллисекундах
+    LivePublisher(const std::string& name, uint8_t type, AbstractObserver::Mask mask, double interval);
+    LivePublisher(const LivePublisher&) = delete;
+    LivePublisher& operator=(const LivePublisher&) = delete;
+    ~LivePublisher();
+
+    /// Публикует результаты опроса, заменяя предыдущие (вызывается только одним потоком).
+    /// Если результатов больше live::kSlots, публикуются только первые из них.
+    /// @param[in] samples Результаты опроса
+    void Publish(const std::vector<AbstractObserver::Sample>& samples) noexcept;
+
+    /// Записывает результаты опроса в места сегмента под защитой seqlock
+    /// (используется и для сегментов в памяти процесса, см. Sampler#GetLatest)
+    /// @param[in,out] header Заголовок
+    /// @param[out] slots Места для результатов опроса (live::kSlots)
+    /// @param[in] samples Результаты опроса
+    static void Store(live::Header& header, live::Slot* slots,
+        const std::vector<AbstractObserver::Sample>& samples) noexcept;
+
+private:
+    /// Создает объект разделяемой памяти и отображает его (заполняет header_ и writer)
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    void Create();
+    /// Освобождает отображение и удаляет объект разделяемой памяти
+    void Destroy() noexcept;
+
+private:
+    /// Имя сегмента
+    std::string name_;
+    /// Заголовок сегмента
+    live::Header* header_;
+    /// Места для результатов опроса
+    live::Slot* slots_;
+
+#if defined(TESTTOOLS_WIN)
+    /// Дескриптор объекта отображения
+    HANDLE mapping_;
+#elif defined(TESTTOOLS_LINUX)
+    /// Дескриптор объекта разделяемой памяти
+    int fd_;
+#endif
+}; // class LivePublisher
+
+} // namespace testtools
+
+#endif // TESTTOOLS_LIVEPUBLISHER_H
@@ -0,0 +1,53 @@
+/// @file
+/// Реализация публикации результатов опроса в сегмент разделяемой памяти для Linux.
+
+#include "livepublisher.h"
+
+#include <fcntl.h> // O_RDWR, O_CREAT
+#include <unistd.h> // close, ftruncate, getpid
+#include <sys/file.h> // flock
+#include <sys/mman.h> // shm_open, shm_unlink, mmap, munmap
+
+namespace testtools
+{
+
+void LivePublisher::Create()
+{
+    // Сегмент доступен для чтения всем пользователям, как и /proc
+    const std::string object = live::GetObjectName(name_);
+    fd_ = ::shm_open(object.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (-1 == fd_) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    try {
+        if (-1 == ::flock(fd_, LOCK_EX | LOCK_NB)) {
+            if (EWOULDBLOCK == errno) throw AbstractObserver::Exception("Live segment is used by another process: " + name_);
+            throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+        }
+
+        if (-1 == ::ftruncate(fd_, static_cast<off_t>(live::kSize)))
+            throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+        void* data = ::mmap(nullptr, live::kSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (MAP_FAILED == data) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+        header_ = static_cast<live::Header*>(data);
+        header_->writer = static_cast<uint32_t>(::getpid());
+    }
+    catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+}
+
+void LivePublisher::Destroy() noexcept
+{
+    // Объект удаляется до снятия блокировки, чтобы не удалить сегмент новой публикации
+    ::munmap(header_, live::kSize);
+    ::shm_unlink(live::GetObjectName(name_).c_str());
+    ::close(fd_);
+    header_ = nullptr;
+    fd_ = -1;
+}
+
+} // namespace testtools
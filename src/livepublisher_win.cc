@@ -0,0 +1,44 @@
+/// @file
+/// Реализация публикации результатов опроса в сегмент разделяемой памяти для Windows.
+
+#include "livepublisher.h"
+
+namespace testtools
+{
+
+void LivePublisher::Create()
+{
+    mapping_ = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+        static_cast<DWORD>(live::kSize), live::GetObjectName(name_).c_str());
+    if (nullptr == mapping_) throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+    const bool existing = ERROR_ALREADY_EXISTS == ::GetLastError();
+
+    void* data = ::MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, live::kSize);
+    if (nullptr == data) {
+        const DWORD error = ::GetLastError();
+        ::CloseHandle(mapping_);
+        mapping_ = nullptr;
+        throw AbstractObserver::SystemError(static_cast<errno_t>(error));
+    }
+
+    // Объект существует, пока открыт хотя бы один его дескриптор или отображение: существующий
+    // объект можно использовать повторно, только если прежняя публикация закрыла его, а читатели
+    // еще не освободили отображения
+    header_ = static_cast<live::Header*>(data);
+    if (existing && 0 == header_->closed.load(std::memory_order_acquire)) {
+        Destroy();
+        throw AbstractObserver::Exception("Live segment is used by another process: " + name_);
+    }
+
+    header_->writer = static_cast<uint32_t>(::GetCurrentProcessId());
+}
+
+void LivePublisher::Destroy() noexcept
+{
+    ::UnmapViewOfFile(header_);
+    ::CloseHandle(mapping_);
+    header_ = nullptr;
+    mapping_ = nullptr;
+}
+
+} // namespace testtools
@@ -0,0 +1,241 @@
+/// @file
+/// Формат сегмента разделяемой памяти с последними результатами опроса и чтение из него.
+///
+/// Заголовочный файл самодостаточен (зависит только от стандартной библиотеки и ОС),
+/// поэтому его можно подключать в другие программы для чтения результатов опроса,
+/// публикуемых модулем, без собственного опроса счетчиков. Платформа определяется
+/// по макросам компилятора, а не по TESTTOOLS_WIN/TESTTOOLS_LINUX.
+
+#pragma once
+
+#ifndef TESTTOOLS_LIVESEGMENT_H
+#define TESTTOOLS_LIVESEGMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h> // O_RDONLY
+#include <unistd.h> // close
+#include <sys/mman.h> // shm_open, mmap, munmap
+#include <sys/stat.h> // fstat
+#endif
+
+namespace testtools
+{
+
+/// Сегмент разделяемой памяти с последними результатами опроса
+namespace live
+{
+
+/// Версия формата сегмента
+const uint32_t kVersion = 1;
+/// Максимальное количество результатов одного опроса в сегменте
+const uint32_t kSlots = 256;
+/// Максимальное количество счетчиков (разрядность маски)
+const size_t kMaxCounters = 32;
+
+/// Заголовок сегмента
+struct Header
+{
+    char magic[8];                      ///< Сигнатура "TTLIVE" (записывается последней)
+    uint32_t version;                   ///< Версия формата
+    uint32_t type;                      ///< Тип наблюдателя (AbstractObserver::Type)
+    uint32_t mask;                      ///< Маска опрашиваемых счетчиков
+    uint32_t slots;                     ///< Количество мест для результатов опроса
+    uint32_t writer;                    ///< Идентификатор процесса, публикующего результаты
+    std::atomic<uint32_t> closed;       ///< Публикация прекращена, сегмент удален (@b 1)
+    std::atomic<uint64_t> sequence;     ///< Счетчик seqlock: нечетный, пока результаты изменяются
+    uint32_t count;                     ///< Количество результатов последнего опроса в сегменте
+    uint32_t total;                     ///< Количество результатов последнего опроса (может превышать slots)
+    double interval;                    ///< Интервал опроса в миллисекундах
+    uint8_t reserved[8];                ///< Резерв
+};
+
+/// Результат опроса
+struct Slot
+{
+    double timestamp;                   ///< Время опроса в миллисекундах с начала эпохи UNIX
+    uint32_t pid;                       ///< Идентификатор процесса (@b 0 для системы и группы процессов)
+    uint32_t mask;                      ///< Маска счетчиков, значения которых присутствуют
+    uint32_t triggered;                 ///< Внеочередной опрос по триггеру (@b 1)
+    uint32_t reserved;                  ///< Резерв
+    double values[kMaxCounters];        ///< Значения счетчиков по номеру бита в маске
+};
+
+static_assert(64 == sizeof(Header), "Invalid live segment header size");
+
+/// Сигнатура сегмента
+const char kMagic[8] = { 'T', 'T', 'L', 'I', 'V', 'E', '\0', '\0' };
+
+/// Размер сегмента в байтах
+const size_t kSize = sizeof(Header) + kSlots * sizeof(Slot);
+
+/// Возвращает имя объекта разделяемой памяти по имени сегмента
+/// @param[in] name Имя сегмента
+/// @return Имя объекта разделяемой памяти ("/testtools-<имя>" или "Local\testtools-<имя>")
+inline std::string GetObjectName(const std::string& name)
+{
+#if defined(_WIN32)
+    return "Local\\testtools-" + name;
+#else
+    return "/testtools-" + name;
+#endif
+}
+
+/// Согласованный снимок результатов последнего опроса
+struct Snapshot
+{
+    uint32_t type;                      ///< Тип наблюдателя
+    uint32_t mask;                      ///< Маска опрашиваемых счетчиков
+    uint32_t total;                     ///< Количество результатов опроса (может превышать samples.size())
+    uint64_t sequence;                  ///< Номер публикации (растет с каждым опросом)
+    double interval;                    ///< Интервал опроса в миллисекундах
+    std::vector<Slot> samples;          ///< Результаты опроса
+};
+
+/// Начинает изменение результатов опроса (вызывается только потоком публикации):
+/// нечетное значение счетчика seqlock сообщает читателям, что результаты изменяются
+/// @param[in,out] header Заголовок
+/// @return Значение счетчика до изменения
+inline uint64_t BeginWrite(Header& header) noexcept
+{
+    const uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+/// Завершает изменение результатов опроса
+/// @param[in,out] header Заголовок
+/// @param[in] sequence Значение, возвращенное BeginWrite
+/// @param[in] count Количество записанных результатов
+/// @param[in] total Количество результатов опроса
+inline void EndWrite(Header& header, uint64_t sequence, uint32_t count, uint32_t total) noexcept
+{
+    header.count = count;
+    header.total = total;
+    header.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/// Копирует согласованный снимок результатов опроса: копирование повторяется,
+/// если результаты изменились во время него
+/// @param[in] header Заголовок
+/// @param[in] slots Места для результатов опроса (live::kSlots)
+/// @param[out] snapshot Снимок
+inline void ReadSnapshot(const Header& header, const Slot* slots, Snapshot& snapshot)
+{
+    for (uint32_t attempt = 0; ; ++attempt) {
+        const uint64_t before = header.sequence.load(std::memory_order_acquire);
+        if (0 == (before & 1)) {
+            const uint32_t count = header.count < kSlots ? header.count : kSlots;
+            snapshot.type = header.type;
+            snapshot.mask = header.mask;
+            snapshot.total = header.total;
+            snapshot.interval = header.interval;
+            snapshot.samples.resize(count);
+            if (0 != count) std::memcpy(snapshot.samples.data(), slots, count * sizeof(Slot));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header.sequence.load(std::memory_order_relaxed) == before) {
+                snapshot.sequence = before / 2;
+                return;
+            }
+        }
+
+        // Публикация занимает микросекунды; если поток публикации был вытеснен посередине,
+        // отдаем процессор, а не крутимся впустую
+        if (64 <= attempt) std::this_thread::yield();
+    }
+}
+
+/// Чтение сегмента. После открытия чтение не выполняет системных вызовов: снимок
+/// копируется из отображения сегмента и повторяется, если публикация изменила его
+/// во время копирования (seqlock). Объект используется одним потоком.
+class Reader final
+{
+public:
+    Reader() noexcept : header_(nullptr) {}
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { Close(); }
+
+    /// Открывает сегмент
+    /// @param[in] name Имя сегмента
+    /// @return @b false, если сегмент не существует или еще не инициализирован
+    bool Open(const std::string& name)
+    {
+        Close();
+        void* data = nullptr;
+#if defined(_WIN32)
+        HANDLE mapping = ::OpenFileMappingA(FILE_MAP_READ, FALSE, GetObjectName(name).c_str());
+        if (nullptr == mapping) return false;
+        data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, kSize);
+        ::CloseHandle(mapping);
+        if (nullptr == data) return false;
+#else
+        const int fd = ::shm_open(GetObjectName(name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (-1 == fd) return false;
+        struct stat info = {};
+        if (-1 == ::fstat(fd, &info) || kSize > static_cast<size_t>(info.st_size)) {
+            ::close(fd);
+            return false;
+        }
+        data = ::mmap(nullptr, kSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (MAP_FAILED == data) return false;
+#endif
+
+        header_ = static_cast<const Header*>(data);
+        if (0 != std::memcmp(header_->magic, kMagic, sizeof(kMagic)) || kVersion != header_->version
+            || kSlots != header_->slots) {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    /// Закрывает сегмент
+    void Close() noexcept
+    {
+        if (nullptr == header_) return;
+#if defined(_WIN32)
+        ::UnmapViewOfFile(header_);
+#else
+        ::munmap(const_cast<Header*>(header_), kSize);
+#endif
+        header_ = nullptr;
+    }
+
+    /// Проверяет, открыт ли сегмент
+    inline bool IsOpen() const noexcept { return nullptr != header_; }
+
+    /// Копирует результаты последнего опроса
+    /// @param[out] snapshot Снимок
+    /// @return @b false, если сегмент не открыт или публикация прекращена (его нужно открыть заново)
+    bool Read(Snapshot& snapshot) const
+    {
+        if (nullptr == header_ || 0 != header_->closed.load(std::memory_order_acquire)) return false;
+
+        ReadSnapshot(*header_, reinterpret_cast<const Slot*>(header_ + 1), snapshot);
+        return true;
+    }
+
+private:
+    /// Отображение сегмента
+    const Header* header_;
+}; // class Reader
+
+} // namespace live
+
+} // namespace testtools
+
+#endif // TESTTOOLS_LIVESEGMENT_H
@@ -5,6 +5,11 @@
 
 #include "systemobserver.h"
 #include "processobserver.h"
+#include "cgroupobserver.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
 
 /// Возвращает ссылку на реализацию наблюдателя
 #define IPTR(obj) (obj)->impl_.get()
@@ -16,6 +21,8 @@
 #define JSNUM(num) Nan::New<v8::Number>((num))
 /// Ковертирует объект класса v8::Number в uint32_t
 #define JSNUM2UINT32(var) Nan::To<uint32_t>((var)).FromJust()
+/// Возвращает количество элементов массива
+#define COUNTOF(arr) (sizeof(arr) / sizeof((arr)[0]))
 
 namespace testtools
 {
@@ -38,6 +45,306 @@ using Nan::AsyncWorker;
 namespace
 {
 
+/// Ключи значений счетчиков наблюдателя за системой (по номеру бита счетчика в маске)
+const char* const kSystemKeys[] = {
+    "processes", "threads", "procusage", "pmemusage", "pmemusagekb", "vmemusage", "vmemusagekb", "diskusage",
+    "cpupressure", "cpupressurefull", "mempressure", "mempressurefull", "iopressure", "iopressurefull"
+};
+/// Ключи значений счетчиков наблюдателя за процессами (по номеру бита счетчика в маске)
+const char* const kProcessKeys[] = {
+    "handles", "threads", "procusage", "pmemusage", "pmemusagekb", "vmemusage", "vmemusagekb"
+};
+
+/// Ключи значений счетчиков наблюдателя за группой процессов cgroup (по номеру бита счетчика в маске)
+const char* const kCGroupKeys[] = {
+    "processes", "procusage", "pmemusage", "pmemusagekb", "readkb", "writekb"
+};
+
+/// Ключи свойств объектов списка процессов (в порядке их заполнения)
+const char* const kProcessListKeys[] = {
+    "pid", "ppid", "name", "path", "owner", "priority", "status",
+    "threads", "handles", "ktime", "utime", "start", "pmemory", "vmemory"
+};
+
+/// Ключи свойств объектов списка потоков процесса (в порядке их заполнения)
+const char* const kThreadKeys[] = { "tid", "name", "procusage" };
+/// Ключи свойств объектов сетевых интерфейсов (в порядке полей SystemObserver::NetworkSample)
+const char* const kNetworkKeys[] = {
+    "name", "rxkb", "txkb", "rxpackets", "txpackets", "rxdrops", "txdrops", "rxerrors", "txerrors"
+};
+/// Ключи свойств объекта результата pollNetwork
+const char* const kNetworkResultKeys[] = { "total", "interfaces" };
+/// Ключи свойств объекта результата pollPressure (в порядке SystemObserver::PressureResource)
+const char* const kPressureKeys[] = { "cpu", "memory", "io" };
+static_assert(SystemObserver::PressureResourceCount == COUNTOF(kPressureKeys), "Invalid pressure keys count");
+/// Ключи свойств объекта ресурса PSI
+const char* const kPressureLineKeys[] = { "some", "full" };
+/// Ключи свойств объекта строки PSI
+const char* const kPressureValueKeys[] = { "avg10", "avg60", "avg300", "total" };
+/// Ключи свойств объектов списка дисковых устройств (в порядке полей SystemObserver::DiskSample)
+const char* const kDiskKeys[] = {
+    "name", "reads", "writes", "readkb", "writekb", "readlatency", "writelatency", "usage"
+};
+
+/// Ключи свойств объекта статистики счетчика (в порядке полей Summary::Result)
+const char* const kSummaryKeys[] = { "count", "min", "max", "mean", "ewma", "p50", "p90", "p95", "p99" };
+
+/// Ключи свойств объекта интервала истории счетчика (в порядке полей History::Range)
+const char* const kHistoryKeys[] = { "timestamps", "values", "min", "max" };
+
+/// Ключи свойств объекта объема истории (в порядке полей History::Usage)
+const char* const kHistoryUsageKeys[] = { "series", "samples", "bytes" };
+
+/// Ключи свойств объекта файла результатов опроса
+const char* const kSampleFileKeys[] = { "type", "mask", "stride", "capacity", "first", "count", "data" };
+
+/// Ключи свойств объекта результатов опроса из разделяемой памяти
+const char* const kSharedKeys[] = { "type", "mask", "total", "sequence", "interval", "samples" };
+
+/// Интернированные строки ключей значений счетчиков наблюдателя за системой
+Nan::Persistent<String> systemKeys[COUNTOF(kSystemKeys)];
+/// Интернированные строки ключей значений счетчиков наблюдателя за процессами
+Nan::Persistent<String> processKeys[COUNTOF(kProcessKeys)];
+/// Интернированные строки ключей значений счетчиков наблюдателя за группой процессов cgroup
+Nan::Persistent<String> cgroupKeys[COUNTOF(kCGroupKeys)];
+/// Интернированные строки ключей свойств объектов списка процессов
+Nan::Persistent<String> processListKeys[COUNTOF(kProcessListKeys)];
+/// Интернированные строки ключей свойств объектов списка потоков процесса
+Nan::Persistent<String> threadKeys[COUNTOF(kThreadKeys)];
+/// Интернированные строки ключей свойств объектов сетевых интерфейсов
+Nan::Persistent<String> networkKeys[COUNTOF(kNetworkKeys)];
+/// Интернированные строки ключей свойств объекта результата pollNetwork
+Nan::Persistent<String> networkResultKeys[COUNTOF(kNetworkResultKeys)];
+/// Интернированные строки ключей свойств объекта результата pollPressure
+Nan::Persistent<String> pressureKeys[COUNTOF(kPressureKeys)];
+/// Интернированные строки ключей свойств объекта ресурса PSI
+Nan::Persistent<String> pressureLineKeys[COUNTOF(kPressureLineKeys)];
+/// Интернированные строки ключей свойств объекта строки PSI
+Nan::Persistent<String> pressureValueKeys[COUNTOF(kPressureValueKeys)];
+/// Интернированные строки ключей свойств объектов списка дисковых устройств
+Nan::Persistent<String> diskKeys[COUNTOF(kDiskKeys)];
+/// Интернированные строки ключей свойств объекта статистики счетчика
+Nan::Persistent<String> summaryKeys[COUNTOF(kSummaryKeys)];
+/// Интернированные строки ключей свойств объекта интервала истории счетчика
+Nan::Persistent<String> historyKeys[COUNTOF(kHistoryKeys)];
+/// Интернированные строки ключей свойств объекта объема истории
+Nan::Persistent<String> historyUsageKeys[COUNTOF(kHistoryUsageKeys)];
+/// Интернированные строки ключей свойств объекта файла результатов опроса
+Nan::Persistent<String> sampleFileKeys[COUNTOF(kSampleFileKeys)];
+/// Интернированные строки ключей свойств объекта результатов опроса из разделяемой памяти
+Nan::Persistent<String> sharedKeys[COUNTOF(kSharedKeys)];
+/// Открытые сегменты разделяемой памяти по имени (используются только потоком Node.JS)
+std::unordered_map<std::string, std::unique_ptr<live::Reader>> sharedReaders;
+/// Интернированная строка ключа "pid"
+Nan::Persistent<String> pidKey;
+/// Интернированная строка ключа "timestamp"
+Nan::Persistent<String> timestampKey;
+/// Интернированная строка ключа "triggered"
+Nan::Persistent<String> triggeredKey;
+/// Шаблон объектов списка процессов: все объекты списка создаются с одним набором
+/// свойств в одном порядке и поэтому получают в V8 один скрытый класс
+Nan::Persistent<v8::ObjectTemplate> processTemplate;
+
+/// Создает интернированную строку
+/// @param[in] str Строка в кодировке UTF-8
+/// @return JS строка
+Local<String> Internalize(const char* str)
+{
+    return String::NewFromUtf8(v8::Isolate::GetCurrent(), str, v8::NewStringType::kInternalized).ToLocalChecked();
+}
+
+/// Создает интернированные строки ключей
+/// @param[in] keys Ключи
+/// @param[out] cache Строки ключей
+template <size_t Count>
+void InitializeKeys(const char* const (&keys)[Count], Nan::Persistent<String> (&cache)[Count])
+{
+    for (size_t i = 0; i < Count; ++i)
+        cache[i].Reset(Internalize(keys[i]));
+}
+
+/// Создает строки ключей и шаблоны JS объектов (вызывается один раз при инициализации модуля)
+void InitializeCache()
+{
+    InitializeKeys(kSystemKeys, systemKeys);
+    InitializeKeys(kProcessKeys, processKeys);
+    InitializeKeys(kCGroupKeys, cgroupKeys);
+    InitializeKeys(kProcessListKeys, processListKeys);
+    InitializeKeys(kThreadKeys, threadKeys);
+    InitializeKeys(kDiskKeys, diskKeys);
+    InitializeKeys(kNetworkKeys, networkKeys);
+    InitializeKeys(kNetworkResultKeys, networkResultKeys);
+    InitializeKeys(kPressureKeys, pressureKeys);
+    InitializeKeys(kPressureLineKeys, pressureLineKeys);
+    InitializeKeys(kPressureValueKeys, pressureValueKeys);
+    InitializeKeys(kSummaryKeys, summaryKeys);
+    InitializeKeys(kHistoryKeys, historyKeys);
+    InitializeKeys(kHistoryUsageKeys, historyUsageKeys);
+    InitializeKeys(kSampleFileKeys, sampleFileKeys);
+    InitializeKeys(kSharedKeys, sharedKeys);
+    pidKey.Reset(Internalize("pid"));
+    timestampKey.Reset(Internalize("timestamp"));
+    triggeredKey.Reset(Internalize("triggered"));
+
+    auto tpl = Nan::New<v8::ObjectTemplate>();
+    for (const auto& key : processListKeys)
+        tpl->Set(Nan::New(key), Nan::Null());
+    processTemplate.Reset(tpl);
+}
+
+/// Создает JS объект со значениями счетчиков в формате "счетчик=значение"
+/// @param[in] sample Результат опроса счетчиков
+/// @param[in] keys Строки ключей значений счетчиков по номеру бита в маске
+/// @param[in] mask Маска счетчиков, значения которых попадают в объект
+/// @return JS объект
+template <size_t Count>
+Local<Object> ToObject(const AbstractObserver::Sample& sample, const Nan::Persistent<String> (&keys)[Count],
+    AbstractObserver::Mask mask = ~0u)
+{
+    auto jsresult = Nan::New<Object>();
+    for (size_t i = 0; i < Count; ++i) {
+        if (sample.Has(mask & (1u << i))) Nan::Set(jsresult, Nan::New(keys[i]), JSNUM(sample.values[i]));
+    }
+
+    return jsresult;
+}
+
+/// Создает Float64Array с копией значений
+/// @param[in] values Значения
+/// @return JS массив
+Local<v8::Float64Array> ToFloat64Array(const std::vector<double>& values)
+{
+    const size_t count = values.size();
+    auto buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), count * sizeof(double));
+    auto jsresult = v8::Float64Array::New(buffer, 0, count);
+    if (0 != count) {
+        Nan::TypedArrayContents<double> contents(jsresult);
+        std::copy(values.begin(), values.end(), *contents);
+    }
+
+    return jsresult;
+}
+
+/// Создает Float64Array с записями файла результатов опроса без копирования: массив
+/// ссылается на отображение файла и удерживает его до сборки мусора
+/// @param[in] file Файл результатов опроса
+/// @return JS массив
+Local<v8::Float64Array> ToFloat64Array(const std::shared_ptr<SampleFile>& file)
+{
+    auto holder = new std::shared_ptr<SampleFile>(file);
+    auto jsbuffer = Nan::NewBuffer(reinterpret_cast<char*>(file->GetData()), file->GetSize(),
+        [](char*, void* hint) { delete static_cast<std::shared_ptr<SampleFile>*>(hint); }, holder).ToLocalChecked();
+
+    const auto view = jsbuffer.As<v8::Uint8Array>();
+    const SampleFile::Header& header = file->GetHeader();
+    return v8::Float64Array::New(view->Buffer(), view->ByteOffset() + SampleFile::kHeaderSize,
+        static_cast<size_t>(header.capacity * header.stride));
+}
+
+/// Создает JS объект с параметрами файла результатов опроса, диапазоном записей и массивом записей
+/// @param[in] file Файл результатов опроса
+/// @param[in] data Массив записей файла (см. ToFloat64Array)
+/// @return JS объект
+Local<Object> ToSampleView(const SampleFile& file, Local<v8::Float64Array> data)
+{
+    uint64_t first = 0;
+    uint64_t count = 0;
+    file.GetRange(first, count);
+
+    const SampleFile::Header& header = file.GetHeader();
+    const double values[] = {
+        static_cast<double>(header.type), static_cast<double>(header.mask), static_cast<double>(header.stride),
+        static_cast<double>(header.capacity), static_cast<double>(first), static_cast<double>(count)
+    };
+    auto jsresult = Nan::New<Object>();
+    for (size_t i = 0; i < COUNTOF(values); ++i)
+        Nan::Set(jsresult, Nan::New(sampleFileKeys[i]), JSNUM(values[i]));
+    Nan::Set(jsresult, Nan::New(sampleFileKeys[COUNTOF(values)]), data);
+
+    return jsresult;
+}
+
+/// Преобразует снимок результатов опроса из формата сегмента разделяемой памяти
+/// @param[in] snapshot Снимок результатов опроса
+/// @param[out] samples Результаты опроса
+void ToSamples(const live::Snapshot& snapshot, std::vector<AbstractObserver::Sample>& samples)
+{
+    samples.clear();
+    samples.reserve(snapshot.samples.size());
+    for (const live::Slot& slot : snapshot.samples) {
+        samples.emplace_back(slot.pid);
+        AbstractObserver::Sample& sample = samples.back();
+        sample.mask = slot.mask;
+        sample.timestamp = slot.timestamp;
+        sample.triggered = 0 != slot.triggered;
+        std::copy(slot.values, slot.values + live::kMaxCounters, sample.values.begin());
+    }
+}
+
+/// Проверяет, относятся ли результаты опроса наблюдателя к отдельным процессам
+/// @param[in] type Тип наблюдателя
+/// @return @b true для наблюдателей за процессами, @b false - за системой и группой процессов
+inline bool HasPid(uint8_t type) noexcept
+{
+    return AbstractObserver::ProcessId == type || AbstractObserver::ProcessName == type;
+}
+
+/// Создает JS объект со значениями счетчиков, идентификатором процесса и временем опроса
+/// @param[in] sample Результат опроса счетчиков
+/// @param[in] type Тип наблюдателя
+/// @return JS объект
+Local<Object> ToTimedObject(const AbstractObserver::Sample& sample, uint8_t type)
+{
+    auto jsresult = AbstractObserver::System == type ? ToObject(sample, systemKeys)
+        : (AbstractObserver::CGroup == type ? ToObject(sample, cgroupKeys) : ToObject(sample, processKeys));
+    Nan::Set(jsresult, Nan::New(pidKey), HasPid(type) ? Local<Value>(JSNUM(sample.pid)) : Local<Value>(Nan::Null()));
+    Nan::Set(jsresult, Nan::New(timestampKey), JSNUM(sample.timestamp));
+    Nan::Set(jsresult, Nan::New(triggeredKey), Nan::New<v8::Boolean>(sample.triggered));
+
+    return jsresult;
+}
+
+/// Создает JS значение с результатами опроса в формате метода @e poll:
+/// объект для наблюдателей за системой, процессом и группой процессов, массив объектов - для списка процессов
+/// @param[in] samples Результаты опроса счетчиков
+/// @param[in] type Тип наблюдателя
+/// @param[in] mask Маска счетчиков, значения которых попадают в результат
+/// @return JS значение
+Local<Value> ToResult(const std::vector<AbstractObserver::Sample>& samples, uint8_t type,
+    AbstractObserver::Mask mask = ~0u)
+{
+    if (AbstractObserver::System == type) {
+        auto jsresult = ToObject(samples.front(), systemKeys, mask);
+        Nan::Set(jsresult, Nan::New(pidKey), Nan::Null());
+        return jsresult;
+    }
+
+    if (AbstractObserver::CGroup == type) {
+        auto jsresult = ToObject(samples.front(), cgroupKeys, mask);
+        Nan::Set(jsresult, Nan::New(pidKey), Nan::Null());
+        return jsresult;
+    }
+
+    const auto jspid = Nan::New(pidKey);
+    if (AbstractObserver::ProcessId == type) {
+        auto jsresult = ToObject(samples.front(), processKeys, mask);
+        Nan::Set(jsresult, jspid, JSNUM(samples.front().pid));
+        return jsresult;
+    }
+
+    auto jsresult = Nan::New<Array>(samples.size());
+    uint32_t index = 0;
+    for (const auto& sample : samples) {
+        auto jsitem = ToObject(sample, processKeys, mask);
+        Nan::Set(jsitem, jspid, JSNUM(sample.pid));
+
+        Nan::Set(jsresult, index, jsitem);
+        index++;
+    }
+
+    return jsresult;
+}
+
 /// Базовый класс реализации асинхронной работы метода @e poll.
 class ObserverWorker : public AsyncWorker
 {
@@ -48,13 +355,25 @@ protected:
     ObserverWorker(Callback* callback, AbstractObserver* observer, AbstractObserver::Mask mask)
         : AsyncWorker(callback)
         , observer_(observer)
-        , mask_(mask) {}
+        , mask_(mask)
+        , result_({}) {}
     virtual ~ObserverWorker() = default;
 
+public:
+    /// Запускает асинхронное выполнение опроса счетчиков
+    inline void Execute() override final {
+        try {
+            observer_->Collect(mask_, result_);
+        }
+        catch (const AbstractObserver::Exception& error) {
+            SetErrorMessage(error.what());
+        }
+    }
+
 private:
     /// Вызывается в случае возникновения ошибки.
     /// Устанавливает значение параметра @e error callback-функции.
-    inline void HandleErrorCallback() override final {
+    inline void HandleErrorCallback() override {
         const int argc = 2;
         Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
         callback->Call(argc, argv);
@@ -65,27 +384,211 @@ protected:
     AbstractObserver* observer_;
     /// Маска опрашиваемых счетчиков
     AbstractObserver::Mask mask_;
+    /// Результаты выполнения опроса счетчиков
+    std::vector<AbstractObserver::Sample> result_;
 }; // class ObserverWorker
 
-/// Реализует асинхронную работу метода @e poll для наблюдателя за системой.
-class SystemObserverWorker final : public ObserverWorker
+/// Реализует асинхронную работу метода @e poll для наблюдателя любого типа.
+/// Результат передается не в собственный callback, а наблюдателю, который раздает его
+/// всем присоединившимся к опросу вызовам @e poll (см. Observer#CompletePoll).
+class PollWorker final : public ObserverWorker
+{
+public:
+    /// @param[in] owner Указатель на экспортируемый наблюдатель
+    /// @param[in] observer Указатель на реализацию наблюдателя
+    /// @param[in] mask Маска опрашиваемых счетчиков
+    PollWorker(Observer* owner, AbstractObserver* observer, AbstractObserver::Mask mask)
+        : ObserverWorker(nullptr, observer, mask)
+        , owner_(owner)
+    {
+        // Удерживаем JS объект наблюдателя, чтобы он не был собран до завершения опроса
+        SaveToPersistent(0u, owner->handle());
+    }
+    ~PollWorker() = default;
+
+public:
+    /// Вызывается в случае успешного выполнения метода.
+    /// Передает результат опроса наблюдателю.
+    inline void HandleOKCallback() override {
+        owner_->CompletePoll(result_, nullptr);
+    }
+
+    /// Вызывается в случае возникновения ошибки.
+    /// Передает текст ошибки наблюдателю.
+    inline void HandleErrorCallback() override {
+        owner_->CompletePoll(result_, ErrorMessage());
+    }
+
+private:
+    /// Указатель на экспортируемый наблюдатель
+    Observer* owner_;
+}; // class PollWorker
+
+/// Реализует асинхронную работу статического метода @e pollAll.
+/// Все наблюдатели опрашиваются за один проход в пуле потоков, а наблюдатели, которым
+/// нужен список процессов, используют один общий снимок вместо собственного обхода.
+class PollAllWorker final : public AsyncWorker
+{
+public:
+    /// Наблюдатель и маска его счетчиков
+    struct Item
+    {
+        AbstractObserver* observer;         ///< Указатель на реализацию наблюдателя
+        AbstractObserver::Mask mask;        ///< Маска опрашиваемых счетчиков
+    };
+
+public:
+    /// @param[in] callback Указатель на callback
+    /// @param[in] items Наблюдатели и маски их счетчиков
+    /// @param[in] observers JS массив наблюдателей (удерживается до завершения опроса)
+    PollAllWorker(Callback* callback, std::vector<Item>&& items, Local<Object> observers)
+        : AsyncWorker(callback)
+        , items_(std::move(items))
+        , results_(items_.size())
+        , errors_(items_.size())
+    {
+        SaveToPersistent(0u, observers);
+    }
+    ~PollAllWorker() = default;
+
+public:
+    /// Запускает асинхронное выполнение метода @e pollAll
+    inline void Execute() override {
+        // Снимок имеет смысл, только если список процессов нужен хотя бы двум наблюдателям
+        size_t consumers = 0;
+        for (const auto& item : items_)
+            if (item.observer->NeedsProcessSnapshot()) consumers++;
+
+        AbstractObserver::ProcessSnapshot snapshot = {};
+        const AbstractObserver::ProcessSnapshot* shared = nullptr;
+        if (1 < consumers) {
+            try {
+                snapshot = AbstractObserver::GetProcessSnapshot();
+                shared = &snapshot;
+            }
+            catch (const AbstractObserver::Exception&) {}
+        }
+
+        // Ошибка опроса одного наблюдателя не прерывает опрос остальных
+        for (size_t i = 0; i < items_.size(); ++i) {
+            try {
+                items_[i].observer->Collect(items_[i].mask, results_[i], shared);
+            }
+            catch (const AbstractObserver::Exception& error) {
+                errors_[i] = error.what();
+            }
+        }
+    }
+
+    /// Вызывается в случае успешного выполнения метода.
+    /// Устанавливает значение параметра @e result callback-функции: массив результатов
+    /// в порядке наблюдателей, для наблюдателей с ошибкой опроса - объекты Error.
+    inline void HandleOKCallback() override {
+        auto jsresult = Nan::New<Array>(items_.size());
+        for (uint32_t i = 0; i < items_.size(); ++i) {
+            if (!errors_[i].empty()) Nan::Set(jsresult, i, Nan::Error(errors_[i].c_str()));
+            else Nan::Set(jsresult, i, ToResult(results_[i], items_[i].observer->GetType()));
+        }
+
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), jsresult };
+        callback->Call(argc, argv);
+    }
+
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
+private:
+    /// Наблюдатели и маски их счетчиков
+    std::vector<Item> items_;
+    /// Результаты опроса каждого наблюдателя
+    std::vector<std::vector<AbstractObserver::Sample>> results_;
+    /// Тексты ошибок опроса каждого наблюдателя (пустые, если ошибки не было)
+    std::vector<std::string> errors_;
+}; // class PollAllWorker
+
+/// Реализует асинхронную работу метода @e pollInto для наблюдателя любого типа.
+/// Значения счетчиков записываются в переданный Float64Array без создания JS объектов:
+/// каждому результату опроса соответствует строка из @e kStride ячеек, в которой ячейки
+/// счетчиков идут в порядке Observer.masks(), а последняя ячейка содержит идентификатор
+/// процесса (для наблюдателей за системой и группой процессов - NaN). Отсутствующие значения также равны NaN.
+class PollIntoWorker final : public ObserverWorker
 {
+public:
+    /// Количество ячеек массива на один результат опроса
+    static const size_t kStride = 15;
+
 public:
     /// @param[in] callback Указатель на callback
     /// @param[in] observer Указатель на реализацию наблюдателя
     /// @param[in] mask Маска опрашиваемых счетчиков
-    SystemObserverWorker(Callback* callback, AbstractObserver* observer, AbstractObserver::Mask mask)
+    /// @param[in] target Массив для записи значений счетчиков
+    /// @param[in] holder JS объект наблюдателя
+    PollIntoWorker(Callback* callback, AbstractObserver* observer, AbstractObserver::Mask mask,
+                   Local<Object> target, Local<Object> holder)
         : ObserverWorker(callback, observer, mask)
-        , result_({}) {}
-    ~SystemObserverWorker() = default;
+    {
+        // Сохраняем массив и объект наблюдателя, чтобы они не были собраны сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, target);
+        SaveToPersistent(1u, holder);
+    }
+    ~PollIntoWorker() = default;
+
+public:
+    /// Вызывается в случае успешного выполнения метода.
+    /// Записывает значения в массив и передает в callback-функцию количество результатов опроса:
+    /// если оно больше количества строк массива, записываются только первые из них.
+    inline void HandleOKCallback() override {
+        Nan::TypedArrayContents<double> target(GetFromPersistent(0u));
+        const bool process = HasPid(observer_->GetType());
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        double* row = *target;
+        const size_t rows = std::min(result_.size(), target.length() / kStride);
+        for (size_t i = 0; i < rows; ++i, row += kStride) {
+            const AbstractObserver::Sample& sample = result_[i];
+            for (size_t j = 0; j < kStride - 1; ++j)
+                row[j] = sample.Has(1u << j) ? sample.values[j] : nan;
+            row[kStride - 1] = process ? static_cast<double>(sample.pid) : nan;
+        }
+
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), JSNUM(static_cast<double>(result_.size())) };
+        callback->Call(argc, argv);
+    }
+
+}; // class PollIntoWorker
+
+/// Реализует асинхронную работу метода @e pollThreads наблюдателя за процессом по идентификатору
+class ThreadsWorker final : public AsyncWorker
+{
+public:
+    /// @param[in] callback Указатель на callback
+    /// @param[in] observer Указатель на реализацию наблюдателя
+    /// @param[in] top Количество самых загруженных потоков в результате (@b 0 - все потоки)
+    /// @param[in] holder JS объект наблюдателя
+    ThreadsWorker(Callback* callback, ProcessIdObserver* observer, size_t top, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+        , top_(top)
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, holder);
+    }
+    ~ThreadsWorker() = default;
 
 public:
-    /// Запускает асинхронное выполнение метода @e poll
+    /// Запускает асинхронное выполнение метода @e pollThreads
     inline void Execute() override {
         try {
-            result_ = reinterpret_cast<SystemObserver*>(observer_)->Poll(mask_);
+            result_ = observer_->PollThreads(top_);
         }
-        catch (const SystemObserver::Exception& error) {
+        catch (const AbstractObserver::Exception& error) {
             SetErrorMessage(error.what());
         }
     }
@@ -93,10 +596,17 @@ public:
     /// Вызывается в случае успешного выполнения метода.
     /// Устанавливает значение параметра @e result callback-функции.
     inline void HandleOKCallback() override {
-        auto jsresult = Nan::New<Object>();
-        Nan::Set(jsresult, JSSTR("pid"), Nan::Null());
-        for (const auto& item : result_) {
-            Nan::Set(jsresult, JSSTR(item.first), JSNUM(item.second));
+        const Local<String> tid = Nan::New(threadKeys[0]);
+        const Local<String> name = Nan::New(threadKeys[1]);
+        const Local<String> usage = Nan::New(threadKeys[2]);
+
+        auto jsresult = Nan::New<Array>(result_.size());
+        for (uint32_t i = 0; i < result_.size(); ++i) {
+            auto jsthread = Nan::New<Object>();
+            Nan::Set(jsthread, tid, JSNUM(result_[i].tid));
+            Nan::Set(jsthread, name, JSSTR(result_[i].name.c_str()));
+            Nan::Set(jsthread, usage, JSNUM(result_[i].usage));
+            Nan::Set(jsresult, i, jsthread);
         }
 
         const int argc = 2;
@@ -104,30 +614,47 @@ public:
         callback->Call(argc, argv);
     }
 
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
 private:
-    /// Результат выполнения опроса счетчиков
-    SystemObserver::Result result_;
-}; // class SystemObserverWorker
+    /// Указатель на реализацию наблюдателя
+    ProcessIdObserver* observer_;
+    /// Количество самых загруженных потоков в результате
+    size_t top_;
+    /// Загрузка процессора потоками
+    ProcessIdObserver::ThreadResult result_;
+}; // class ThreadsWorker
 
-/// Реализует асинхронную работу метода @e poll для наблюдателя за процессом с конкретным @e pid
-class ProcessIdObserverWorker final : public ObserverWorker
+/// Реализует асинхронную работу метода @e pollCores наблюдателя за системой.
+/// Загрузка процессоров возвращается одним Float64Array (индекс - номер процессора).
+class CoresWorker final : public AsyncWorker
 {
 public:
     /// @param[in] callback Указатель на callback
     /// @param[in] observer Указатель на реализацию наблюдателя
-    /// @param[in] mask Маска опрашиваемых счетчиков
-    ProcessIdObserverWorker(Callback* callback, AbstractObserver* observer, AbstractObserver::Mask mask)
-        : ObserverWorker(callback, observer, mask)
-        , result_({}) {}
-    ~ProcessIdObserverWorker() = default;
+    /// @param[in] holder JS объект наблюдателя
+    CoresWorker(Callback* callback, SystemObserver* observer, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, holder);
+    }
+    ~CoresWorker() = default;
 
 public:
-    /// Запускает асинхронное выполнение метода @e poll
+    /// Запускает асинхронное выполнение метода @e pollCores
     inline void Execute() override {
         try {
-            result_ = reinterpret_cast<ProcessIdObserver*>(observer_)->Poll(mask_);
+            observer_->PollCores(result_);
         }
-        catch (const ProcessIdObserver::Exception& error) {
+        catch (const AbstractObserver::Exception& error) {
             SetErrorMessage(error.what());
         }
     }
@@ -135,9 +662,77 @@ public:
     /// Вызывается в случае успешного выполнения метода.
     /// Устанавливает значение параметра @e result callback-функции.
     inline void HandleOKCallback() override {
-        auto jsresult = Nan::New<Object>();
-        for (const auto& item : result_) {
-            Nan::Set(jsresult, JSSTR(item.first), JSNUM(item.second));
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), ToFloat64Array(result_) };
+        callback->Call(argc, argv);
+    }
+
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
+private:
+    /// Указатель на реализацию наблюдателя
+    SystemObserver* observer_;
+    /// Загрузка процессоров
+    std::vector<double> result_;
+}; // class CoresWorker
+
+/// Реализует асинхронную работу метода @e pollDisks наблюдателя за системой
+class DisksWorker final : public AsyncWorker
+{
+public:
+    /// @param[in] callback Указатель на callback
+    /// @param[in] observer Указатель на реализацию наблюдателя
+    /// @param[in] pattern Регулярное выражение для имен устройств
+    /// @param[in] ignoreCase Сравнивать имена без учета регистра
+    /// @param[in] holder JS объект наблюдателя
+    DisksWorker(Callback* callback, SystemObserver* observer, std::string pattern, bool ignoreCase, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+        , pattern_(std::move(pattern))
+        , ignoreCase_(ignoreCase)
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, holder);
+    }
+    ~DisksWorker() = default;
+
+public:
+    /// Запускает асинхронное выполнение метода @e pollDisks
+    inline void Execute() override {
+        try {
+            observer_->PollDisks(pattern_, ignoreCase_, result_);
+        }
+        catch (const AbstractObserver::Exception& error) {
+            SetErrorMessage(error.what());
+        }
+    }
+
+    /// Вызывается в случае успешного выполнения метода.
+    /// Устанавливает значение параметра @e result callback-функции.
+    inline void HandleOKCallback() override {
+        const size_t count = COUNTOF(diskKeys);
+        Local<String> keys[count];
+        for (size_t i = 0; i < count; ++i)
+            keys[i] = Nan::New(diskKeys[i]);
+
+        auto jsresult = Nan::New<Array>(result_.size());
+        for (uint32_t i = 0; i < result_.size(); ++i) {
+            const SystemObserver::DiskSample& disk = result_[i];
+            const Local<Value> values[count] = {
+                JSSTR(disk.name.c_str()), JSNUM(disk.reads), JSNUM(disk.writes), JSNUM(disk.readKBytes),
+                JSNUM(disk.writeKBytes), JSNUM(disk.readLatency), JSNUM(disk.writeLatency), JSNUM(disk.usage)
+            };
+
+            auto jsdisk = Nan::New<Object>();
+            for (size_t j = 0; j < count; ++j)
+                Nan::Set(jsdisk, keys[j], values[j]);
+            Nan::Set(jsresult, i, jsdisk);
         }
 
         const int argc = 2;
@@ -145,47 +740,228 @@ public:
         callback->Call(argc, argv);
     }
 
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
 private:
-    /// Результат выполнения опроса счетчиков
-    ProcessIdObserver::Result result_;
-}; // class ProcessIdObserverWorker
+    /// Указатель на реализацию наблюдателя
+    SystemObserver* observer_;
+    /// Регулярное выражение для имен устройств
+    std::string pattern_;
+    /// Сравнивать имена без учета регистра
+    bool ignoreCase_;
+    /// Показатели дисковых устройств
+    std::vector<SystemObserver::DiskSample> result_;
+}; // class DisksWorker
 
-/// Реализует асинхронную работу метода @e poll для наблюдателя за списком процессов по имени
-class ProcessNameObserverWorker final : public ObserverWorker
+/// Реализует асинхронную работу метода @e pollNetwork наблюдателя за системой
+class NetworkWorker final : public AsyncWorker
 {
 public:
     /// @param[in] callback Указатель на callback
     /// @param[in] observer Указатель на реализацию наблюдателя
-    /// @param[in] mask Маска опрашиваемых счетчиков
-    ProcessNameObserverWorker(Callback* callback, AbstractObserver* observer, AbstractObserver::Mask mask)
-        : ObserverWorker(callback, observer, mask)
-        , result_({}) {}
-    ~ProcessNameObserverWorker() = default;
+    /// @param[in] holder JS объект наблюдателя
+    NetworkWorker(Callback* callback, SystemObserver* observer, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, holder);
+    }
+    ~NetworkWorker() = default;
 
 public:
-    /// Запускает асинхронное выполнение метода @e poll
+    /// Запускает асинхронное выполнение метода @e pollNetwork
     inline void Execute() override {
         try {
-            result_ = reinterpret_cast<ProcessNameObserver*>(observer_)->Poll(mask_);
+            observer_->PollNetwork(interfaces_, total_);
         }
-        catch (const ProcessNameObserver::Exception& error) {
+        catch (const AbstractObserver::Exception& error) {
             SetErrorMessage(error.what());
         }
     }
 
     /// Вызывается в случае успешного выполнения метода.
-    /// Устанавливает значение параметра @e result callback-функции.
+    /// Устанавливает значение параметра @e result callback-функции: { total, interfaces }.
     inline void HandleOKCallback() override {
-        auto jsresult = Nan::New<Array>();
-        uint32_t index = 0;
-        for (const auto& ritem : result_) {
-            auto jsitem = Nan::New<Object>();
-            for (const auto& pitem : ritem) {
-                Nan::Set(jsitem, JSSTR(pitem.first), JSNUM(pitem.second));
+        auto jsinterfaces = Nan::New<Array>(interfaces_.size());
+        for (uint32_t i = 0; i < interfaces_.size(); ++i)
+            Nan::Set(jsinterfaces, i, ToNetworkObject(interfaces_[i]));
+
+        auto jsresult = Nan::New<Object>();
+        Nan::Set(jsresult, Nan::New(networkResultKeys[0]), ToNetworkObject(total_));
+        Nan::Set(jsresult, Nan::New(networkResultKeys[1]), jsinterfaces);
+
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), jsresult };
+        callback->Call(argc, argv);
+    }
+
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
+private:
+    /// Создает JS объект с показателями сетевого интерфейса
+    /// @param[in] sample Показатели сетевого интерфейса
+    /// @return JS объект
+    static Local<Object> ToNetworkObject(const SystemObserver::NetworkSample& sample) {
+        const size_t count = COUNTOF(networkKeys);
+        const Local<Value> values[count] = {
+            JSSTR(sample.name.c_str()), JSNUM(sample.receiveKBytes), JSNUM(sample.sendKBytes),
+            JSNUM(sample.receivePackets), JSNUM(sample.sendPackets), JSNUM(sample.receiveDrops),
+            JSNUM(sample.sendDrops), JSNUM(sample.receiveErrors), JSNUM(sample.sendErrors)
+        };
+
+        auto jsobject = Nan::New<Object>();
+        for (size_t i = 0; i < count; ++i)
+            Nan::Set(jsobject, Nan::New(networkKeys[i]), values[i]);
+        return jsobject;
+    }
+
+private:
+    /// Указатель на реализацию наблюдателя
+    SystemObserver* observer_;
+    /// Показатели сетевых интерфейсов
+    std::vector<SystemObserver::NetworkSample> interfaces_;
+    /// Сумма показателей сетевых интерфейсов
+    SystemObserver::NetworkSample total_;
+}; // class NetworkWorker
+
+/// Реализует асинхронную работу метода @e pollPressure наблюдателя за системой
+class PressureWorker final : public AsyncWorker
+{
+public:
+    /// @param[in] callback Указатель на callback
+    /// @param[in] observer Указатель на реализацию наблюдателя
+    /// @param[in] holder JS объект наблюдателя
+    PressureWorker(Callback* callback, SystemObserver* observer, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+        , result_()
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения опроса
+        SaveToPersistent(0u, holder);
+    }
+    ~PressureWorker() = default;
+
+public:
+    /// Запускает асинхронное выполнение метода @e pollPressure
+    inline void Execute() override {
+        try {
+            observer_->PollPressure(result_);
+        }
+        catch (const AbstractObserver::Exception& error) {
+            SetErrorMessage(error.what());
+        }
+    }
+
+    /// Вызывается в случае успешного выполнения метода.
+    /// Устанавливает значение параметра @e result callback-функции:
+    /// { cpu: { some: { avg10, avg60, avg300, total }, full: { ... } }, memory: ..., io: ... },
+    /// где для недоступного ресурса вместо объекта - null.
+    inline void HandleOKCallback() override {
+        auto jsresult = Nan::New<Object>();
+        for (size_t i = 0; i < result_.size(); ++i) {
+            const SystemObserver::PressureStat& stat = result_[i];
+            if (!stat.available) {
+                Nan::Set(jsresult, Nan::New(pressureKeys[i]), Nan::Null());
+                continue;
             }
 
-            Nan::Set(jsresult, index, jsitem);
-            index++;
+            auto jsresource = Nan::New<Object>();
+            Nan::Set(jsresource, Nan::New(pressureLineKeys[0]), ToPressureObject(stat.some));
+            Nan::Set(jsresource, Nan::New(pressureLineKeys[1]), ToPressureObject(stat.full));
+            Nan::Set(jsresult, Nan::New(pressureKeys[i]), jsresource);
+        }
+
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), jsresult };
+        callback->Call(argc, argv);
+    }
+
+    /// Вызывается в случае возникновения ошибки.
+    /// Устанавливает значение параметра @e error callback-функции.
+    inline void HandleErrorCallback() override {
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Error(ErrorMessage()), Nan::Null() };
+        callback->Call(argc, argv);
+    }
+
+private:
+    /// Создает JS объект со значениями строки PSI
+    /// @param[in] values avg10, avg60, avg300 и total
+    /// @return JS объект
+    static Local<Object> ToPressureObject(const double (&values)[4]) {
+        auto jsobject = Nan::New<Object>();
+        for (size_t i = 0; i < COUNTOF(pressureValueKeys); ++i)
+            Nan::Set(jsobject, Nan::New(pressureValueKeys[i]), JSNUM(values[i]));
+        return jsobject;
+    }
+
+private:
+    /// Указатель на реализацию наблюдателя
+    SystemObserver* observer_;
+    /// Значения PSI по ресурсам
+    std::array<SystemObserver::PressureStat, SystemObserver::PressureResourceCount> result_;
+}; // class PressureWorker
+
+/// Реализует асинхронную работу метода @e history наблюдателя.
+/// Распаковка значений выполняется в пуле потоков, а ряды возвращаются массивами Float64Array.
+class HistoryWorker final : public AsyncWorker
+{
+public:
+    /// @param[in] callback Указатель на callback
+    /// @param[in] observer Указатель на реализацию наблюдателя
+    /// @param[in] counter Счетчик (один бит маски)
+    /// @param[in] from Начало интервала в миллисекундах с начала эпохи UNIX
+    /// @param[in] to Конец интервала
+    /// @param[in] buckets Количество интервалов прореживания (@b 0 - все значения)
+    /// @param[in] holder JS объект наблюдателя
+    HistoryWorker(Callback* callback, AbstractObserver* observer, uint32_t counter,
+        double from, double to, size_t buckets, Local<Object> holder)
+        : AsyncWorker(callback)
+        , observer_(observer)
+        , counter_(counter)
+        , from_(from)
+        , to_(to)
+        , buckets_(buckets)
+        , found_(false)
+        , result_()
+    {
+        // Сохраняем объект наблюдателя, чтобы он не был собран сборщиком мусора до завершения запроса
+        SaveToPersistent(0u, holder);
+    }
+    ~HistoryWorker() = default;
+
+public:
+    /// Запускает асинхронное выполнение метода @e history
+    inline void Execute() override {
+        found_ = observer_->GetHistory().Query(counter_, from_, to_, buckets_, result_);
+    }
+
+    /// Вызывается в случае успешного выполнения метода.
+    /// Устанавливает значение параметра @e result callback-функции.
+    inline void HandleOKCallback() override {
+        Local<Value> jsresult = Nan::Null();
+        if (found_) {
+            auto jsrange = Nan::New<Object>();
+            Nan::Set(jsrange, Nan::New(historyKeys[0]), ToFloat64Array(result_.timestamps));
+            Nan::Set(jsrange, Nan::New(historyKeys[1]), ToFloat64Array(result_.values));
+            if (0 != buckets_) {
+                Nan::Set(jsrange, Nan::New(historyKeys[2]), ToFloat64Array(result_.min));
+                Nan::Set(jsrange, Nan::New(historyKeys[3]), ToFloat64Array(result_.max));
+            }
+            jsresult = jsrange;
         }
 
         const int argc = 2;
@@ -194,11 +970,23 @@ public:
     }
 
 private:
-    /// Результат выполнения опроса счетчиков
-    ProcessNameObserver::Result result_;
-}; // class PRocessNameObserverWorker
+    /// Указатель на реализацию наблюдателя
+    AbstractObserver* observer_;
+    /// Счетчик
+    uint32_t counter_;
+    /// Начало интервала
+    double from_;
+    /// Конец интервала
+    double to_;
+    /// Количество интервалов прореживания
+    size_t buckets_;
+    /// Значения счетчика найдены
+    bool found_;
+    /// Значения ряда
+    History::Range result_;
+}; // class HistoryWorker
 
-   /// Реализует асинхронную работу статического метода @e processes
+/// Реализует асинхронную работу статического метода @e processes
 class ProcessesWorker final : public AsyncWorker
 {
 public:
@@ -221,24 +1009,34 @@ public:
     /// Вызывается в случае успешного выполнения метода.
     /// Устанавливает значение параметра @e result callback-функции.
     inline void HandleOKCallback() override {
+        const size_t count = COUNTOF(processListKeys);
+        Local<String> keys[count];
+        for (size_t i = 0; i < count; ++i)
+            keys[i] = Nan::New(processListKeys[i]);
+        const auto tpl = Nan::New(processTemplate);
+
+        // Владельцев процессов обычно немного, поэтому их строки создаются один раз на вызов
+        std::unordered_map<std::string, Local<String>> owners = {};
+
         auto jsProcesses = Nan::New<Array>(processes_.size());
         uint32_t index = 0;
         for (const auto& process : processes_) {
-            auto jsProcess = Nan::New<Object>();
-            Nan::Set(jsProcess, JSSTR("pid"), JSNUM(process.pid));
-            Nan::Set(jsProcess, JSSTR("ppid"), JSNUM(process.ppid));
-            Nan::Set(jsProcess, JSSTR("name"), JSSTR(process.name.c_str()));
-            Nan::Set(jsProcess, JSSTR("path"), JSSTR(process.path.c_str()));
-            Nan::Set(jsProcess, JSSTR("owner"), JSSTR(process.owner.c_str()));
-            Nan::Set(jsProcess, JSSTR("priority"), JSNUM(process.priority));
-            Nan::Set(jsProcess, JSSTR("status"), JSNUM(process.status));
-            Nan::Set(jsProcess, JSSTR("threads"), JSNUM(process.threads));
-            Nan::Set(jsProcess, JSSTR("handles"), JSNUM(process.handles));
-            Nan::Set(jsProcess, JSSTR("ktime"), JSNUM(process.ktime));
-            Nan::Set(jsProcess, JSSTR("utime"), JSNUM(process.utime));
-            Nan::Set(jsProcess, JSSTR("start"), JSNUM(process.start));
-            Nan::Set(jsProcess, JSSTR("pmemory"), JSNUM(process.pmemory));
-            Nan::Set(jsProcess, JSSTR("vmemory"), JSNUM(process.vmemory));
+            auto owner = owners.find(process.owner);
+            if (owners.end() == owner)
+                owner = owners.emplace(process.owner, JSSTR(process.owner.c_str())).first;
+
+            // Порядок значений совпадает с порядком ключей в kProcessListKeys
+            const Local<Value> values[count] = {
+                JSNUM(process.pid), JSNUM(process.ppid), JSSTR(process.name.c_str()),
+                JSSTR(process.path.c_str()), owner->second, JSNUM(process.priority),
+                JSNUM(process.status), JSNUM(process.threads), JSNUM(process.handles),
+                JSNUM(process.ktime), JSNUM(process.utime), JSNUM(process.start),
+                JSNUM(process.pmemory), JSNUM(process.vmemory)
+            };
+
+            auto jsProcess = Nan::NewInstance(tpl).ToLocalChecked();
+            for (size_t i = 0; i < count; ++i)
+                Nan::Set(jsProcess, keys[i], values[i]);
 
             Nan::Set(jsProcesses, index, jsProcess);
             index++;
@@ -259,22 +1057,35 @@ public:
 
 private:
     /// Список процессов
-    std::list<AbstractObserver::Process> processes_;
+    std::vector<AbstractObserver::Process> processes_;
 };
 
 } // namespace
 
 Observer::Observer()
-    : impl_(std::make_unique<SystemObserver>()) {}
+    : impl_(std::make_unique<SystemObserver>())
+    , currentMask_(0)
+    , nextMask_(0) {}
 
 Observer::Observer(uint32_t pid)
-    : impl_(std::make_unique<ProcessIdObserver>(pid)) {}
+    : impl_(std::make_unique<ProcessIdObserver>(pid))
+    , currentMask_(0)
+    , nextMask_(0) {}
+
+Observer::Observer(const std::string& name, bool events)
+    : impl_(std::make_unique<ProcessNameObserver>(name, events))
+    , currentMask_(0)
+    , nextMask_(0) {}
 
-Observer::Observer(const std::string& name)
-    : impl_(std::make_unique<ProcessNameObserver>(name)) {}
+Observer::Observer(const std::string& path)
+    : impl_(std::make_unique<CGroupObserver>(path))
+    , currentMask_(0)
+    , nextMask_(0) {}
 
 NODE_MODULE_INIT(Observer::Initialize)
 {
+    InitializeCache();
+
     auto tpl = Nan::New<FunctionTemplate>(New);
     tpl->SetClassName(JSSTR("Observer"));
     tpl->InstanceTemplate()->SetInternalFieldCount(1);
@@ -282,9 +1093,32 @@ NODE_MODULE_INIT(Observer::Initialize)
     Nan::SetPrototypeMethod(tpl, "_type", GetType);
     Nan::SetPrototypeMethod(tpl, "_object", GetObject);
     Nan::SetPrototypeMethod(tpl, "_poll", Poll);
+    Nan::SetPrototypeMethod(tpl, "_pollInto", PollInto);
+    Nan::SetPrototypeMethod(tpl, "_pollThreads", PollThreads);
+    Nan::SetPrototypeMethod(tpl, "_pollCores", PollCores);
+    Nan::SetPrototypeMethod(tpl, "_pollDisks", PollDisks);
+    Nan::SetPrototypeMethod(tpl, "_pollNetwork", PollNetwork);
+    Nan::SetPrototypeMethod(tpl, "_pollPressure", PollPressure);
+    Nan::SetPrototypeMethod(tpl, "_summarize", ConfigureSummary);
+    Nan::SetPrototypeMethod(tpl, "_summary", GetSummary);
+    Nan::SetPrototypeMethod(tpl, "_historyConfigure", ConfigureHistory);
+    Nan::SetPrototypeMethod(tpl, "_history", GetHistory);
+    Nan::SetPrototypeMethod(tpl, "_historyUsage", GetHistoryUsage);
+    Nan::SetPrototypeMethod(tpl, "_start", Start);
+    Nan::SetPrototypeMethod(tpl, "_drain", Drain);
+    Nan::SetPrototypeMethod(tpl, "_stop", Stop);
+    Nan::SetPrototypeMethod(tpl, "_persist", Persist);
+    Nan::SetPrototypeMethod(tpl, "_samples", GetSamples);
+    Nan::SetPrototypeMethod(tpl, "_publish", Publish);
+    Nan::SetPrototypeMethod(tpl, "_latest", Latest);
 
     Nan::SetMethod(tpl, "_processes", Processes);
+    Nan::SetMethod(tpl, "_pollAll", PollAll);
+    Nan::SetMethod(tpl, "_openSamples", OpenSamples);
+    Nan::SetMethod(tpl, "_readShared", ReadShared);
+    Nan::SetMethod(tpl, "_setProcRoot", SetProcRoot);
 
+    GetTemplate().Reset(tpl);
     GetConstructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
     Nan::Set(module, JSSTR("exports"), Nan::GetFunction(tpl).ToLocalChecked());
 }
@@ -304,8 +1138,26 @@ NAN_METHOD(Observer::New)
                 self = new Observer(pid);
         }
         else if (info[0]->IsString()) {
-                const String::Utf8Value process(info[0]);
-                self = new Observer(*process);
+                // Второй необязательный аргумент - объект с параметрами: { events: true }
+                bool events = false;
+                if (1 < info.Length() && info[1]->IsObject()) {
+                    const auto options = Nan::To<Object>(info[1]).ToLocalChecked();
+                    const auto value = Nan::Get(options, JSSTR("events")).ToLocalChecked();
+                    events = Nan::To<bool>(value).FromJust();
+                }
+
+                const Nan::Utf8String process(info[0]);
+                self = new Observer(*process, events);
+        }
+        else if (info[0]->IsObject()) {
+                // Объект с параметрами: { cgroup: '/system.slice/nginx.service' }
+                const auto options = Nan::To<Object>(info[0]).ToLocalChecked();
+                const auto value = Nan::Get(options, JSSTR("cgroup")).ToLocalChecked();
+                if (!value->IsString())
+                    return Nan::ThrowError("Observer#Constructor - invalid arguments");
+
+                const Nan::Utf8String path(value);
+                self = new Observer(std::string(*path));
         }
         else {
             return Nan::ThrowError("Observer#Constructor - invalid arguments");
@@ -335,19 +1187,466 @@ NAN_METHOD(Observer::Poll)
     if (2 != info.Length() || !info[0]->IsUint32() || !info[1]->IsFunction())
         return Nan::ThrowError("Observer#_poll() - invalid arguments");
 
-    Callback* callback = new Callback(Local<Function>::Cast(info[1]));
+    Observer* self = Unwrap<Observer>(info.Holder());
+    PendingPoll request = { std::unique_ptr<Callback>(new Callback(Local<Function>::Cast(info[1]))), JSNUM2UINT32(info[0]) };
+
+    // Вызов, пришедший во время опроса, присоединяется к нему, если выполняемый опрос
+    // включает все его счетчики, иначе - ждет следующего опроса с объединенной маской.
+    if (self->current_.empty()) {
+        self->currentMask_ = request.mask;
+        self->current_.push_back(std::move(request));
+        return Nan::AsyncQueueWorker(new PollWorker(self, IPTR(self), self->currentMask_));
+    }
+
+    if (0 == (request.mask & ~self->currentMask_)) {
+        self->current_.push_back(std::move(request));
+    }
+    else {
+        self->nextMask_ |= request.mask;
+        self->next_.push_back(std::move(request));
+    }
+}
+
+void Observer::CompletePoll(const std::vector<AbstractObserver::Sample>& samples, const char* error)
+{
+    std::vector<PendingPoll> completed = std::move(current_);
+    current_.clear();
+
+    // Запускаем следующий опрос до вызова callback-функций: вызовы poll из них присоединятся к нему
+    if (!next_.empty()) {
+        current_ = std::move(next_);
+        currentMask_ = nextMask_;
+        next_.clear();
+        nextMask_ = 0;
+        Nan::AsyncQueueWorker(new PollWorker(this, IPTR(this), currentMask_));
+    }
+
+    const uint8_t type = IPTR(this)->GetType();
+    for (const auto& request : completed) {
+        Nan::HandleScope scope;
+        const int argc = 2;
+        Local<Value> argv[argc] = { Nan::Null(), Nan::Null() };
+        if (nullptr != error) argv[0] = Nan::Error(error);
+        else argv[1] = ToResult(samples, type, request.mask);
+
+        request.callback->Call(argc, argv);
+    }
+}
+
+NAN_METHOD(Observer::PollInto)
+{
+    if (3 != info.Length() || !info[0]->IsUint32() || !info[1]->IsFloat64Array() || !info[2]->IsFunction())
+        return Nan::ThrowError("Observer#_pollInto() - invalid arguments");
+
+    Callback* callback = new Callback(Local<Function>::Cast(info[2]));
     Observer* self = Unwrap<Observer>(info.Holder());
     const uint32_t mask = JSNUM2UINT32(info[0]);
-    switch (IPTR(self)->GetType()) {
-        case AbstractObserver::System:
-            return Nan::AsyncQueueWorker(new SystemObserverWorker(callback, IPTR(self), mask));
-        case AbstractObserver::ProcessId:
-            return Nan::AsyncQueueWorker(new ProcessIdObserverWorker(callback, IPTR(self), mask));
-        case AbstractObserver::ProcessName:
-            return Nan::AsyncQueueWorker(new ProcessNameObserverWorker(callback, IPTR(self), mask));
-        default: 
-            break;
+    Nan::AsyncQueueWorker(new PollIntoWorker(callback, IPTR(self), mask, Nan::To<Object>(info[1]).ToLocalChecked(), info.Holder()));
+}
+
+NAN_METHOD(Observer::PollThreads)
+{
+    if (2 != info.Length() || !info[0]->IsUint32() || !info[1]->IsFunction())
+        return Nan::ThrowError("Observer#_pollThreads() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (AbstractObserver::ProcessId != IPTR(self)->GetType())
+        return Nan::ThrowError("Observer#_pollThreads() - supported only by process id observer");
+
+    Callback* callback = new Callback(Local<Function>::Cast(info[1]));
+    auto observer = static_cast<ProcessIdObserver*>(IPTR(self));
+    Nan::AsyncQueueWorker(new ThreadsWorker(callback, observer, JSNUM2UINT32(info[0]), info.Holder()));
+}
+
+NAN_METHOD(Observer::PollCores)
+{
+    if (1 != info.Length() || !info[0]->IsFunction())
+        return Nan::ThrowError("Observer#_pollCores() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (AbstractObserver::System != IPTR(self)->GetType())
+        return Nan::ThrowError("Observer#_pollCores() - supported only by system observer");
+
+    Callback* callback = new Callback(Local<Function>::Cast(info[0]));
+    auto observer = static_cast<SystemObserver*>(IPTR(self));
+    Nan::AsyncQueueWorker(new CoresWorker(callback, observer, info.Holder()));
+}
+
+NAN_METHOD(Observer::PollDisks)
+{
+    if (3 != info.Length() || !info[0]->IsString() || !info[1]->IsBoolean() || !info[2]->IsFunction())
+        return Nan::ThrowError("Observer#_pollDisks() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (AbstractObserver::System != IPTR(self)->GetType())
+        return Nan::ThrowError("Observer#_pollDisks() - supported only by system observer");
+
+    const Nan::Utf8String pattern(info[0]);
+    const bool ignoreCase = Nan::To<bool>(info[1]).FromJust();
+    Callback* callback = new Callback(Local<Function>::Cast(info[2]));
+    auto observer = static_cast<SystemObserver*>(IPTR(self));
+    Nan::AsyncQueueWorker(new DisksWorker(callback, observer, *pattern, ignoreCase, info.Holder()));
+}
+
+NAN_METHOD(Observer::PollNetwork)
+{
+    if (1 != info.Length() || !info[0]->IsFunction())
+        return Nan::ThrowError("Observer#_pollNetwork() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (AbstractObserver::System != IPTR(self)->GetType())
+        return Nan::ThrowError("Observer#_pollNetwork() - supported only by system observer");
+
+    Callback* callback = new Callback(Local<Function>::Cast(info[0]));
+    auto observer = static_cast<SystemObserver*>(IPTR(self));
+    Nan::AsyncQueueWorker(new NetworkWorker(callback, observer, info.Holder()));
+}
+
+NAN_METHOD(Observer::PollPressure)
+{
+    if (1 != info.Length() || !info[0]->IsFunction())
+        return Nan::ThrowError("Observer#_pollPressure() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (AbstractObserver::System != IPTR(self)->GetType())
+        return Nan::ThrowError("Observer#_pollPressure() - supported only by system observer");
+
+    Callback* callback = new Callback(Local<Function>::Cast(info[0]));
+    auto observer = static_cast<SystemObserver*>(IPTR(self));
+    Nan::AsyncQueueWorker(new PressureWorker(callback, observer, info.Holder()));
+}
+
+NAN_METHOD(Observer::ConfigureSummary)
+{
+    if (1 != info.Length() || !info[0]->IsArray())
+        return Nan::ThrowError("Observer#_summarize() - invalid arguments");
+
+    const auto jswindows = Local<Array>::Cast(info[0]);
+    std::vector<double> windows = {};
+    windows.reserve(jswindows->Length());
+    for (uint32_t i = 0; i < jswindows->Length(); ++i) {
+        const auto value = Nan::Get(jswindows, i).ToLocalChecked();
+        if (!value->IsNumber() || !(0. < Nan::To<double>(value).FromJust()))
+            return Nan::ThrowError("Observer#_summarize() - invalid arguments");
+        windows.push_back(Nan::To<double>(value).FromJust());
     }
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    IPTR(self)->GetSummary().Configure(windows);
+}
+
+NAN_METHOD(Observer::GetSummary)
+{
+    if (2 != info.Length() || !info[0]->IsUint32() || !info[1]->IsNumber())
+        return Nan::ThrowError("Observer#_summary() - invalid arguments");
+
+    // Статистика хранится в памяти модуля, поэтому запрос выполняется синхронно
+    Observer* self = Unwrap<Observer>(info.Holder());
+    Summary::Result result = {};
+    if (!IPTR(self)->GetSummary().Get(JSNUM2UINT32(info[0]), Nan::To<double>(info[1]).FromJust(), result))
+        return info.GetReturnValue().Set(Nan::Null());
+
+    const double values[] = {
+        result.count, result.min, result.max, result.mean, result.ewma, result.p50, result.p90, result.p95, result.p99
+    };
+    auto jsresult = Nan::New<Object>();
+    for (size_t i = 0; i < COUNTOF(kSummaryKeys); ++i)
+        Nan::Set(jsresult, Nan::New(summaryKeys[i]), JSNUM(values[i]));
+
+    info.GetReturnValue().Set(jsresult);
+}
+
+NAN_METHOD(Observer::ConfigureHistory)
+{
+    if (1 != info.Length() || !info[0]->IsNumber() || !(0. <= Nan::To<double>(info[0]).FromJust()))
+        return Nan::ThrowError("Observer#_historyConfigure() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    IPTR(self)->GetHistory().Configure(Nan::To<double>(info[0]).FromJust());
+}
+
+NAN_METHOD(Observer::GetHistory)
+{
+    if (5 != info.Length() || !info[0]->IsUint32() || !info[1]->IsNumber() || !info[2]->IsNumber()
+        || !info[3]->IsUint32() || !info[4]->IsFunction())
+        return Nan::ThrowError("Observer#_history() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    Callback* callback = new Callback(Local<Function>::Cast(info[4]));
+    Nan::AsyncQueueWorker(new HistoryWorker(callback, IPTR(self), JSNUM2UINT32(info[0]),
+        Nan::To<double>(info[1]).FromJust(), Nan::To<double>(info[2]).FromJust(), JSNUM2UINT32(info[3]),
+        info.Holder()));
+}
+
+NAN_METHOD(Observer::GetHistoryUsage)
+{
+    Observer* self = Unwrap<Observer>(info.Holder());
+    const History::Usage usage = IPTR(self)->GetHistory().GetUsage();
+
+    const double values[] = { usage.series, usage.samples, usage.bytes };
+    auto jsresult = Nan::New<Object>();
+    for (size_t i = 0; i < COUNTOF(kHistoryUsageKeys); ++i)
+        Nan::Set(jsresult, Nan::New(historyUsageKeys[i]), JSNUM(values[i]));
+
+    info.GetReturnValue().Set(jsresult);
+}
+
+NAN_METHOD(Observer::Start)
+{
+    // Необязательные аргументы 4-7 описывают триггер PSI: ресурс, full, порог и окно (в мкс)
+    const bool trigger = 7 == info.Length();
+    if ((3 != info.Length() && !trigger) || !info[0]->IsUint32() || !info[1]->IsNumber() || !info[2]->IsUint32())
+        return Nan::ThrowError("Observer#_start() - invalid arguments");
+    if (trigger && (!info[3]->IsString() || !info[4]->IsBoolean() || !info[5]->IsUint32() || !info[6]->IsUint32()))
+        return Nan::ThrowError("Observer#_start() - invalid arguments");
+
+    const double interval = Nan::To<double>(info[1]).FromJust();
+    const uint32_t capacity = JSNUM2UINT32(info[2]);
+    if (!(1. <= interval) || 0 == capacity)
+        return Nan::ThrowError("Observer#_start() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    // Повторный запуск перезапускает опрос с новыми параметрами, накопленные результаты теряются
+    self->sampler_.reset();
+
+    try {
+        std::unique_ptr<PressureTrigger> pressure = nullptr;
+        if (trigger) {
+            const Nan::Utf8String resource(info[3]);
+            pressure.reset(new PressureTrigger(*resource, Nan::To<bool>(info[4]).FromJust(),
+                JSNUM2UINT32(info[5]), JSNUM2UINT32(info[6])));
+        }
+
+        self->sampler_.reset(new Sampler(IPTR(self), JSNUM2UINT32(info[0]), interval, capacity, std::move(pressure),
+            self->file_, self->publisher_));
+    }
+    catch (const AbstractObserver::Exception& error) {
+        return Nan::ThrowError(error.what());
+    }
+}
+
+NAN_METHOD(Observer::Drain)
+{
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (!self->sampler_)
+        return info.GetReturnValue().Set(Nan::New<Array>());
+
+    std::vector<AbstractObserver::Sample> samples = {};
+    try {
+        self->sampler_->Drain(samples);
+    }
+    catch (const AbstractObserver::Exception& error) {
+        self->sampler_.reset();
+        return Nan::ThrowError(error.what());
+    }
+
+    const uint8_t type = IPTR(self)->GetType();
+    auto jsresult = Nan::New<Array>(samples.size());
+    for (uint32_t i = 0; i < samples.size(); ++i)
+        Nan::Set(jsresult, i, ToTimedObject(samples[i], type));
+
+    info.GetReturnValue().Set(jsresult);
+}
+
+NAN_METHOD(Observer::Stop)
+{
+    Observer* self = Unwrap<Observer>(info.Holder());
+    self->sampler_.reset();
+    self->file_.reset();
+    self->fileData_.Reset();
+    self->publisher_.reset();
+}
+
+NAN_METHOD(Observer::Persist)
+{
+    if (3 != info.Length() || !info[0]->IsUint32() || !info[1]->IsString() || !info[2]->IsUint32())
+        return Nan::ThrowError("Observer#_persist() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    // Опрос останавливается, а прежний файл закрывается до открытия нового, иначе тот же файл
+    // нельзя было бы открыть повторно
+    self->sampler_.reset();
+    self->file_.reset();
+    self->fileData_.Reset();
+
+    const Nan::Utf8String path(info[1]);
+    if (0 == path.length()) return;
+
+    try {
+        self->file_ = std::make_shared<SampleFile>(*path, IPTR(self)->GetType(), JSNUM2UINT32(info[0]),
+            JSNUM2UINT32(info[2]));
+    }
+    catch (const AbstractObserver::Exception& error) {
+        return Nan::ThrowError(error.what());
+    }
+}
+
+NAN_METHOD(Observer::GetSamples)
+{
+    Observer* self = Unwrap<Observer>(info.Holder());
+    if (!self->file_)
+        return info.GetReturnValue().Set(Nan::Null());
+
+    // Массив записей создается один раз для файла: повторные вызовы возвращают тот же массив
+    // и только обновляют диапазон записей. Массив ссылается на отдельное отображение для чтения,
+    // чтобы файл закрывался при остановке опроса, а не при сборке мусора.
+    try {
+        if (self->fileData_.IsEmpty())
+            self->fileData_.Reset(ToFloat64Array(std::make_shared<SampleFile>(self->file_->GetPath())));
+    }
+    catch (const AbstractObserver::Exception& error) {
+        return Nan::ThrowError(error.what());
+    }
+
+    info.GetReturnValue().Set(ToSampleView(*self->file_, Nan::New(self->fileData_)));
+}
+
+NAN_METHOD(Observer::OpenSamples)
+{
+    if (1 != info.Length() || !info[0]->IsString())
+        return Nan::ThrowError("Observer#_openSamples - invalid arguments");
+
+    const Nan::Utf8String path(info[0]);
+    try {
+        const auto file = std::make_shared<SampleFile>(std::string(*path));
+        info.GetReturnValue().Set(ToSampleView(*file, ToFloat64Array(file)));
+    }
+    catch (const AbstractObserver::Exception& error) {
+        return Nan::ThrowError(error.what());
+    }
+}
+
+NAN_METHOD(Observer::Publish)
+{
+    if (3 != info.Length() || !info[0]->IsUint32() || !info[1]->IsNumber() || !info[2]->IsString())
+        return Nan::ThrowError("Observer#_publish() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    // Опрос останавливается, а прежний сегмент удаляется до создания нового, иначе сегмент
+    // с тем же именем нельзя было бы создать повторно
+    self->sampler_.reset();
+    self->publisher_.reset();
+
+    const Nan::Utf8String name(info[2]);
+    if (0 == name.length()) return;
+
+    try {
+        self->publisher_ = std::make_shared<LivePublisher>(*name, IPTR(self)->GetType(), JSNUM2UINT32(info[0]),
+            Nan::To<double>(info[1]).FromJust());
+    }
+    catch (const AbstractObserver::Exception& error) {
+        return Nan::ThrowError(error.what());
+    }
+}
+
+NAN_METHOD(Observer::Latest)
+{
+    if (1 != info.Length() || !info[0]->IsUint32())
+        return Nan::ThrowError("Observer#_latest() - invalid arguments");
+
+    Observer* self = Unwrap<Observer>(info.Holder());
+    // Снимок и массив результатов используются только потоком Node.JS, поэтому переиспользуются
+    // между вызовами, чтобы не выделять память при каждом чтении
+    static live::Snapshot snapshot = {};
+    static std::vector<AbstractObserver::Sample> samples = {};
+    if (!self->sampler_ || !self->sampler_->GetLatest(snapshot))
+        return info.GetReturnValue().Set(Nan::Null());
+
+    ToSamples(snapshot, samples);
+    const uint8_t type = IPTR(self)->GetType();
+    if (samples.empty() && AbstractObserver::ProcessName != type)
+        return info.GetReturnValue().Set(Nan::Null());
+
+    // Результат в формате метода poll, дополненный временем опроса, по которому можно оценить возраст значений
+    const auto jsresult = ToResult(samples, type, JSNUM2UINT32(info[0]));
+    const auto jstimestamp = Nan::New(timestampKey);
+    if (AbstractObserver::ProcessName == type) {
+        const auto jsarray = Local<Array>::Cast(jsresult);
+        for (uint32_t i = 0; i < samples.size(); ++i)
+            Nan::Set(Local<Object>::Cast(Nan::Get(jsarray, i).ToLocalChecked()), jstimestamp, JSNUM(samples[i].timestamp));
+    }
+    else {
+        Nan::Set(Local<Object>::Cast(jsresult), jstimestamp, JSNUM(samples.front().timestamp));
+    }
+
+    info.GetReturnValue().Set(jsresult);
+}
+
+NAN_METHOD(Observer::ReadShared)
+{
+    if (1 != info.Length() || !info[0]->IsString())
+        return Nan::ThrowError("Observer#_readShared - invalid arguments");
+
+    // Сегмент открывается при первом чтении и остается открытым: последующие чтения
+    // выполняются без системных вызовов. Закрытый публикацией сегмент открывается заново.
+    const Nan::Utf8String jsname(info[0]);
+    const std::string name(*jsname);
+    auto& reader = sharedReaders[name];
+    if (!reader) reader.reset(new live::Reader());
+
+    live::Snapshot snapshot = {};
+    if (!reader->Read(snapshot) && (!reader->Open(name) || !reader->Read(snapshot))) {
+        sharedReaders.erase(name);
+        return info.GetReturnValue().Set(Nan::Null());
+    }
+
+    std::vector<AbstractObserver::Sample> samples = {};
+    ToSamples(snapshot, samples);
+    const uint8_t type = static_cast<uint8_t>(snapshot.type);
+    auto jssamples = Nan::New<Array>(samples.size());
+    for (uint32_t i = 0; i < samples.size(); ++i)
+        Nan::Set(jssamples, i, ToTimedObject(samples[i], type));
+
+    const double values[] = {
+        static_cast<double>(snapshot.type), static_cast<double>(snapshot.mask), static_cast<double>(snapshot.total),
+        static_cast<double>(snapshot.sequence), snapshot.interval
+    };
+    auto jsresult = Nan::New<Object>();
+    for (size_t i = 0; i < COUNTOF(values); ++i)
+        Nan::Set(jsresult, Nan::New(sharedKeys[i]), JSNUM(values[i]));
+    Nan::Set(jsresult, Nan::New(sharedKeys[COUNTOF(values)]), jssamples);
+
+    info.GetReturnValue().Set(jsresult);
+}
+
+NAN_METHOD(Observer::SetProcRoot)
+{
+    if (1 != info.Length() || !info[0]->IsString())
+        return Nan::ThrowError("Observer#_setProcRoot - invalid arguments");
+
+#if defined(TESTTOOLS_LINUX)
+    const Nan::Utf8String jspath(info[0]);
+    procfs::SetRoot(*jspath);
+#else
+    Nan::ThrowError("Observer#_setProcRoot() - supported only on Linux");
+#endif
+}
+
+NAN_METHOD(Observer::PollAll)
+{
+    if (3 != info.Length() || !info[0]->IsArray() || !info[1]->IsArray() || !info[2]->IsFunction())
+        return Nan::ThrowError("Observer#_pollAll - invalid arguments");
+
+    const auto observers = Local<Array>::Cast(info[0]);
+    const auto masks = Local<Array>::Cast(info[1]);
+    if (observers->Length() != masks->Length())
+        return Nan::ThrowError("Observer#_pollAll - invalid arguments");
+
+    const auto tpl = Nan::New(GetTemplate());
+    std::vector<PollAllWorker::Item> items = {};
+    items.reserve(observers->Length());
+    for (uint32_t i = 0; i < observers->Length(); ++i) {
+        const auto observer = Nan::Get(observers, i).ToLocalChecked();
+        const auto mask = Nan::Get(masks, i).ToLocalChecked();
+        if (!tpl->HasInstance(observer) || !mask->IsUint32())
+            return Nan::ThrowError("Observer#_pollAll - invalid arguments");
+
+        Observer* self = Unwrap<Observer>(Nan::To<Object>(observer).ToLocalChecked());
+        items.push_back(PollAllWorker::Item{ IPTR(self), JSNUM2UINT32(mask) });
+    }
+
+    auto callback = new Callback(Local<Function>::Cast(info[2]));
+    Nan::AsyncQueueWorker(new PollAllWorker(callback, std::move(items), observers));
 }
 
 NAN_METHOD(Observer::Processes)
@@ -7,6 +7,7 @@
 #define TESTTOOLS_OBSERVER_H
 
 #include "abstractobserver.h"
+#include "sampler.h"
 
 #include <nan.h>
 #include <nan_object_wrap.h>
@@ -26,6 +27,12 @@ public:
     /// @param[in] module Объект "module" в Node.JS
     static NODE_MODULE_INIT(Initialize);
 
+    /// Передает результат опроса всем вызовам @e poll, присоединившимся к нему,
+    /// и запускает следующий опрос, если его ожидают (вызывается по завершении опроса)
+    /// @param[in] samples Результаты опроса счетчиков
+    /// @param[in] error Текст ошибки или @b nullptr, если опрос выполнен успешно
+    void CompletePoll(const std::vector<AbstractObserver::Sample>& samples, const char* error);
+
 private:
     /// Инициализирует наблюдателя за системой
     Observer();
@@ -34,7 +41,11 @@ private:
     Observer(uint32_t pid);
     /// Инициализирует наблюдателя за списком процессов с указанным @e name
     /// @param[in] name Имя процесса
-    Observer(const std::string& name);
+    /// @param[in] events Отслеживать запуск и завершение процессов по событиям ядра (только Linux)
+    Observer(const std::string& name, bool events);
+    /// Инициализирует наблюдателя за группой процессов cgroup v2 с указанным @e path
+    /// @param[in] path Путь группы относительно точки монтирования cgroup v2 или полный путь к ее каталогу
+    explicit Observer(const std::string& path);
     virtual ~Observer() = default;
 
 private:
@@ -51,8 +62,76 @@ private:
     /// Реализует работу метода @e poll наблюдателя
     /// @param[in] info Информация о переданных в функцию аргументах
     static NAN_METHOD(Poll);
+    /// Реализует работу метода @e pollInto наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollInto);
+    /// Реализует работу метода @e pollThreads наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollThreads);
+    /// Реализует работу метода @e pollCores наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollCores);
+    /// Реализует работу метода @e pollDisks наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollDisks);
+    /// Реализует работу метода @e pollNetwork наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollNetwork);
+    /// Реализует работу метода @e pollPressure наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollPressure);
+    /// Реализует работу метода @e enableSummary наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(ConfigureSummary);
+    /// Реализует работу метода @e summary наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(GetSummary);
+    /// Реализует работу методов @e enableHistory и @e disableHistory наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(ConfigureHistory);
+    /// Реализует работу метода @e history наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(GetHistory);
+    /// Реализует работу метода @e historyUsage наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(GetHistoryUsage);
+    /// Реализует работу метода @e start наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Start);
+    /// Реализует работу метода @e drain наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Drain);
+    /// Реализует работу метода @e stop наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Stop);
+    /// Реализует работу параметра @e file метода @e start наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Persist);
+    /// Реализует работу метода @e samples наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(GetSamples);
+    /// Реализует работу параметра @e publish метода @e start наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Publish);
+    /// Реализует работу метода @e latest наблюдателя
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(Latest);
 
+    /// Реализует работу статического метода @e processes
+    /// @param[in] info Информация о переданных в функцию аргументах
     static NAN_METHOD(Processes);
+    /// Реализует работу статического метода @e pollAll
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(PollAll);
+    /// Реализует работу статического метода @e openSamples
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(OpenSamples);
+    /// Реализует работу статического метода @e readShared
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(ReadShared);
+    /// Реализует работу статического метода @e setProcRoot
+    /// @param[in] info Информация о переданных в функцию аргументах
+    static NAN_METHOD(SetProcRoot);
 
     /// Возвращает дескриптор конструктора класса в V8 engine
     /// @return Дескриптор конструктора класса в V8 engine
@@ -61,9 +140,42 @@ private:
         return ctor;
     }
 
+    /// Возвращает дескриптор шаблона класса в V8 engine (для проверки принадлежности объектов классу)
+    /// @return Дескриптор шаблона класса в V8 engine
+    static Nan::Persistent<v8::FunctionTemplate>& GetTemplate() {
+        static Nan::Persistent<v8::FunctionTemplate> tpl;
+        return tpl;
+    }
+
+private:
+    /// Вызов метода @e poll, ожидающий результата опроса
+    struct PendingPoll
+    {
+        std::unique_ptr<Nan::Callback> callback;    ///< Callback-функция
+        AbstractObserver::Mask mask;                ///< Маска запрошенных счетчиков
+    };
+
 private:
     /// Указатель на реалиализацию наблюдателя. Зависит от вызываемого конструктора класса.
     std::unique_ptr<AbstractObserver> impl_;
+    /// Файл, в который записываются результаты фонового опроса (если задан; закрывается при остановке опроса)
+    std::shared_ptr<SampleFile> file_;
+    /// Массив записей файла результатов опроса (создается при первом вызове @e samples)
+    Nan::Global<v8::Float64Array> fileData_;
+    /// Публикация результатов фонового опроса в разделяемой памяти (если задана; прекращается при остановке опроса)
+    std::shared_ptr<LivePublisher> publisher_;
+    /// Фоновый опрос счетчиков (если запущен). Объявлен после реализации наблюдателя,
+    /// чтобы поток опроса останавливался раньше, чем она будет уничтожена.
+    std::unique_ptr<Sampler> sampler_;
+
+    /// Вызовы @e poll, ожидающие результата выполняемого опроса (пусто, если опрос не выполняется)
+    std::vector<PendingPoll> current_;
+    /// Маска выполняемого опроса
+    AbstractObserver::Mask currentMask_;
+    /// Вызовы @e poll, ожидающие следующего опроса
+    std::vector<PendingPoll> next_;
+    /// Объединенная маска следующего опроса
+    AbstractObserver::Mask nextMask_;
 }; // class Observer
 
 } // namespace testtools
@@ -0,0 +1,55 @@
+/// @file
+/// Объявление триггера задержек ресурса (Pressure Stall Information).
+
+#pragma once
+
+#ifndef TESTTOOLS_PRESSURETRIGGER_H
+#define TESTTOOLS_PRESSURETRIGGER_H
+
+#include "abstractobserver.h"
+
+#include <chrono>
+#include <string>
+
+namespace testtools
+{
+
+/// Триггер PSI: ядро уведомляет о том, что суммарное время задержек из-за нехватки ресурса
+/// в скользящем окне превысило порог. Позволяет фоновому опросу реагировать на всплеск
+/// задержек сразу, а не при следующем опросе по расписанию, и без частого опроса.
+/// Поддерживается только в Linux 5.2+; в остальных случаях конструктор выбрасывает исключение.
+class PressureTrigger final
+{
+public:
+    /// Регистрирует триггер
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] resource Ресурс: "cpu", "memory" или "io"
+    /// @param[in] full Учитывать время, когда ждали все задачи (иначе - хотя бы одна)
+    /// @param[in] stall Порог времени задержек в окне в микросекундах
+    /// @param[in] window Размер окна в микросекундах (от 500 мс до 10 с; без привилегий - кратно 2 с)
+    PressureTrigger(const std::string& resource, bool full, uint32_t stall, uint32_t window);
+    PressureTrigger(const PressureTrigger&) = delete;
+    PressureTrigger& operator=(const PressureTrigger&) = delete;
+    ~PressureTrigger();
+
+    /// Ожидает срабатывания триггера до указанного момента или пробуждения
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] deadline Момент окончания ожидания
+    /// @return @b true, если триггер сработал, иначе - @b false
+    bool Wait(std::chrono::steady_clock::time_point deadline);
+
+    /// Прерывает текущее и все последующие ожидания (вызывается из другого потока)
+    void Wake() noexcept;
+
+#if defined(TESTTOOLS_LINUX)
+private:
+    /// Дескриптор файла /proc/pressure/<ресурс> с зарегистрированным триггером
+    int fd_;
+    /// Дескриптор eventfd для прерывания ожидания
+    int wakeup_;
+#endif
+}; // class PressureTrigger
+
+} // namespace testtools
+
+#endif // TESTTOOLS_PRESSURETRIGGER_H
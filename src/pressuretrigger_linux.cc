@@ -0,0 +1,73 @@
+/// @file
+/// Реализация триггера задержек ресурса для Linux.
+
+#include "pressuretrigger.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+
+namespace testtools
+{
+
+using std::string;
+using std::chrono::steady_clock;
+
+PressureTrigger::PressureTrigger(const string& resource, bool full, uint32_t stall, uint32_t window)
+    : fd_(-1)
+    , wakeup_(-1)
+{
+    if ("cpu" != resource && "memory" != resource && "io" != resource)
+        throw AbstractObserver::Exception("Unknown pressure resource: " + resource);
+
+    // Триггеры регистрирует ядро, поэтому файл открывается в procfs ядра и при заданном procfs::SetRoot
+    const string path = string(procfs::kRoot) + "/pressure/" + resource;
+    fd_ = ::open(path.data(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (-1 == fd_) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    // Триггер действует, пока открыт файл, в который записано его описание (вместе с нулевым символом)
+    const string trigger = string(full ? "full " : "some ") + std::to_string(stall) + ' ' + std::to_string(window);
+    if (-1 == ::write(fd_, trigger.c_str(), trigger.size() + 1)) {
+        const errno_t code = static_cast<errno_t>(errno);
+        ::close(fd_);
+        throw AbstractObserver::SystemError(code);
+    }
+
+    wakeup_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (-1 == wakeup_) {
+        const errno_t code = static_cast<errno_t>(errno);
+        ::close(fd_);
+        throw AbstractObserver::SystemError(code);
+    }
+}
+
+PressureTrigger::~PressureTrigger()
+{
+    ::close(wakeup_);
+    ::close(fd_);
+}
+
+bool PressureTrigger::Wait(steady_clock::time_point deadline)
+{
+    struct pollfd fds[2] = { { fd_, POLLPRI, 0 }, { wakeup_, POLLIN, 0 } };
+    for (;;) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - steady_clock::now());
+        // Округляем вверх, чтобы не проснуться раньше момента опроса по расписанию
+        const int timeout = 0 < remaining.count() ? static_cast<int>(remaining.count()) + 1 : 0;
+
+        if (-1 != ::poll(fds, 2, timeout)) break;
+        if (EINTR != errno) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+    }
+
+    if (0 != (fds[1].revents & POLLIN)) return false;
+    // POLLERR означает, что наблюдаемый ресурс исчез (например, удалена cgroup)
+    if (0 != (fds[0].revents & POLLERR)) throw AbstractObserver::Exception("Pressure trigger is no longer valid.");
+    return 0 != (fds[0].revents & POLLPRI);
+}
+
+void PressureTrigger::Wake() noexcept
+{
+    const uint64_t value = 1;
+    ::write(wakeup_, &value, sizeof(value));
+}
+
+} // namespace testtools
@@ -0,0 +1,23 @@
+/// @file
+/// Реализация триггера задержек ресурса для Windows (не поддерживается).
+
+#include "pressuretrigger.h"
+
+namespace testtools
+{
+
+PressureTrigger::PressureTrigger(const std::string&, bool, uint32_t, uint32_t)
+{
+    throw AbstractObserver::Exception("Pressure triggers are supported only on Linux.");
+}
+
+PressureTrigger::~PressureTrigger() = default;
+
+bool PressureTrigger::Wait(std::chrono::steady_clock::time_point)
+{
+    return false;
+}
+
+void PressureTrigger::Wake() noexcept {}
+
+} // namespace testtools
@@ -9,11 +9,16 @@
 #include "abstractobserver.h"
 
 #include <list>
-#include <unordered_map>
+#include <vector>
 
 namespace testtools
 {
 
+#if defined(TESTTOOLS_LINUX)
+class CGroup;
+class ProcessTable;
+#endif
+
 /// Наблюдатель за производительностью процессов.
 class ProcessObserver : public AbstractObserver
 {
@@ -47,7 +52,7 @@ protected:
 
     public:
         /// Результат опроса счетчиков
-        typedef std::unordered_map<std::string, double> Result;
+        typedef Sample Result;
 
     public:
 #if defined(TESTTOOLS_WIN)
@@ -56,15 +61,25 @@ protected:
         /// @param[in] name Название процесса
         /// @param[in] index Индекс экземпляра
         Instance(pdh::Query query, const std::string& name, int16_t index = 0);
+#elif defined(TESTTOOLS_LINUX)
+        /// Открывает файлы procfs процесса, которые используются на протяжении всей жизни экземпляра
+        /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
+        /// @param[in] pid Идентификатор процесса
+        explicit Instance(uint32_t pid);
 #endif
         ~Instance() = default;
 
         /// Возвращает результат опроса счетчиков
-        /// @throw AbstractObserver#SystemError
+        /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
         /// @param[in] mask Маска счетчиков
-        /// @return Карта значений счетчиков в формате "счетчик=значение"
+        /// @return Значения счетчиков
         Result Poll(Mask mask) const;
 
+#if defined(TESTTOOLS_LINUX)
+        /// Возвращает идентификатор процесса
+        inline uint32_t GetPid() const noexcept { return pid_; }
+#endif
+
 #if defined(TESTTOOLS_WIN)
     private:
         /// Возвращает значение потребления физической памяти для конкретного экземпляра процесса
@@ -81,12 +96,36 @@ protected:
         static double GetVirtualMemoryUsage(pdh::Counter handle, bool kbytes = false);
 #endif
 
-#if defined(TESTTOOLS_WIN)
+#if defined(TESTTOOLS_LINUX)
+    private:
+        /// Проверяет, что процесс все еще существует и не был заменен другим с тем же pid
+        /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
+        /// @return Значения полей /proc/<pid>/stat
+        procfs::ProcessStat ReadStat() const;
+        /// Возвращает процент загрузки процессора процессом с момента предыдущего опроса
+        /// @param[in] stat Значения полей /proc/<pid>/stat
+        /// @return Процент загрузки процессора
+        double GetProcessorUsage(const procfs::ProcessStat& stat) const;
+        /// Возвращает объем резидентной памяти процесса
+        /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
+        /// @return Объем памяти в байтах
+        double GetPhysicalMemory() const;
+        /// Возвращает объем закрытой (private) памяти процесса - анонимной резидентной и выгруженной
+        /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
+        /// @return Объем памяти в байтах
+        double GetVirtualMemory() const;
+        /// Возвращает объем физической памяти, доступной процессу: лимит памяти группы cgroup,
+        /// если он установлен и меньше объема памяти системы
+        /// @return Объем памяти в байтах
+        double GetTotalPhysicalMemory() const;
+#endif
+
         /// Количество доступной физической памяти в байтах
         static double totalPhysicalMemory_;
         /// Количество доступной виртуальной памяти в байтах
         static double totalVirtualMemory_;
 
+#if defined(TESTTOOLS_WIN)
         /// Счетчик с идентификатором процесса
         pdh::UniqueCounter processId_;
         /// Счетчик количества открытых дескрипторов
@@ -100,6 +139,34 @@ protected:
         /// Счетчик потребления виртуальной памяти
         pdh::UniqueCounter virtualMemoryUsage_;
 #endif
+
+#if defined(TESTTOOLS_LINUX)
+        /// Идентификатор процесса
+        uint32_t pid_;
+        /// Время запуска процесса (в тиках с момента загрузки системы)
+        uint64_t start_;
+        /// Дескриптор процесса (pidfd), если поддерживается ядром
+        procfs::File pidfd_;
+        /// Файл /proc/<pid>/stat
+        procfs::File stat_;
+        /// Файл /proc/<pid>/statm
+        procfs::File statm_;
+        /// Файл /proc/<pid>/status
+        procfs::File status_;
+        /// Каталог /proc/<pid>/fd (открывается только при наличии прав)
+        procfs::Directory fd_;
+        /// Буфер для чтения файлов procfs
+        mutable procfs::Buffer<4096> buffer_;
+        /// Группа cgroup v2 наблюдателя или @b nullptr, если ресурсы не могут быть ограничены
+        std::shared_ptr<testtools::CGroup> cgroup_;
+
+        /// Время процессора (в тиках), затраченное процессом к моменту предыдущего опроса
+        mutable uint64_t processorTicks_;
+        /// Время предыдущего опроса в миллисекундах
+        mutable double processorTime_;
+        /// Процент загрузки процессора, вычисленный при предыдущем опросе
+        mutable double processorUsage_;
+#endif
     };
 
 protected:
@@ -117,7 +184,18 @@ class ProcessIdObserver final : public ProcessObserver
 {
 public:
     /// Результат опроса счетчиков
-    typedef std::unordered_map<std::string, double> Result;
+    typedef Sample Result;
+
+    /// Загрузка процессора потоком процесса
+    struct ThreadSample
+    {
+        uint32_t tid;       ///< Идентификатор потока
+        std::string name;   ///< Имя потока (в Windows не заполняется)
+        double usage;       ///< Процент загрузки процессора с момента предыдущего опроса
+    };
+
+    /// Результат опроса потоков процесса
+    typedef std::vector<ThreadSample> ThreadResult;
 
 public:
     /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
@@ -128,40 +206,132 @@ public:
     /// Возвращает результат опроса счетчиков
     /// @throw AbstractObserver#SystemError
     /// @param[in] mask Маска счетчиков
-    /// @return Карта значений счетчиков в формате "счетчик=значение"
-    Result Poll(Mask mask);
+    /// @param[in] snapshot Снимок списка процессов или @b nullptr (используется только в Windows)
+    /// @return Значения счетчиков
+    Result Poll(Mask mask, const ProcessSnapshot* snapshot = nullptr);
+
+    /// Возвращает загрузку процессора каждым потоком процесса с момента предыдущего вызова.
+    /// Состояние потоков (открытые файлы, время процессора) сохраняется между вызовами,
+    /// поэтому при неизменном составе потоков опрос сводится к одному чтению на поток.
+    /// Потоки, впервые обнаруженные при вызове, имеют нулевую загрузку.
+    /// @throw AbstractObserver#SystemError, ProcessObserver#ProcessNotFound
+    /// @param[in] top Количество самых загруженных потоков в результате (@b 0 - все потоки)
+    /// @return Загрузка процессора потоками (при @e top > 0 - по убыванию загрузки)
+    ThreadResult PollThreads(size_t top = 0);
+
+#if defined(TESTTOOLS_WIN)
+    /// @copydoc AbstractObserver#NeedsProcessSnapshot
+    inline bool NeedsProcessSnapshot() const noexcept override { return true; }
+#endif
+
+protected:
+    /// @copydoc AbstractObserver#CollectSamples
+    inline void CollectSamples(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot* snapshot) override {
+        samples.push_back(Poll(mask, snapshot));
+    }
+
+private:
+    /// Состояние потока между вызовами PollThreads
+    struct ThreadState
+    {
+        uint32_t tid;           ///< Идентификатор потока
+#if defined(TESTTOOLS_WIN)
+        std::shared_ptr<void> handle;   ///< Дескриптор потока
+#elif defined(TESTTOOLS_LINUX)
+        procfs::File stat;      ///< Файл /proc/<pid>/task/<tid>/stat
+#endif
+        std::string name;       ///< Имя потока
+        uint64_t time;          ///< Время процессора, затраченное потоком к моменту предыдущего опроса
+        double timestamp;       ///< Время предыдущего опроса в миллисекундах
+        double usage;           ///< Процент загрузки процессора, вычисленный при предыдущем опросе
+        bool alive;             ///< Поток существовал при последнем опросе
+    };
+
+    /// Открывает состояние потока и запоминает начальное время процессора
+    /// @param[in] tid Идентификатор потока
+    /// @param[out] state Состояние потока
+    /// @return @b true в случае успеха, @b false - если поток уже завершился
+    bool OpenThread(uint32_t tid, ThreadState& state);
+    /// Обновляет загрузку процессора потоком
+    /// @param[in,out] state Состояние потока
+    void UpdateThread(ThreadState& state);
 
 private:
     /// Идентификатор процесса
     uint32_t pid_;
+#if defined(TESTTOOLS_WIN)
     /// Индекс экземпляра процесса
     int16_t index_;
+#endif
     /// Наблюдатель за процессом
     std::unique_ptr<Instance> instance_;
+
+    /// Состояния потоков процесса (по возрастанию идентификаторов)
+    std::vector<ThreadState> threads_;
+    /// Идентификаторы потоков при текущем опросе (буфер, переиспользуемый между вызовами)
+    std::vector<uint32_t> tids_;
+#if defined(TESTTOOLS_LINUX)
+    /// Каталог /proc/<pid>/task
+    procfs::Directory task_;
+    /// Буфер для чтения файлов потоков
+    procfs::Buffer<1024> threadBuffer_;
+#endif
 }; // class ProcessIdObserver
 
 /// Наблюдатель за производительностью списка процессов по имени.
 class ProcessNameObserver final : public ProcessObserver
 {
 public:
-    /// Результаты опроса счетчиков
-    typedef std::list<std::unordered_map<std::string, double>> Result;
+    /// Результаты опроса счетчиков (по одному на каждый экземпляр процесса)
+    typedef std::vector<Sample> Result;
 
 public:
     /// @throw AbstractObserver#SystemError
     /// @param[in] name Название процесса
-    explicit ProcessNameObserver(const std::string& name);
+    /// @param[in] events Отслеживать запуск и завершение процессов по событиям ядра
+    /// вместо обхода списка процессов при каждом опросе (только Linux, см. ProcessTable)
+    explicit ProcessNameObserver(const std::string& name, bool events = false);
     ~ProcessNameObserver() = default;
 
     /// Возвращает результат опроса счетчиков
     /// @throw AbstractObserver#SystemError
     /// @param[in] mask Маска счетчиков
-    /// @return Массив карт значений счетчиков в формате "счетчик=значение" для каждого экземпляра процесса
-    Result Poll(Mask mask);
+    /// @return Значения счетчиков для каждого экземпляра процесса
+    inline Result Poll(Mask mask) {
+        Result presult = {};
+        CollectSamples(mask, presult, nullptr);
+        return presult;
+    }
+
+    /// @copydoc AbstractObserver#NeedsProcessSnapshot
+    bool NeedsProcessSnapshot() const noexcept override;
+
+protected:
+    /// @copydoc AbstractObserver#CollectSamples
+    void CollectSamples(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot* snapshot) override;
 
 private:
     /// Список умных указателей на экземпляры процессов
     std::list<std::unique_ptr<Instance>> instances_;
+#if defined(TESTTOOLS_LINUX)
+private:
+    /// Ищет процессы с наблюдаемым именем обходом /proc (или по снимку списка процессов)
+    /// и обновляет список экземпляров
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] snapshot Снимок списка процессов или @b nullptr
+    void Rescan(const ProcessSnapshot* snapshot);
+    /// Обновляет список экземпляров по списку идентификаторов процессов из таблицы процессов
+    /// @param[in] pids Идентификаторы процессов, имя которых совпадает с наблюдаемым
+    void Update(const std::vector<uint32_t>& pids);
+
+private:
+    /// Каталог /proc (для поиска процессов по имени)
+    procfs::Directory proc_;
+    /// Таблица процессов (только в режиме отслеживания по событиям)
+    std::shared_ptr<ProcessTable> table_;
+    /// Поколение записи таблицы процессов, по которому построен список экземпляров
+    uint64_t generation_;
+#endif
 }; // class ProcessNameObserver
 
 } // namespace testtools
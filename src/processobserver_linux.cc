@@ -0,0 +1,543 @@
+/// @file
+/// Реализация работы наблюдателя за процессами для Linux.
+
+#include "processobserver.h"
+#include "cgroup.h"
+#include "processtable.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <poll.h>
+#include <sys/sysinfo.h>
+
+/// Делитель для перевода байт в килобайты
+#define KBYTESDIV 1024
+
+// Системный вызов pidfd_open появился в Linux 5.3 и может отсутствовать в заголовках
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+namespace testtools
+{
+
+using std::string;
+using std::list;
+using std::vector;
+
+/// Функции-помощники ProcessObserver
+namespace
+{
+
+/// Количество тиков системного таймера в секунду
+const double kClockTicks = static_cast<double>(::sysconf(_SC_CLK_TCK));
+/// Минимальный интервал вычисления загрузки процессора (в миллисекундах).
+/// Время процесса учитывается с точностью до тика, поэтому на меньших интервалах
+/// погрешность одного тика искажает значение в разы.
+const double kMinProcessorInterval = 100.;
+/// Размер страницы памяти в байтах
+const double kPageSize = static_cast<double>(::sysconf(_SC_PAGESIZE));
+
+/// Открывает дескриптор процесса (pidfd)
+/// @param[in] pid Идентификатор процесса
+/// @return Дескриптор процесса или @b -1, если процесс не найден или ядро не поддерживает pidfd
+int OpenPidfd(uint32_t pid)
+{
+    return static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+}
+
+/// Проверяет, соответствует ли процесс указанному имени.
+/// Ядро хранит только первые 15 символов имени (comm), поэтому для длинных имен
+/// дополнительно сравнивается имя файла из первого аргумента командной строки.
+/// @param[in] proc Дескриптор каталога /proc
+/// @param[in] pid Идентификатор процесса
+/// @param[in] comm Имя процесса из /proc/<pid>/stat
+/// @param[in] name Искомое имя процесса
+/// @return @b true, если имя процесса совпадает с искомым
+bool IsProcessName(int proc, uint32_t pid, const char* comm, const string& name)
+{
+    static const size_t kCommLength = 15;
+
+    if (name.size() <= kCommLength || std::strlen(comm) != kCommLength)
+        return name == comm;
+    if (0 != name.compare(0, kCommLength, comm))
+        return false;
+
+    procfs::Buffer<4096> buffer;
+    std::snprintf(buffer.data(), buffer.size(), "%u/cmdline", pid);
+
+    procfs::File file;
+    if (!file.Open(proc, buffer.data()) || 0 >= file.Read(buffer)) return false;
+
+    // Аргументы в cmdline разделены нулевыми символами - берем имя файла из первого
+    const char* slash = std::strrchr(buffer.data(), '/');
+    return name == (nullptr == slash ? buffer.data() : slash + 1);
+}
+
+/// Возвращает имя процесса по его индентификатору
+/// @param[in] pid Идентификатор процесса
+/// @return Имя процесса в случае успеха или пустая строка, если процесс не найден
+std::string GetProcessNameByPid(uint32_t pid)
+{
+    procfs::Directory proc;
+    procfs::ProcessStat stat = { 0 };
+    if (!proc.Open(procfs::GetRoot()) || !procfs::ReadProcessStat(proc.Get(), pid, stat)) return string();
+
+    return stat.name;
+}
+
+/// Заполняет общее количество физической и виртуальной памяти
+/// @throw AbstractObserver#SystemError
+/// @param[out] physical Количество физической памяти в байтах
+/// @param[out] virtual_ Количество виртуальной памяти (физической и подкачки) в байтах
+void GetTotalMemory(double& physical, double& virtual_)
+{
+    struct sysinfo info = { 0 };
+    if (0 != ::sysinfo(&info))
+        throw ProcessObserver::SystemError(static_cast<errno_t>(errno));
+
+    physical = static_cast<double>(info.totalram) * info.mem_unit;
+    virtual_ = static_cast<double>(info.totalram + info.totalswap) * info.mem_unit;
+}
+
+} // namespace
+
+double ProcessObserver::Instance::totalPhysicalMemory_ = -1.;
+double ProcessObserver::Instance::totalVirtualMemory_ = -1.;
+
+ProcessObserver::ProcessNotFound::ProcessNotFound(uint32_t pid)
+    : Exception(("Process with id " + std::to_string(pid) + " not found.")) {}
+
+ProcessObserver::Instance::Instance(uint32_t pid)
+    : pid_(pid)
+    , start_(0)
+    , pidfd_()
+    , stat_()
+    , statm_()
+    , status_()
+    , fd_()
+    , buffer_({ '\0' })
+    , cgroup_(CGroup::GetCurrent())
+    , processorTicks_(0)
+    , processorTime_(0.)
+    , processorUsage_(0.)
+{
+    // Дескриптор процесса открываем первым: если процесс завершится и его pid будет занят
+    // другим процессом до открытия файлов, то это будет обнаружено при проверке времени запуска.
+    // Процессы синтетического дерева procfs не существуют в системе, для них pidfd не открывается.
+    if (procfs::IsSystemRoot()) {
+        pidfd_.Reset(OpenPidfd(pid));
+        if (!pidfd_.IsOpen() && ESRCH == errno) throw ProcessNotFound(pid);
+    }
+
+    procfs::Buffer<PATH_MAX> path;
+    std::snprintf(path.data(), path.size(), "%s/%u", procfs::GetRoot(), pid);
+
+    procfs::Directory dir;
+    if (!dir.Open(path.data())) {
+        if (ENOENT == errno || ESRCH == errno) throw ProcessNotFound(pid);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    if (!stat_.Open(dir.Get(), "stat") || !statm_.Open(dir.Get(), "statm") || !status_.Open(dir.Get(), "status")) {
+        if (ENOENT == errno || ESRCH == errno) throw ProcessNotFound(pid);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    // Список открытых дескрипторов доступен только владельцу процесса (или root),
+    // поэтому при отсутствии прав счетчик дескрипторов просто не возвращается.
+    fd_.Open(dir.Get(), "fd");
+
+    // Запоминаем время запуска процесса для обнаружения повторного использования pid
+    // и начальное время процессора для вычисления загрузки при первом опросе.
+    if (-1 == stat_.Read(buffer_)) throw ProcessNotFound(pid);
+
+    procfs::ProcessStat stat = { 0 };
+    if (!procfs::ParseProcessStat(buffer_.data(), stat)) throw ProcessNotFound(pid);
+
+    start_ = stat.start;
+    processorTicks_ = stat.utime + stat.stime;
+    processorTime_ = procfs::GetMonotonicTime();
+}
+
+ProcessObserver::Instance::Result ProcessObserver::Instance::Poll(Mask mask) const
+{
+    const procfs::ProcessStat stat = ReadStat();
+
+    Instance::Result presult(pid_);
+    if ((HandleCount & mask) && fd_.IsOpen()) {
+        const ssize_t count = fd_.Count();
+        if (-1 != count) presult.Set(HandleCount, static_cast<double>(count));
+    }
+    if (ThreadCount & mask)
+        presult.Set(ThreadCount, static_cast<double>(stat.threads));
+    if (ProcessorUsage & mask)
+        presult.Set(ProcessorUsage, GetProcessorUsage(stat));
+
+    if ((PhysicalMemoryUsage | PhysicalMemoryUsageKBytes) & mask) {
+        const double used = GetPhysicalMemory();
+        if (PhysicalMemoryUsage & mask)
+            presult.Set(PhysicalMemoryUsage, std::floor((used * 100) / GetTotalPhysicalMemory()));
+        if (PhysicalMemoryUsageKBytes & mask)
+            presult.Set(PhysicalMemoryUsageKBytes, used / KBYTESDIV);
+    }
+
+    if ((VirtualMemoryUsage | VirtualMemoryUsageKBytes) & mask) {
+        const double used = GetVirtualMemory();
+        if (VirtualMemoryUsage & mask)
+            presult.Set(VirtualMemoryUsage, std::floor((used * 100) / totalVirtualMemory_));
+        if (VirtualMemoryUsageKBytes & mask)
+            presult.Set(VirtualMemoryUsageKBytes, used / KBYTESDIV);
+    }
+
+    return presult;
+}
+
+procfs::ProcessStat ProcessObserver::Instance::ReadStat() const
+{
+    // Дескриптор процесса становится доступным для чтения, как только процесс завершается
+    // (в том числе, пока он остается "зомби"), что позволяет не разбирать stat понапрасну.
+    if (pidfd_.IsOpen()) {
+        struct pollfd pfd = { pidfd_.Get(), POLLIN, 0 };
+        if (0 < ::poll(&pfd, 1, 0)) throw ProcessNotFound(pid_);
+    }
+
+    // После завершения процесса чтение из ранее открытых файлов возвращает ESRCH,
+    // даже если его pid уже занят новым процессом.
+    if (-1 == stat_.Read(buffer_)) {
+        if (ESRCH == errno) throw ProcessNotFound(pid_);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    procfs::ProcessStat stat = { 0 };
+    if (!procfs::ParseProcessStat(buffer_.data(), stat)) throw ProcessNotFound(pid_);
+
+    if (start_ != stat.start || 'Z' == stat.state || 'X' == stat.state)
+        throw ProcessNotFound(pid_);
+
+    return stat;
+}
+
+double ProcessObserver::Instance::GetProcessorUsage(const procfs::ProcessStat& stat) const
+{
+    const uint64_t ticks = stat.utime + stat.stime;
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - processorTime_;
+    if (kMinProcessorInterval > elapsed) return processorUsage_;
+
+    /// @note Как и счетчик "% Processor Time" в Windows, значение не нормируется на количество
+    /// процессоров и для многопоточного процесса может превышать 100%.
+    if (ticks >= processorTicks_)
+        processorUsage_ = (static_cast<double>(ticks - processorTicks_) / kClockTicks) * 100000. / elapsed;
+
+    processorTicks_ = ticks;
+    processorTime_ = time;
+    return processorUsage_;
+}
+
+double ProcessObserver::Instance::GetPhysicalMemory() const
+{
+    if (-1 == statm_.Read(buffer_)) {
+        if (ESRCH == errno) throw ProcessNotFound(pid_);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    // Формат файла: "size resident shared text lib data dt" (в страницах)
+    uint64_t resident = 0;
+    procfs::ParseUInt(procfs::SkipField(buffer_.data()), resident);
+
+    return static_cast<double>(resident) * kPageSize;
+}
+
+double ProcessObserver::Instance::GetVirtualMemory() const
+{
+    if (-1 == status_.Read(buffer_)) {
+        if (ESRCH == errno) throw ProcessNotFound(pid_);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    // Аналогом "Private Bytes" из Windows считаем анонимную резидентную память вместе
+    // с выгруженной в подкачку. Поле RssAnon отсутствует в ядрах до 4.5.
+    uint64_t anonymous = 0;
+    uint64_t swap = 0;
+    const char* p = procfs::FindLine(buffer_.data(), "RssAnon:");
+    if (nullptr == p) p = procfs::FindLine(buffer_.data(), "VmRSS:");
+    if (nullptr != p) procfs::ParseUInt(p, anonymous);
+    if (nullptr != (p = procfs::FindLine(buffer_.data(), "VmSwap:"))) procfs::ParseUInt(p, swap);
+
+    return static_cast<double>(anonymous + swap) * KBYTESDIV;
+}
+
+double ProcessObserver::Instance::GetTotalPhysicalMemory() const
+{
+    const double limit = cgroup_ ? cgroup_->GetMemoryLimit() : 0.;
+    return (0. < limit && limit < totalPhysicalMemory_) ? limit : totalPhysicalMemory_;
+}
+
+ProcessObserver::ProcessObserver(uint32_t pid)
+    : AbstractObserver(ProcessId, GetProcessNameByPid(pid))
+{
+    GetTotalMemory(Instance::totalPhysicalMemory_, Instance::totalVirtualMemory_);
+}
+
+ProcessObserver::ProcessObserver(const string& name)
+    : AbstractObserver(ProcessName, name)
+{
+    GetTotalMemory(Instance::totalPhysicalMemory_, Instance::totalVirtualMemory_);
+}
+
+ProcessIdObserver::ProcessIdObserver(uint32_t pid)
+    : ProcessObserver(pid)
+    , pid_(pid)
+    , instance_(nullptr)
+{
+    if (GetObject().empty()) throw ProcessNotFound(pid);
+    instance_.reset(new Instance(pid));
+
+    procfs::Buffer<PATH_MAX> path;
+    std::snprintf(path.data(), path.size(), "%s/%u/task", procfs::GetRoot(), pid);
+    if (!task_.Open(path.data())) {
+        if (ENOENT == errno || ESRCH == errno) throw ProcessNotFound(pid);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+}
+
+ProcessIdObserver::Result ProcessIdObserver::Poll(Mask mask, const ProcessSnapshot*)
+{
+    // В отличие от Windows, экземпляр не требует переинициализации: файлы procfs
+    // остаются привязанными к процессу, а его завершение обнаруживается при чтении.
+    return instance_->Poll(mask);
+}
+
+ProcessIdObserver::ThreadResult ProcessIdObserver::PollThreads(size_t top)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Каталог task открыт на все время жизни наблюдателя, поэтому после завершения
+    // процесса он остается пустым, даже если pid уже занят другим процессом.
+    tids_.clear();
+    if (!task_.ForEachId([this](uint32_t tid) { tids_.push_back(tid); })) {
+        if (ENOENT == errno || ESRCH == errno) throw ProcessNotFound(pid_);
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+    if (tids_.empty()) throw ProcessNotFound(pid_);
+    std::sort(tids_.begin(), tids_.end());
+
+    // Состояния перестраиваются только при изменении состава потоков: уже открытые
+    // файлы переносятся, открываются файлы только для новых потоков.
+    const bool changed = tids_.size() != threads_.size() ||
+        !std::equal(tids_.begin(), tids_.end(), threads_.begin(),
+            [](uint32_t tid, const ThreadState& state) { return tid == state.tid; });
+    if (changed) {
+        vector<ThreadState> threads;
+        threads.reserve(tids_.size());
+        auto it = threads_.begin();
+        for (const uint32_t tid : tids_) {
+            while (threads_.end() != it && it->tid < tid) ++it;
+            if (threads_.end() != it && it->tid == tid) {
+                threads.push_back(std::move(*it++));
+                continue;
+            }
+            ThreadState state;
+            if (OpenThread(tid, state)) threads.push_back(std::move(state));
+        }
+        threads_.swap(threads);
+    }
+
+    ThreadResult presult;
+    presult.reserve(threads_.size());
+    for (ThreadState& state : threads_) {
+        UpdateThread(state);
+        if (state.alive) presult.push_back({ state.tid, state.name, state.usage });
+    }
+    if (presult.empty()) throw ProcessNotFound(pid_);
+
+    if (0 != top && top < presult.size()) {
+        std::partial_sort(presult.begin(), presult.begin() + top, presult.end(),
+            [](const ThreadSample& a, const ThreadSample& b) { return a.usage > b.usage; });
+        presult.resize(top);
+    }
+
+    return presult;
+}
+
+bool ProcessIdObserver::OpenThread(uint32_t tid, ThreadState& state)
+{
+    procfs::Buffer<32> path;
+    std::snprintf(path.data(), path.size(), "%u/stat", tid);
+
+    state.tid = tid;
+    state.usage = 0.;
+    state.alive = false;
+    if (!state.stat.Open(task_.Get(), path.data())) {
+        if (ENOENT == errno || ESRCH == errno) return false;
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    // Имя потока (comm) содержится в stat, поэтому отдельный файл comm не читается
+    procfs::ProcessStat stat = { 0 };
+    if (-1 == state.stat.Read(threadBuffer_) || !procfs::ParseProcessStat(threadBuffer_.data(), stat))
+        return false;
+
+    state.name = stat.name;
+    state.time = stat.utime + stat.stime;
+    state.timestamp = procfs::GetMonotonicTime();
+    state.alive = true;
+    return true;
+}
+
+void ProcessIdObserver::UpdateThread(ThreadState& state)
+{
+    if (!state.alive) return;
+
+    // Завершившийся поток исключается из результата, а его состояние - при следующем
+    // изменении состава потоков.
+    procfs::ProcessStat stat = { 0 };
+    if (-1 == state.stat.Read(threadBuffer_) || !procfs::ParseProcessStat(threadBuffer_.data(), stat) ||
+        'Z' == stat.state || 'X' == stat.state) {
+        state.alive = false;
+        return;
+    }
+
+    // Поток может сменить имя в любой момент (pthread_setname_np)
+    if (0 != state.name.compare(stat.name)) state.name = stat.name;
+
+    const uint64_t ticks = stat.utime + stat.stime;
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - state.timestamp;
+    if (kMinProcessorInterval > elapsed) return;
+
+    if (ticks >= state.time)
+        state.usage = (static_cast<double>(ticks - state.time) / kClockTicks) * 100000. / elapsed;
+
+    state.time = ticks;
+    state.timestamp = time;
+}
+
+ProcessNameObserver::ProcessNameObserver(const std::string& name, bool events)
+    : ProcessObserver(name)
+    , proc_(procfs::GetRoot())
+    , table_(events ? ProcessTable::Get() : nullptr)
+    , generation_(std::numeric_limits<uint64_t>::max())
+{
+    Poll(0);
+}
+
+bool ProcessNameObserver::NeedsProcessSnapshot() const noexcept
+{
+    // В режиме отслеживания по событиям список процессов берется из таблицы процессов
+    return !table_;
+}
+
+void ProcessNameObserver::CollectSamples(Mask mask, vector<Sample>& samples, const ProcessSnapshot* snapshot)
+{
+    // В режиме отслеживания по событиям список экземпляров меняется только
+    // при изменении записи таблицы процессов для наблюдаемого имени.
+    if (table_) {
+        vector<uint32_t> pids = {};
+        if (table_->Find(GetObject(), generation_, pids)) Update(pids);
+    }
+    else {
+        Rescan(snapshot);
+    }
+
+    samples.reserve(samples.size() + instances_.size());
+    for (auto it = instances_.begin(); it != instances_.end();) {
+        try {
+            samples.push_back((*it)->Poll(mask));
+            ++it;
+        }
+        catch (const ProcessNotFound&) {
+            it = instances_.erase(it);
+
+            // Идентификатор мог быть занят новым процессом с тем же именем: состав записи таблицы
+            // при этом не изменится, поэтому при следующем опросе список перестраивается заново
+            generation_ = std::numeric_limits<uint64_t>::max();
+        }
+    }
+}
+
+void ProcessNameObserver::Rescan(const ProcessSnapshot* snapshot)
+{
+    const string& name = GetObject();
+
+    // Идентификаторы уже наблюдаемых процессов (отсортированы для быстрого поиска)
+    vector<uint32_t> known = {};
+    known.reserve(instances_.size());
+    for (const auto& instance : instances_)
+        known.push_back(instance->GetPid());
+    std::sort(known.begin(), known.end());
+
+    // Обходим /proc: для уже наблюдаемых процессов лишь отмечаем, что они еще существуют,
+    // для остальных - сравниваем имя и создаем экземпляры наблюдателей для подходящих.
+    // Если имя процесса уже известно из снимка, stat процесса не читается.
+    vector<uint32_t> alive = {};
+    alive.reserve(known.size());
+    const int proc = proc_.Get();
+    const auto visit = [&](uint32_t pid, const char* comm) {
+        if (std::binary_search(known.begin(), known.end(), pid)) {
+            alive.push_back(pid);
+            return;
+        }
+
+        procfs::ProcessStat stat = { 0 };
+        if (nullptr == comm) {
+            if (!procfs::ReadProcessStat(proc, pid, stat)) return;
+            comm = stat.name;
+        }
+        if (!IsProcessName(proc, pid, comm, name)) return;
+
+        try {
+            instances_.push_back(std::make_unique<Instance>(pid));
+        }
+        catch (const ProcessNotFound&) {}
+    };
+
+    if (nullptr != snapshot) {
+        for (const auto& entry : *snapshot)
+            visit(entry.pid, entry.name.data());
+    }
+    else if (!proc_.ForEachId([&visit](uint32_t pid) { visit(pid, nullptr); })) {
+        throw SystemError(static_cast<errno_t>(errno));
+    }
+
+    std::sort(alive.begin(), alive.end());
+    instances_.remove_if([&known, &alive](const std::unique_ptr<Instance>& instance) {
+        const uint32_t pid = instance->GetPid();
+        return std::binary_search(known.begin(), known.end(), pid)
+            && !std::binary_search(alive.begin(), alive.end(), pid);
+    });
+}
+
+void ProcessNameObserver::Update(const vector<uint32_t>& pids)
+{
+    const string& name = GetObject();
+
+    // Удаляем экземпляры процессов, которых больше нет в таблице
+    instances_.remove_if([&pids](const std::unique_ptr<Instance>& instance) {
+        return pids.end() == std::find(pids.begin(), pids.end(), instance->GetPid());
+    });
+
+    // Таблица индексирует процессы по первым 15 символам имени, поэтому
+    // полное имя новых процессов дополнительно проверяется через IsProcessName.
+    const int proc = proc_.Get();
+    for (const auto pid : pids) {
+        const bool known = instances_.end() != std::find_if(instances_.begin(), instances_.end(),
+            [pid](const std::unique_ptr<Instance>& instance) { return pid == instance->GetPid(); });
+        if (known) continue;
+
+        procfs::ProcessStat stat = { 0 };
+        if (!procfs::ReadProcessStat(proc, pid, stat) || !IsProcessName(proc, pid, stat.name, name)) continue;
+
+        try {
+            instances_.push_back(std::make_unique<Instance>(pid));
+        }
+        catch (const ProcessNotFound&) {}
+    }
+}
+
+} // namespace testtools
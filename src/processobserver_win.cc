@@ -3,6 +3,8 @@
 
 #include "processobserver.h"
 
+#include <algorithm>
+
 /// Делитель для перевода байт в килобайты
 #define KBYTESDIV 1024
 
@@ -11,12 +13,16 @@ namespace testtools
 
 using std::string;
 using std::list;
-using std::unordered_map;
+using std::vector;
 
 /// Функции-помощники ProcessObserver
 namespace
 {
 
+/// Минимальный интервал вычисления загрузки процессора потоком (в миллисекундах).
+/// Время потока учитывается с точностью до кванта планировщика (~15,6 мс).
+const double kMinProcessorInterval = 100.;
+
 /// Возвращает имя процесса по его индентификатору
 /// @throw AbstractObserver#SystemError
 /// @param[in] pid Идентификатор процесса
@@ -76,6 +82,41 @@ int16_t GetProcessInstanceIndex(const char* name, uint32_t pid)
     return index;
 }
 
+/// Возвращает индекс экземпляра процесса по его имени и идентификатору из снимка списка процессов
+/// @param[in] snapshot Снимок списка процессов
+/// @param[in] name Имя процесса
+/// @param[in] pid Идентификатор процесса
+/// @return Индекс экземпляра в случае успеха или @b -1, если экземпляр не найден
+int16_t GetProcessInstanceIndex(const ProcessObserver::ProcessSnapshot& snapshot, const string& name, uint32_t pid)
+{
+    int16_t index = -1;
+    for (const auto& entry : snapshot) {
+        if (entry.name != name) continue;
+
+        index++;
+        if (entry.pid == pid) break;
+    }
+
+    return index;
+}
+
+/// Возвращает время процессора, затраченное потоком (в единицах по 100 наносекунд)
+/// @param[in] thread Дескриптор потока
+/// @param[out] time Время процессора
+/// @return @b true в случае успеха, @b false - если поток недоступен
+bool GetThreadTime(HANDLE thread, uint64_t& time) noexcept
+{
+    FILETIME creation, exit, kernel, user;
+    if (!::GetThreadTimes(thread, &creation, &exit, &kernel, &user)) return false;
+
+    // Время завершения заполняется только для завершившегося потока
+    if (0 != exit.dwLowDateTime || 0 != exit.dwHighDateTime) return false;
+
+    time = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+        ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+    return true;
+}
+
 } // namespace
 
 double ProcessObserver::Instance::totalPhysicalMemory_ = -1.;
@@ -143,22 +184,21 @@ ProcessObserver::Instance::Instance(pdh::Query query, const string& name, int16_
 
 ProcessObserver::Instance::Result ProcessNameObserver::Instance::Poll(Mask mask) const
 {
-    Instance::Result presult = {};
-    presult.emplace(std::make_pair("pid", GetPdhValue(processId_.get())));
+    Instance::Result presult(static_cast<uint32_t>(GetPdhValue(processId_.get())));
     if (HandleCount & mask)
-        presult.emplace(std::make_pair("handles", GetPdhValue(handleCount_.get())));
+        presult.Set(HandleCount, GetPdhValue(handleCount_.get()));
     if (ThreadCount & mask)
-        presult.emplace(std::make_pair("threads", GetPdhValue(threadCount_.get())));
+        presult.Set(ThreadCount, GetPdhValue(threadCount_.get()));
     if (ProcessorUsage & mask)
-        presult.emplace(std::make_pair("procusage", GetPdhValue(processorUsage_.get())));
+        presult.Set(ProcessorUsage, GetPdhValue(processorUsage_.get()));
     if (PhysicalMemoryUsage & mask)
-        presult.emplace(std::make_pair("pmemusage", GetPhysicalMemoryUsage(physicalMemoryUsage_.get(), false)));
+        presult.Set(PhysicalMemoryUsage, GetPhysicalMemoryUsage(physicalMemoryUsage_.get(), false));
     if (PhysicalMemoryUsageKBytes & mask)
-        presult.emplace(std::make_pair("pmemusagekb", GetPhysicalMemoryUsage(physicalMemoryUsage_.get(), true)));
+        presult.Set(PhysicalMemoryUsageKBytes, GetPhysicalMemoryUsage(physicalMemoryUsage_.get(), true));
     if (VirtualMemoryUsage & mask)
-        presult.emplace(std::make_pair("vmemusage", GetVirtualMemoryUsage(virtualMemoryUsage_.get(), false)));
+        presult.Set(VirtualMemoryUsage, GetVirtualMemoryUsage(virtualMemoryUsage_.get(), false));
     if (VirtualMemoryUsageKBytes & mask)
-        presult.emplace(std::make_pair("vmemusagekb", GetVirtualMemoryUsage(virtualMemoryUsage_.get(), true)));
+        presult.Set(VirtualMemoryUsageKBytes, GetVirtualMemoryUsage(virtualMemoryUsage_.get(), true));
 
     return presult;
 }
@@ -214,12 +254,14 @@ ProcessIdObserver::ProcessIdObserver(uint32_t pid)
     else instance_.reset(new Instance(query_.get(), name, index_));
 }
 
-ProcessIdObserver::Result ProcessIdObserver::Poll(Mask mask)
+ProcessIdObserver::Result ProcessIdObserver::Poll(Mask mask, const ProcessSnapshot* snapshot)
 {
     const string name = GetObject();
     // Получаем текущий индекс экземпляра и сравниваем с сохраненным. Если значения 
     // не равны - переинициализируем объект наблюдателя с нужным индексом.
-    const int16_t index = GetProcessInstanceIndex(name.data(), pid_);
+    const int16_t index = nullptr == snapshot
+        ? GetProcessInstanceIndex(name.data(), pid_)
+        : GetProcessInstanceIndex(*snapshot, name, pid_);
     if (index_ != index) {
         instance_.reset(new Instance(query_.get(), name, index));
         index_ = index;
@@ -231,7 +273,111 @@ ProcessIdObserver::Result ProcessIdObserver::Poll(Mask mask)
     return instance_->Poll(mask);
 }
 
-ProcessNameObserver::ProcessNameObserver(const std::string& name)
+ProcessIdObserver::ThreadResult ProcessIdObserver::PollThreads(size_t top)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (INVALID_HANDLE_VALUE == snapshot)
+        throw SystemError(static_cast<errno_t>(::GetLastError()));
+
+    THREADENTRY32 entry = { 0 };
+    entry.dwSize = sizeof(entry);
+    if (!::Thread32First(snapshot, &entry)) {
+        ::CloseHandle(snapshot);
+        throw SystemError(static_cast<errno_t>(::GetLastError()));
+    }
+
+    tids_.clear();
+    do if (entry.th32OwnerProcessID == static_cast<DWORD>(pid_)) tids_.push_back(entry.th32ThreadID);
+    while (::Thread32Next(snapshot, &entry));
+
+    ::CloseHandle(snapshot);
+
+    if (tids_.empty()) throw ProcessNotFound(pid_);
+    std::sort(tids_.begin(), tids_.end());
+
+    // Состояния перестраиваются только при изменении состава потоков: уже открытые
+    // дескрипторы переносятся, открываются дескрипторы только для новых потоков.
+    const bool changed = tids_.size() != threads_.size() ||
+        !std::equal(tids_.begin(), tids_.end(), threads_.begin(),
+            [](uint32_t tid, const ThreadState& state) { return tid == state.tid; });
+    if (changed) {
+        vector<ThreadState> threads;
+        threads.reserve(tids_.size());
+        auto it = threads_.begin();
+        for (const uint32_t tid : tids_) {
+            while (threads_.end() != it && it->tid < tid) ++it;
+            if (threads_.end() != it && it->tid == tid) {
+                threads.push_back(std::move(*it++));
+                continue;
+            }
+            ThreadState state;
+            if (OpenThread(tid, state)) threads.push_back(std::move(state));
+        }
+        threads_.swap(threads);
+    }
+
+    ThreadResult presult;
+    presult.reserve(threads_.size());
+    for (ThreadState& state : threads_) {
+        UpdateThread(state);
+        if (state.alive) presult.push_back({ state.tid, state.name, state.usage });
+    }
+    if (presult.empty()) throw ProcessNotFound(pid_);
+
+    if (0 != top && top < presult.size()) {
+        std::partial_sort(presult.begin(), presult.begin() + top, presult.end(),
+            [](const ThreadSample& a, const ThreadSample& b) { return a.usage > b.usage; });
+        presult.resize(top);
+    }
+
+    return presult;
+}
+
+bool ProcessIdObserver::OpenThread(uint32_t tid, ThreadState& state)
+{
+    // Права THREAD_QUERY_LIMITED_INFORMATION появились в Windows Vista
+    const DWORD access = IsWindowsVistaOrGreater() ? THREAD_QUERY_LIMITED_INFORMATION : THREAD_QUERY_INFORMATION;
+
+    state.tid = tid;
+    state.usage = 0.;
+    state.alive = false;
+
+    HANDLE thread = ::OpenThread(access, FALSE, static_cast<DWORD>(tid));
+    if (nullptr == thread) return false;
+    state.handle.reset(thread, ::CloseHandle);
+
+    if (!GetThreadTime(thread, state.time)) return false;
+
+    state.timestamp = pdh::GetMonotonicTime();
+    state.alive = true;
+    return true;
+}
+
+void ProcessIdObserver::UpdateThread(ThreadState& state)
+{
+    if (!state.alive) return;
+
+    uint64_t time = 0;
+    if (!GetThreadTime(state.handle.get(), time)) {
+        state.alive = false;
+        return;
+    }
+
+    const double now = pdh::GetMonotonicTime();
+    const double elapsed = now - state.timestamp;
+    if (kMinProcessorInterval > elapsed) return;
+
+    // Время потока измеряется в единицах по 100 наносекунд
+    if (time >= state.time)
+        state.usage = (static_cast<double>(time - state.time) / 10000.) * 100. / elapsed;
+
+    state.time = time;
+    state.timestamp = now;
+}
+
+ProcessNameObserver::ProcessNameObserver(const std::string& name, bool)
     : ProcessObserver(name)
 {
     HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
@@ -257,21 +403,22 @@ ProcessNameObserver::ProcessNameObserver(const std::string& name)
     ::CloseHandle(snapshot);
 }
 
-ProcessNameObserver::Result ProcessNameObserver::Poll(Mask mask)
+bool ProcessNameObserver::NeedsProcessSnapshot() const noexcept
 {
-    HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (INVALID_HANDLE_VALUE == snapshot)
-        throw SystemError(static_cast<errno_t>(::GetLastError()));
-
-    const string name = GetObject();
+    return true;
+}
 
-    PROCESSENTRY32 entry = { 0 };
-    entry.dwSize = sizeof(entry);
-    if (!::Process32First(snapshot, &entry)) {
-        ::CloseHandle(snapshot);
-        throw SystemError(static_cast<errno_t>(::GetLastError()));
+void ProcessNameObserver::CollectSamples(Mask mask, vector<Sample>& samples, const ProcessSnapshot* snapshot)
+{
+    // Если снимок списка процессов не передан (опрос только этого наблюдателя) - получаем его сами
+    ProcessSnapshot own = {};
+    if (nullptr == snapshot) {
+        own = GetProcessSnapshot();
+        snapshot = &own;
     }
 
+    const string name = GetObject();
+
     // Получаем текущее количество процессов с указанным именем и соответствующим образом
     // изменяем количество нужных экземпляров наблюдателей (объекты класса Instance).
     // Поскольку в классе Instance присутствует счетчик, который возвращает pid процесса по
@@ -290,10 +437,8 @@ ProcessNameObserver::Result ProcessNameObserver::Poll(Mask mask)
     // только поддерживать в актульном состоянии число объектов класса Instance.
 
     size_t index = 0;
-    do if (0 == std::strcmp(entry.szExeFile, name.data())) index++;
-    while (::Process32Next(snapshot, &entry));
-
-    ::CloseHandle(snapshot);
+    for (const auto& entry : *snapshot)
+        if (entry.name == name) index++;
 
     if (index < instances_.size())
         instances_.resize(index);
@@ -305,11 +450,9 @@ ProcessNameObserver::Result ProcessNameObserver::Poll(Mask mask)
     const pdh::Result result = ::PdhCollectQueryData(query_.get());
     if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
 
-    Result presult = {};
+    samples.reserve(samples.size() + instances_.size());
     for (const auto& instance : instances_)
-        presult.push_front(instance->Poll(mask));
-
-    return presult;
+        samples.push_back(instance->Poll(mask));
 }
 
 } // namespace testtools
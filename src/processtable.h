@@ -0,0 +1,107 @@
+/// @file
+/// Объявление таблицы процессов, поддерживаемой по событиям ядра (только Linux).
+
+#pragma once
+
+#ifndef TESTTOOLS_PROCESSTABLE_H
+#define TESTTOOLS_PROCESSTABLE_H
+
+#include "abstractobserver.h"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace testtools
+{
+
+/// Индекс "имя процесса - идентификаторы процессов", общий для всех наблюдателей.
+///
+/// Если ядро позволяет подписаться на события proc connector (требуется CAP_NET_ADMIN),
+/// индекс поддерживается в актуальном состоянии фоновым потоком по событиям fork, exec,
+/// comm и exit. Иначе индекс перестраивается полным обходом /proc, но не чаще одного
+/// раза за период @e kRescanInterval, сколько бы наблюдателей к нему ни обращалось.
+class ProcessTable final
+{
+public:
+    /// Период перестроения индекса в режиме без событий ядра (в миллисекундах)
+    static const int kRescanInterval = 1000;
+
+public:
+    /// Возвращает общий экземпляр таблицы текущего корневого каталога procfs,
+    /// создавая его при первом обращении.
+    /// Таблица уничтожается вместе с последним использующим ее наблюдателем.
+    /// @throw AbstractObserver#SystemError
+    /// @return Умный указатель на таблицу
+    static std::shared_ptr<ProcessTable> Get();
+
+    ~ProcessTable();
+
+    /// Возвращает идентификаторы процессов с указанным именем, если они изменились
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] name Имя процесса (сравниваются первые 15 символов, как хранит ядро)
+    /// @param[in,out] generation Поколение записи, полученное при предыдущем вызове
+    /// @param[out] pids Идентификаторы процессов (заполняются, только если поколение изменилось)
+    /// @return @b true, если список процессов изменился с момента предыдущего вызова
+    bool Find(const std::string& name, uint64_t& generation, std::vector<uint32_t>& pids);
+
+    /// Проверяет, поддерживается ли индекс по событиям ядра
+    /// @return @b true - по событиям, @b false - периодическим обходом /proc
+    inline bool IsEventDriven() const noexcept { return -1 != socket_; }
+
+private:
+    /// Запись индекса для одного имени процесса
+    struct Entry
+    {
+        std::vector<uint32_t> pids;     ///< Идентификаторы процессов
+        uint64_t generation;            ///< Поколение последнего изменения
+    };
+
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] root Корневой каталог procfs (см. procfs::GetRoot)
+    explicit ProcessTable(const char* root);
+
+    /// Подписывается на события proc connector
+    /// @return @b true в случае успеха, иначе - @b false
+    bool Subscribe();
+    /// Перестраивает индекс полным обходом /proc (вызывается под блокировкой)
+    /// @throw AbstractObserver#SystemError
+    void Rescan();
+    /// Обрабатывает события ядра до остановки таблицы
+    void Listen();
+
+    /// Добавляет процесс в индекс или изменяет его имя (вызывается под блокировкой)
+    /// @param[in] pid Идентификатор процесса
+    /// @param[in] name Имя процесса
+    void Insert(uint32_t pid, const std::string& name);
+    /// Удаляет процесс из индекса (вызывается под блокировкой)
+    /// @param[in] pid Идентификатор процесса
+    void Erase(uint32_t pid);
+
+private:
+    /// Каталог /proc
+    procfs::Directory proc_;
+    /// Сокет proc connector или @b -1, если подписка на события недоступна
+    int socket_;
+    /// Дескриптор eventfd для остановки потока обработки событий
+    int wakeup_;
+    /// Поток обработки событий
+    std::thread listener_;
+
+    /// Блокировка индекса
+    std::mutex mutex_;
+    /// Имена процессов по их идентификаторам
+    std::unordered_map<uint32_t, std::string> names_;
+    /// Идентификаторы процессов по их именам
+    std::unordered_map<std::string, Entry> index_;
+    /// Счетчик поколений индекса
+    uint64_t generation_;
+    /// Время последнего перестроения индекса в миллисекундах
+    double rescanTime_;
+}; // class ProcessTable
+
+} // namespace testtools
+
+#endif // TESTTOOLS_PROCESSTABLE_H
@@ -0,0 +1,291 @@
+/// @file
+/// Реализация таблицы процессов, поддерживаемой по событиям ядра.
+
+#include "processtable.h"
+
+#include <algorithm>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+namespace testtools
+{
+
+using std::string;
+using std::vector;
+
+/// Функции-помощники ProcessTable
+namespace
+{
+
+/// Максимальная длина имени процесса, которое хранит ядро (без завершающего нуля)
+const size_t kCommLength = 15;
+/// Размер буфера приема сокета proc connector
+const int kReceiveBufferSize = 1024 * 1024;
+
+/// Возвращает ключ индекса для имени процесса
+/// @param[in] name Имя процесса
+/// @return Первые 15 символов имени
+string GetKey(const char* name)
+{
+    return string(name, ::strnlen(name, kCommLength));
+}
+
+} // namespace
+
+std::shared_ptr<ProcessTable> ProcessTable::Get()
+{
+    static std::mutex mutex;
+    // Экземпляры по корневому каталогу procfs: наблюдатели, созданные после смены
+    // корневого каталога (см. procfs::SetRoot), получают таблицу нового каталога
+    static std::unordered_map<string, std::weak_ptr<ProcessTable>> instances;
+
+    const char* root = procfs::GetRoot();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<ProcessTable>& instance = instances[root];
+    std::shared_ptr<ProcessTable> table = instance.lock();
+    if (!table) {
+        table.reset(new ProcessTable(root));
+        instance = table;
+    }
+
+    return table;
+}
+
+ProcessTable::ProcessTable(const char* root)
+    : proc_(root)
+    , socket_(-1)
+    , wakeup_(-1)
+    , generation_(0)
+    , rescanTime_(0.)
+{
+    // Подписываемся до первого обхода /proc: события, произошедшие во время обхода,
+    // накопятся в буфере сокета и будут применены после него.
+    // События ядра относятся к процессам системы, поэтому для синтетического дерева
+    // процессов индекс перестраивается только обходом каталога.
+    if (procfs::kRoot == root && Subscribe()) {
+        wakeup_ = ::eventfd(0, EFD_CLOEXEC);
+        if (-1 == wakeup_) {
+            ::close(socket_);
+            socket_ = -1;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Rescan();
+
+    if (IsEventDriven())
+        listener_ = std::thread(&ProcessTable::Listen, this);
+}
+
+ProcessTable::~ProcessTable()
+{
+    if (listener_.joinable()) {
+        const uint64_t value = 1;
+        ::write(wakeup_, &value, sizeof(value));
+        listener_.join();
+    }
+
+    if (-1 != socket_) ::close(socket_);
+    if (-1 != wakeup_) ::close(wakeup_);
+}
+
+bool ProcessTable::Find(const string& name, uint64_t& generation, vector<uint32_t>& pids)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsEventDriven() && kRescanInterval <= procfs::GetMonotonicTime() - rescanTime_)
+        Rescan();
+
+    const auto entry = index_.find(GetKey(name.data()));
+    const uint64_t current = index_.end() == entry ? 0 : entry->second.generation;
+    if (current == generation) return false;
+
+    generation = current;
+    if (index_.end() == entry) pids.clear();
+    else pids = entry->second.pids;
+
+    return true;
+}
+
+bool ProcessTable::Subscribe()
+{
+    const int fd = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (-1 == fd) return false;
+
+    // Привязка к группе CN_IDX_PROC требует CAP_NET_ADMIN
+    struct sockaddr_nl address = { 0 };
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0;
+    if (-1 == ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address))) {
+        ::close(fd);
+        return false;
+    }
+
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferSize, sizeof(kReceiveBufferSize));
+
+    alignas(struct nlmsghdr) char buffer[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))] = { 0 };
+    struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(buffer);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+
+    struct cn_msg* message = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(enum proc_cn_mcast_op);
+
+    const enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(message->data, &op, sizeof(op));
+
+    if (-1 == ::send(fd, buffer, header->nlmsg_len, 0)) {
+        ::close(fd);
+        return false;
+    }
+
+    socket_ = fd;
+    return true;
+}
+
+void ProcessTable::Rescan()
+{
+    vector<std::pair<uint32_t, string>> processes = {};
+    processes.reserve(names_.size() + 64);
+
+    const int proc = proc_.Get();
+    const bool listed = proc_.ForEachId([proc, &processes](uint32_t pid) {
+        procfs::ProcessStat stat = { 0 };
+        if (procfs::ReadProcessStat(proc, pid, stat))
+            processes.emplace_back(pid, GetKey(stat.name));
+    });
+    if (!listed) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    // Применяем отличия от текущего индекса, чтобы поколения изменились
+    // только у тех имен, список процессов которых действительно изменился.
+    std::sort(processes.begin(), processes.end());
+    vector<uint32_t> gone = {};
+    for (const auto& item : names_) {
+        const auto it = std::lower_bound(processes.begin(), processes.end(), std::make_pair(item.first, string()));
+        if (processes.end() == it || it->first != item.first) gone.push_back(item.first);
+    }
+
+    for (const auto pid : gone)
+        Erase(pid);
+    for (const auto& process : processes)
+        Insert(process.first, process.second);
+
+    rescanTime_ = procfs::GetMonotonicTime();
+}
+
+void ProcessTable::Listen()
+{
+    struct pollfd fds[2] = { { socket_, POLLIN, 0 }, { wakeup_, POLLIN, 0 } };
+    alignas(struct nlmsghdr) char buffer[32768];
+
+    for (;;) {
+        if (-1 == ::poll(fds, 2, -1)) {
+            if (EINTR == errno) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        ssize_t length = ::recv(socket_, buffer, sizeof(buffer), 0);
+        if (-1 == length) {
+            // Переполнение буфера сокета: часть событий потеряна, перестраиваем индекс целиком
+            if (ENOBUFS == errno) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                try { Rescan(); } catch (const AbstractObserver::Exception&) {}
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(buffer);
+            NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+            if (NLMSG_ERROR == header->nlmsg_type || NLMSG_NOOP == header->nlmsg_type) continue;
+
+            const struct cn_msg* message = reinterpret_cast<const struct cn_msg*>(NLMSG_DATA(header));
+            if (CN_IDX_PROC != message->id.idx || CN_VAL_PROC != message->id.val) continue;
+
+            // События потоков (pid != tgid) на состав процессов не влияют и пропускаются
+            const struct proc_event* event = reinterpret_cast<const struct proc_event*>(message->data);
+            switch (event->what) {
+                case proc_event::PROC_EVENT_FORK: {
+                    const auto& fork = event->event_data.fork;
+                    if (fork.child_pid != fork.child_tgid) break;
+
+                    // Дочерний процесс до вызова exec носит имя родителя
+                    const auto parent = names_.find(static_cast<uint32_t>(fork.parent_tgid));
+                    if (names_.end() != parent) {
+                        Insert(static_cast<uint32_t>(fork.child_tgid), string(parent->second));
+                        break;
+                    }
+
+                    procfs::ProcessStat stat = { 0 };
+                    if (procfs::ReadProcessStat(proc_.Get(), static_cast<uint32_t>(fork.child_tgid), stat))
+                        Insert(static_cast<uint32_t>(fork.child_tgid), GetKey(stat.name));
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXEC: {
+                    const auto& exec = event->event_data.exec;
+                    if (exec.process_pid != exec.process_tgid) break;
+
+                    procfs::ProcessStat stat = { 0 };
+                    if (procfs::ReadProcessStat(proc_.Get(), static_cast<uint32_t>(exec.process_tgid), stat))
+                        Insert(static_cast<uint32_t>(exec.process_tgid), GetKey(stat.name));
+                    break;
+                }
+                case proc_event::PROC_EVENT_COMM: {
+                    const auto& comm = event->event_data.comm;
+                    if (comm.process_pid == comm.process_tgid)
+                        Insert(static_cast<uint32_t>(comm.process_tgid), GetKey(comm.comm));
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXIT: {
+                    const auto& exit = event->event_data.exit;
+                    if (exit.process_pid == exit.process_tgid)
+                        Erase(static_cast<uint32_t>(exit.process_tgid));
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void ProcessTable::Insert(uint32_t pid, const string& name)
+{
+    auto item = names_.find(pid);
+    if (names_.end() != item) {
+        if (item->second == name) return;
+        Erase(pid);
+    }
+
+    names_.emplace(pid, name);
+    Entry& entry = index_[name];
+    entry.pids.push_back(pid);
+    entry.generation = ++generation_;
+}
+
+void ProcessTable::Erase(uint32_t pid)
+{
+    const auto item = names_.find(pid);
+    if (names_.end() == item) return;
+
+    // Пустые записи удаляются: при повторном появлении имени запись получит новое поколение
+    const auto entry = index_.find(item->second);
+    if (index_.end() != entry) {
+        auto& pids = entry->second.pids;
+        pids.erase(std::remove(pids.begin(), pids.end(), pid), pids.end());
+        if (pids.empty()) index_.erase(entry);
+        else entry->second.generation = ++generation_;
+    }
+
+    names_.erase(item);
+}
+
+} // namespace testtools
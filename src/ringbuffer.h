@@ -0,0 +1,101 @@
+/// @file
+/// Объявление кольцевого буфера для обмена данными между двумя потоками.
+
+#pragma once
+
+#ifndef TESTTOOLS_RINGBUFFER_H
+#define TESTTOOLS_RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace testtools
+{
+
+/// Кольцевой буфер без блокировок для одного потока-производителя и одного потока-потребителя.
+/// Производитель изменяет только позицию записи, потребитель - только позицию чтения, поэтому
+/// для синхронизации достаточно пары атомарных переменных с семантикой acquire/release.
+/// При переполнении новые элементы отбрасываются (уже записанные не перезаписываются,
+/// иначе производителю пришлось бы изменять позицию чтения).
+template <typename T>
+class RingBuffer final
+{
+public:
+    /// @param[in] capacity Вместимость буфера (округляется вверх до степени двойки)
+    explicit RingBuffer(size_t capacity)
+        : items_(RoundUp(capacity))
+        , mask_(items_.size() - 1)
+        , head_(0)
+        , tail_(0)
+        , dropped_(0) {}
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+    ~RingBuffer() = default;
+
+    /// Добавляет элемент в буфер (вызывается только потоком-производителем)
+    /// @param[in] item Элемент
+    /// @return @b true в случае успеха, @b false - если буфер заполнен и элемент отброшен
+    bool Push(const T& item) noexcept
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Извлекает все элементы из буфера (вызывается только потоком-потребителем)
+    /// @param[out] items Массив, в конец которого добавляются элементы
+    /// @return Количество извлеченных элементов
+    size_t PopAll(std::vector<T>& items)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        items.reserve(items.size() + (tail - head));
+        for (size_t i = head; i != tail; ++i)
+            items.push_back(items_[i & mask_]);
+
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    /// Возвращает вместимость буфера
+    inline size_t GetCapacity() const noexcept { return items_.size(); }
+    /// Возвращает количество элементов, отброшенных из-за переполнения
+    inline uint64_t GetDropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    /// Округляет число вверх до степени двойки
+    /// @param[in] value Число
+    /// @return Ближайшая степень двойки, не меньшая числа (но не меньше 2)
+    static size_t RoundUp(size_t value) noexcept
+    {
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+private:
+    /// Элементы буфера
+    std::vector<T> items_;
+    /// Маска для вычисления индекса элемента по позиции
+    const size_t mask_;
+    /// Позиция чтения (изменяется потребителем)
+    std::atomic<size_t> head_;
+    /// Отделяет позиции чтения и записи, чтобы они не попадали в одну строку кэша
+    char padding_[64];
+    /// Позиция записи (изменяется производителем)
+    std::atomic<size_t> tail_;
+    /// Количество отброшенных элементов
+    std::atomic<uint64_t> dropped_;
+}; // class RingBuffer
+
+} // namespace testtools
+
+#endif // TESTTOOLS_RINGBUFFER_H
@@ -0,0 +1,142 @@
+/// @file
+/// Реализация файла результатов опроса, отображаемого в память (общая часть).
+
+#include "samplefile.h"
+
+#include <cstring>
+#include <limits>
+
+namespace testtools
+{
+
+/// Функции-помощники SampleFile
+namespace
+{
+
+/// Сигнатура файла
+const char kMagic[8] = { 'T', 'T', 'S', 'A', 'M', 'P', 'L', 'E' };
+
+/// Возвращает количество установленных бит маски
+inline size_t CountBits(AbstractObserver::Mask mask) noexcept
+{
+    size_t count = 0;
+    for (; 0 != mask; mask &= mask - 1) ++count;
+    return count;
+}
+
+/// Проверяет, относятся ли результаты опроса наблюдателя к отдельным процессам
+inline bool HasPid(uint32_t type) noexcept
+{
+    return AbstractObserver::ProcessId == type || AbstractObserver::ProcessName == type;
+}
+
+} // namespace
+
+static_assert(sizeof(SampleFile::Header) == SampleFile::kHeaderSize, "Invalid sample file header size");
+
+SampleFile::SampleFile(const std::string& path, uint8_t type, AbstractObserver::Mask mask, size_t capacity)
+    : path_(path)
+    , data_(nullptr)
+    , size_(0)
+    , header_(nullptr)
+    , records_(nullptr)
+    , process_(HasPid(type))
+#if defined(TESTTOOLS_WIN)
+    , file_(INVALID_HANDLE_VALUE)
+    , mapping_(nullptr)
+#elif defined(TESTTOOLS_LINUX)
+    , fd_(-1)
+#endif
+{
+    const size_t stride = kColumns + CountBits(mask);
+    if (0 == capacity || (std::numeric_limits<size_t>::max() - kHeaderSize) / (stride * sizeof(double)) < capacity)
+        throw AbstractObserver::Exception("Invalid sample file capacity.");
+
+    const bool existing = Map(path, kHeaderSize + capacity * stride * sizeof(double));
+    header_ = reinterpret_cast<Header*>(data_);
+    records_ = reinterpret_cast<double*>(data_ + kHeaderSize);
+
+    if (existing && 0 == std::memcmp(header_->magic, kMagic, sizeof(kMagic)) && kVersion == header_->version
+        && type == header_->type && mask == header_->mask && stride == header_->stride && capacity == header_->capacity)
+        return;
+
+    // Сигнатура стирается первой и записывается последней, поэтому файл, запись заголовка
+    // которого была прервана, при следующем открытии будет инициализирован заново
+    std::memset(header_->magic, 0, sizeof(header_->magic));
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->version = kVersion;
+    header_->type = type;
+    header_->mask = mask;
+    header_->stride = static_cast<uint32_t>(stride);
+    header_->capacity = capacity;
+    header_->count.store(0, std::memory_order_relaxed);
+    std::memset(header_->reserved, 0, sizeof(header_->reserved));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+}
+
+SampleFile::SampleFile(const std::string& path)
+    : path_(path)
+    , data_(nullptr)
+    , size_(0)
+    , header_(nullptr)
+    , records_(nullptr)
+    , process_(false)
+#if defined(TESTTOOLS_WIN)
+    , file_(INVALID_HANDLE_VALUE)
+    , mapping_(nullptr)
+#elif defined(TESTTOOLS_LINUX)
+    , fd_(-1)
+#endif
+{
+    Map(path, 0);
+    header_ = reinterpret_cast<Header*>(data_);
+    records_ = reinterpret_cast<double*>(data_ + kHeaderSize);
+
+    const bool valid = kHeaderSize <= size_ && 0 == std::memcmp(header_->magic, kMagic, sizeof(kMagic))
+        && kVersion == header_->version && kColumns <= header_->stride && 0 != header_->capacity
+        && (size_ - kHeaderSize) / (header_->stride * sizeof(double)) >= header_->capacity;
+    if (!valid) {
+        Unmap();
+        throw AbstractObserver::Exception("Invalid sample file: " + path);
+    }
+
+    process_ = HasPid(header_->type);
+}
+
+SampleFile::~SampleFile()
+{
+    Unmap();
+}
+
+void SampleFile::Write(const AbstractObserver::Sample& sample) noexcept
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const uint64_t count = header_->count.load(std::memory_order_relaxed);
+    double* row = records_ + (count % header_->capacity) * header_->stride;
+
+    row[0] = sample.timestamp;
+    row[1] = process_ ? static_cast<double>(sample.pid) : nan;
+    row[2] = sample.triggered ? 1. : 0.;
+    double* value = row + kColumns;
+    for (AbstractObserver::Mask bits = header_->mask; 0 != bits; bits &= bits - 1, ++value) {
+        const AbstractObserver::Mask counter = bits & (~bits + 1);
+        *value = sample.Has(counter) ? sample.values[AbstractObserver::Sample::IndexOf(counter)] : nan;
+    }
+
+    // Счетчик записей изменяется после записи строки: если процесс завершится посередине,
+    // незавершенная строка не будет считаться записанной
+    header_->count.store(count + 1, std::memory_order_release);
+}
+
+void SampleFile::GetRange(uint64_t& first, uint64_t& count) const noexcept
+{
+    // Строка, следующая за последней записью, может быть записана не полностью (ее перезаписывает
+    // производитель или запись прервалась аварийным завершением), поэтому она не возвращается
+    const uint64_t total = header_->count.load(std::memory_order_acquire);
+    const uint64_t capacity = header_->capacity;
+    count = total < capacity ? total : capacity - 1;
+    first = (total - count) % capacity;
+}
+
+} // namespace testtools
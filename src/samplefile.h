@@ -0,0 +1,125 @@
+/// @file
+/// Объявление файла результатов опроса, отображаемого в память.
+
+#pragma once
+
+#ifndef TESTTOOLS_SAMPLEFILE_H
+#define TESTTOOLS_SAMPLEFILE_H
+
+#include "abstractobserver.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace testtools
+{
+
+/// Кольцевой файл результатов опроса фиксированного размера, отображаемый в память.
+/// Запись результата - обычные операции записи в память (без системных вызовов), данные
+/// в файл сбрасывает ядро, поэтому они сохраняются и при аварийном завершении процесса.
+/// При повторном открытии файла с теми же параметрами запись продолжается с прежнего места.
+///
+/// Файл состоит из заголовка (@e Header) и @e capacity записей по @e stride ячеек double:
+/// время опроса, идентификатор процесса (NaN для наблюдателей за системой и группой процессов),
+/// признак внеочередного опроса (0 или 1) и значения счетчиков маски в порядке номеров бит
+/// (NaN - значения нет). Запись с номером @e n (от начала ведения файла) хранится в строке
+/// @e n % capacity. Числа хранятся в порядке байт процессора.
+class SampleFile final
+{
+public:
+    /// Версия формата файла
+    static const uint32_t kVersion = 1;
+    /// Размер заголовка в байтах (записи начинаются с выровненного адреса)
+    static const size_t kHeaderSize = 64;
+    /// Количество служебных ячеек записи (время, идентификатор процесса, признак внеочередного опроса)
+    static const size_t kColumns = 3;
+
+    /// Заголовок файла
+    struct Header
+    {
+        char magic[8];                  ///< Сигнатура "TTSAMPLE" (записывается последней)
+        uint32_t version;               ///< Версия формата
+        uint32_t type;                  ///< Тип наблюдателя
+        uint32_t mask;                  ///< Маска счетчиков
+        uint32_t stride;                ///< Количество ячеек записи
+        uint64_t capacity;              ///< Количество записей
+        std::atomic<uint64_t> count;    ///< Количество записей, добавленных с начала ведения файла
+        uint8_t reserved[24];           ///< Резерв
+    };
+
+public:
+    /// Открывает файл для записи, создавая его или увеличивая размер при необходимости.
+    /// Если параметры существующего файла отличаются от заданных, его записи удаляются.
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] path Путь к файлу
+    /// @param[in] type Тип наблюдателя
+    /// @param[in] mask Маска счетчиков
+    /// @param[in] capacity Количество записей
+    SampleFile(const std::string& path, uint8_t type, AbstractObserver::Mask mask, size_t capacity);
+    /// Открывает существующий файл для чтения. Изменения отображения не попадают в файл,
+    /// но записи, добавляемые другим процессом, видны.
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] path Путь к файлу
+    explicit SampleFile(const std::string& path);
+    SampleFile(const SampleFile&) = delete;
+    SampleFile& operator=(const SampleFile&) = delete;
+    ~SampleFile();
+
+    /// Добавляет результат опроса (вызывается только одним потоком)
+    /// @param[in] sample Результат опроса
+    void Write(const AbstractObserver::Sample& sample) noexcept;
+
+    /// Возвращает путь к файлу
+    inline const std::string& GetPath() const noexcept { return path_; }
+    /// Возвращает заголовок файла
+    inline const Header& GetHeader() const noexcept { return *header_; }
+    /// Возвращает адрес отображения файла (заголовок и записи)
+    inline uint8_t* GetData() const noexcept { return data_; }
+    /// Возвращает размер отображения файла в байтах
+    inline size_t GetSize() const noexcept { return size_; }
+
+    /// Возвращает диапазон записей, доступных для чтения
+    /// @param[out] first Номер строки самой старой записи
+    /// @param[out] count Количество записей
+    void GetRange(uint64_t& first, uint64_t& count) const noexcept;
+
+private:
+    /// Открывает файл и отображает его в память
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception
+    /// @param[in] path Путь к файлу
+    /// @param[in] size Размер файла (@b 0 - открыть существующий файл для чтения)
+    /// @return @b true, если файл уже существовал и имел не меньший размер
+    bool Map(const std::string& path, size_t size);
+    /// Освобождает отображение и закрывает файл
+    void Unmap() noexcept;
+
+private:
+    /// Путь к файлу
+    std::string path_;
+    /// Отображение файла
+    uint8_t* data_;
+    /// Размер отображения в байтах
+    size_t size_;
+    /// Заголовок
+    Header* header_;
+    /// Записи
+    double* records_;
+    /// Ячейки записей результата опроса включают идентификатор процесса
+    bool process_;
+
+#if defined(TESTTOOLS_WIN)
+    /// Дескриптор файла
+    HANDLE file_;
+    /// Дескриптор объекта отображения файла
+    HANDLE mapping_;
+#elif defined(TESTTOOLS_LINUX)
+    /// Дескриптор файла
+    int fd_;
+#endif
+}; // class SampleFile
+
+} // namespace testtools
+
+#endif // TESTTOOLS_SAMPLEFILE_H
@@ -0,0 +1,72 @@
+/// @file
+/// Реализация отображения файла результатов опроса в память для Linux.
+
+#include "samplefile.h"
+
+#include <fcntl.h> // open
+#include <unistd.h> // close, ftruncate
+#include <sys/file.h> // flock
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+
+namespace testtools
+{
+
+bool SampleFile::Map(const std::string& path, size_t size)
+{
+    const bool writable = 0 != size;
+    fd_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+    if (-1 == fd_) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+    try {
+        // Вести файл может только один процесс, иначе записи перемешаются
+        if (writable && -1 == ::flock(fd_, LOCK_EX | LOCK_NB)) {
+            if (EWOULDBLOCK == errno) throw AbstractObserver::Exception("Sample file is used by another process: " + path);
+            throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+        }
+
+        struct stat info = {};
+        if (-1 == ::fstat(fd_, &info)) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+        // Файл только увеличивается: при уменьшении обращение к отображениям за новым концом
+        // файла в других процессах завершило бы их сигналом SIGBUS
+        const bool existing = static_cast<size_t>(info.st_size) >= size;
+        if (!writable) {
+            size = static_cast<size_t>(info.st_size);
+            if (kHeaderSize > size) throw AbstractObserver::Exception("Invalid sample file: " + path);
+        }
+        else if (!existing) {
+            if (-1 == ::ftruncate(fd_, static_cast<off_t>(size)))
+                throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+            // Место на диске выделяется заранее: при его нехватке запись в отображение
+            // завершила бы процесс сигналом SIGBUS
+            const int error = ::posix_fallocate(fd_, 0, static_cast<off_t>(size));
+            if (0 != error) throw AbstractObserver::SystemError(static_cast<errno_t>(error));
+        }
+
+        // Отображение для чтения закрытое: изменения не попадают в файл, но изменения файла
+        // другим процессом видны до первой записи в страницу
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd_, 0);
+        if (MAP_FAILED == data) throw AbstractObserver::SystemError(static_cast<errno_t>(errno));
+
+        data_ = static_cast<uint8_t*>(data);
+        size_ = size;
+        return existing;
+    }
+    catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+}
+
+void SampleFile::Unmap() noexcept
+{
+    if (nullptr != data_) ::munmap(data_, size_);
+    if (-1 != fd_) ::close(fd_);
+    data_ = nullptr;
+    size_ = 0;
+    fd_ = -1;
+}
+
+} // namespace testtools
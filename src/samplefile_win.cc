@@ -0,0 +1,72 @@
+/// @file
+/// Реализация отображения файла результатов опроса в память для Windows.
+
+#include "samplefile.h"
+
+namespace testtools
+{
+
+bool SampleFile::Map(const std::string& path, size_t size)
+{
+    const bool writable = 0 != size;
+    // Вести файл может только один процесс, иначе записи перемешаются
+    file_ = ::CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        writable ? FILE_SHARE_READ : FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file_) {
+        if (ERROR_SHARING_VIOLATION == ::GetLastError())
+            throw AbstractObserver::Exception("Sample file is used by another process: " + path);
+        throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+    }
+
+    try {
+        LARGE_INTEGER current = {};
+        if (!::GetFileSizeEx(file_, &current)) throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+
+        // Файл только увеличивается, чтобы не нарушать отображения в других процессах
+        const bool existing = static_cast<size_t>(current.QuadPart) >= size;
+        if (!writable) {
+            size = static_cast<size_t>(current.QuadPart);
+            if (kHeaderSize > size) throw AbstractObserver::Exception("Invalid sample file: " + path);
+        }
+        else if (!existing) {
+            LARGE_INTEGER end = {};
+            end.QuadPart = static_cast<LONGLONG>(size);
+            if (!::SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) || !::SetEndOfFile(file_))
+                throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+        }
+
+        // Отображение для чтения с копированием при записи: изменения не попадают в файл
+        const uint64_t size64 = size;
+        mapping_ = ::CreateFileMappingA(file_, nullptr, writable ? PAGE_READWRITE : PAGE_WRITECOPY,
+            static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), nullptr);
+        if (nullptr == mapping_) throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+
+        void* data = ::MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, size);
+        if (nullptr == data) throw AbstractObserver::SystemError(static_cast<errno_t>(::GetLastError()));
+
+        data_ = static_cast<uint8_t*>(data);
+        size_ = size;
+        return existing;
+    }
+    catch (...) {
+        if (nullptr != mapping_) ::CloseHandle(mapping_);
+        ::CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+        throw;
+    }
+}
+
+void SampleFile::Unmap() noexcept
+{
+    if (nullptr != data_) ::UnmapViewOfFile(data_);
+    if (nullptr != mapping_) ::CloseHandle(mapping_);
+    if (INVALID_HANDLE_VALUE != file_) ::CloseHandle(file_);
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+} // namespace testtools
@@ -0,0 +1,119 @@
+/// @file
+/// Реализация фонового опроса счетчиков наблюдателя.
+
+#include "sampler.h"
+
+namespace testtools
+{
+
+using std::chrono::steady_clock;
+
+Sampler::Sampler(AbstractObserver* observer, AbstractObserver::Mask mask, double interval, size_t capacity,
+    std::unique_ptr<PressureTrigger> trigger, std::shared_ptr<SampleFile> file,
+    std::shared_ptr<LivePublisher> publisher)
+    : observer_(observer)
+    , mask_(mask)
+    , interval_(std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double, std::milli>(interval)))
+    , buffer_(capacity)
+    , trigger_(std::move(trigger))
+    , file_(std::move(file))
+    , publisher_(std::move(publisher))
+    , latest_()
+    , stopped_(false)
+    , error_()
+    , thread_()
+{
+    latest_.type = observer->GetType();
+    latest_.mask = mask;
+    latest_.slots = live::kSlots;
+    latest_.interval = interval;
+    thread_ = std::thread(&Sampler::Run, this);
+}
+
+Sampler::~Sampler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+
+    wakeup_.notify_one();
+    if (trigger_) trigger_->Wake();
+    if (thread_.joinable()) thread_.join();
+}
+
+size_t Sampler::Drain(std::vector<AbstractObserver::Sample>& samples)
+{
+    const size_t count = buffer_.PopAll(samples);
+    if (0 != count) return count;
+
+    // Ошибку сообщаем только после того, как забраны все результаты, полученные до нее
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_.empty()) throw AbstractObserver::Exception(error_);
+
+    return 0;
+}
+
+bool Sampler::GetLatest(live::Snapshot& snapshot) const
+{
+    if (0 == latest_.sequence.load(std::memory_order_acquire)) return false;
+
+    live::ReadSnapshot(latest_, latestSlots_.data(), snapshot);
+    return true;
+}
+
+void Sampler::Run()
+{
+    // Массив результатов одного опроса переиспользуется, чтобы не выделять память на каждом шаге
+    std::vector<AbstractObserver::Sample> samples = {};
+    steady_clock::time_point next = steady_clock::now();
+    bool triggered = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+        lock.unlock();
+        try {
+            samples.clear();
+            observer_->Collect(mask_, samples);
+            for (auto& sample : samples) {
+                sample.triggered = triggered;
+                buffer_.Push(sample);
+                if (file_) file_->Write(sample);
+            }
+            LivePublisher::Store(latest_, latestSlots_.data(), samples);
+            if (publisher_) publisher_->Publish(samples);
+        }
+        catch (const AbstractObserver::Exception& error) {
+            lock.lock();
+            error_ = error.what();
+            break;
+        }
+
+        // Если опрос занял больше интервала, пропущенные моменты не наверстываются,
+        // а следующий опрос выполняется в ближайший момент исходного расписания.
+        // Внеочередной опрос по триггеру расписание не сдвигает.
+        if (!triggered) {
+            next += interval_;
+            const steady_clock::time_point now = steady_clock::now();
+            if (next < now) next += ((now - next) / interval_ + 1) * interval_;
+        }
+
+        if (trigger_) {
+            try {
+                triggered = trigger_->Wait(next);
+            }
+            catch (const AbstractObserver::Exception& error) {
+                lock.lock();
+                error_ = error.what();
+                break;
+            }
+            lock.lock();
+        }
+        else {
+            lock.lock();
+            wakeup_.wait_until(lock, next, [this]() { return stopped_; });
+        }
+    }
+}
+
+} // namespace testtools
@@ -0,0 +1,111 @@
+/// @file
+/// Объявление фонового опроса счетчиков наблюдателя.
+
+#pragma once
+
+#ifndef TESTTOOLS_SAMPLER_H
+#define TESTTOOLS_SAMPLER_H
+
+#include "abstractobserver.h"
+#include "livepublisher.h"
+#include "pressuretrigger.h"
+#include "ringbuffer.h"
+#include "samplefile.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace testtools
+{
+
+/// Фоновый опрос счетчиков наблюдателя.
+/// Отдельный поток опрашивает наблюдателя по расписанию от монотонных часов
+/// (моменты опроса не смещаются из-за длительности самого опроса) и складывает результаты
+/// в кольцевой буфер, из которого Node.JS забирает их пачкой. Таким образом точность
+/// расписания не зависит от загруженности цикла событий и пула потоков libuv.
+/// Если задан триггер PSI, поток между опросами ждет его срабатывания и при срабатывании
+/// выполняет внеочередной опрос, не сдвигая расписание.
+/// Если задан файл результатов опроса, они также записываются в него, а если задана
+/// публикация - результаты каждого опроса публикуются в разделяемой памяти (независимо
+/// от того, забирает ли их Node.JS). Результаты последнего опроса всегда доступны
+/// для синхронного чтения без блокировок (см. GetLatest).
+class Sampler final
+{
+public:
+    /// Запускает поток опроса
+    /// @param[in] observer Указатель на наблюдателя (должен существовать дольше объекта)
+    /// @param[in] mask Маска счетчиков
+    /// @param[in] interval Интервал опроса в миллисекундах
+    /// @param[in] capacity Вместимость буфера результатов опроса
+    /// @param[in] trigger Триггер внеочередного опроса или @b nullptr
+    /// @param[in] file Файл результатов опроса или @b nullptr
+    /// @param[in] publisher Публикация результатов опроса или @b nullptr
+    Sampler(AbstractObserver* observer, AbstractObserver::Mask mask, double interval, size_t capacity,
+        std::unique_ptr<PressureTrigger> trigger = nullptr, std::shared_ptr<SampleFile> file = nullptr,
+        std::shared_ptr<LivePublisher> publisher = nullptr);
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+    /// Останавливает поток опроса
+    ~Sampler();
+
+    /// Извлекает накопленные результаты опроса
+    /// @throw AbstractObserver#Exception, если опрос был прерван ошибкой и результатов больше нет
+    /// @param[out] samples Массив, в конец которого добавляются результаты опроса
+    /// @return Количество извлеченных результатов
+    size_t Drain(std::vector<AbstractObserver::Sample>& samples);
+
+    /// Копирует результаты последнего опроса. Не блокирует поток опроса: результаты хранятся
+    /// под защитой seqlock в том же формате, что и в разделяемой памяти (см. livesegment.h),
+    /// и копирование повторяется, если опрос изменил их во время него.
+    /// @param[out] snapshot Снимок результатов
+    /// @return @b false, если опрос еще не выполнялся
+    bool GetLatest(live::Snapshot& snapshot) const;
+
+    /// Возвращает количество результатов, отброшенных из-за переполнения буфера
+    inline uint64_t GetDropped() const noexcept { return buffer_.GetDropped(); }
+
+private:
+    /// Выполняет опрос по расписанию до остановки
+    void Run();
+
+private:
+    /// Указатель на наблюдателя
+    AbstractObserver* observer_;
+    /// Маска счетчиков
+    AbstractObserver::Mask mask_;
+    /// Интервал опроса
+    std::chrono::steady_clock::duration interval_;
+    /// Буфер результатов опроса
+    RingBuffer<AbstractObserver::Sample> buffer_;
+    /// Триггер внеочередного опроса (если задан)
+    std::unique_ptr<PressureTrigger> trigger_;
+    /// Файл результатов опроса (если задан)
+    std::shared_ptr<SampleFile> file_;
+    /// Публикация результатов опроса (если задана)
+    std::shared_ptr<LivePublisher> publisher_;
+    /// Заголовок результатов последнего опроса
+    live::Header latest_;
+    /// Результаты последнего опроса
+    std::array<live::Slot, live::kSlots> latestSlots_;
+
+    /// Блокировка флага остановки и текста ошибки
+    std::mutex mutex_;
+    /// Условие для пробуждения потока при остановке
+    std::condition_variable wakeup_;
+    /// Флаг остановки
+    bool stopped_;
+    /// Текст ошибки, прервавшей опрос
+    std::string error_;
+    /// Поток опроса
+    std::thread thread_;
+}; // class Sampler
+
+} // namespace testtools
+
+#endif // TESTTOOLS_SAMPLER_H
@@ -0,0 +1,173 @@
+/// @file
+/// Реализация статистики значений счетчиков в скользящих окнах.
+
+#include "summary.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace testtools
+{
+
+/// Функции-помощники Summary
+namespace
+{
+
+/// Процентили, возвращаемые в Summary::Result (в порядке полей p50 - p99)
+const double kPercentiles[] = { 50., 90., 95., 99. };
+
+/// Возвращает номер младшего установленного бита
+/// @param[in] bits Ненулевое значение
+/// @return Номер бита
+inline size_t CountTrailingZeros(uint32_t bits) noexcept
+{
+    size_t index = 0;
+    while (0 == (bits & 1)) { bits >>= 1; ++index; }
+    return index;
+}
+
+} // namespace
+
+void Summary::Configure(const std::vector<double>& windows)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    windows_.clear();
+    for (double window : windows)
+        if (0. < window) windows_.push_back(window);
+
+    for (auto& counter : counters_) counter.reset();
+    enabled_.store(!windows_.empty(), std::memory_order_relaxed);
+}
+
+void Summary::Add(uint32_t mask, const double* values)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (windows_.empty()) return;
+
+    const double time = GetTime();
+    for (uint32_t bits = mask; 0 != bits; bits &= bits - 1) {
+        const size_t index = CountTrailingZeros(bits);
+        AddValue(index, values[index], time);
+    }
+}
+
+bool Summary::Get(uint32_t counter, double window, Result& result) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (0 == counter) return false;
+
+    const size_t index = CountTrailingZeros(counter);
+    const auto found = std::find(windows_.begin(), windows_.end(), window);
+    if (windows_.end() == found || !counters_[index]) return false;
+
+    const size_t w = static_cast<size_t>(found - windows_.begin());
+    const Window& state = counters_[index][w];
+    const int64_t current = static_cast<int64_t>(GetTime() * kSlots / window);
+
+    // Гистограммы интервалов, попадающих в окно, объединяются только при запросе
+    std::array<uint32_t, kBuckets> buckets = {};
+    result = Result{ 0., std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0., 0. };
+    for (const Slot& slot : state.slots) {
+        if (slot.epoch > current || slot.epoch <= current - static_cast<int64_t>(kSlots) || 0. == slot.count)
+            continue;
+
+        result.count += slot.count;
+        result.mean += slot.sum;
+        result.min = std::min(result.min, slot.min);
+        result.max = std::max(result.max, slot.max);
+        for (size_t i = 0; i < kBuckets; ++i) buckets[i] += slot.buckets[i];
+    }
+
+    if (0. == result.count) return false;
+    result.mean /= result.count;
+    result.ewma = state.ewma;
+
+    double* percentiles[] = { &result.p50, &result.p90, &result.p95, &result.p99 };
+    double cumulative = 0.;
+    size_t bucket = 0;
+    for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); ++i) {
+        const double rank = std::max(1., std::ceil(kPercentiles[i] * result.count / 100.));
+        for (; bucket < kBuckets && cumulative + buckets[bucket] < rank; ++bucket) cumulative += buckets[bucket];
+
+        // Значение корзины приближенное, поэтому ограничиваем его точными минимумом и максимумом
+        const double value = GetBucketValue(std::min(bucket, kBuckets - 1));
+        *percentiles[i] = std::min(std::max(value, result.min), result.max);
+    }
+
+    return true;
+}
+
+double Summary::GetTime() noexcept
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count()) / 1000.;
+}
+
+size_t Summary::GetBucket(double value) noexcept
+{
+    if (!(value >= std::ldexp(1., kMinExponent))) return 0;
+
+    // value = mantissa * 2^exponent, mantissa в диапазоне [0.5, 1)
+    int exponent = 0;
+    const double mantissa = std::frexp(value, &exponent);
+    --exponent;
+    if (kMaxExponent <= exponent) return kBuckets - 1;
+
+    const size_t sub = static_cast<size_t>((mantissa * 2. - 1.) * (1 << kSubBucketBits));
+    return 1 + static_cast<size_t>(exponent - kMinExponent) * (1 << kSubBucketBits) + sub;
+}
+
+double Summary::GetBucketValue(size_t bucket) noexcept
+{
+    if (0 == bucket) return 0.;
+
+    const int exponent = static_cast<int>((bucket - 1) >> kSubBucketBits) + kMinExponent;
+    const double sub = static_cast<double>((bucket - 1) & ((1 << kSubBucketBits) - 1));
+    return std::ldexp(1. + (sub + 0.5) / (1 << kSubBucketBits), exponent);
+}
+
+void Summary::AddValue(size_t index, double value, double time)
+{
+    if (!std::isfinite(value)) return;
+
+    if (!counters_[index]) {
+        counters_[index].reset(new Window[windows_.size()]);
+        for (size_t w = 0; w < windows_.size(); ++w) {
+            for (Slot& slot : counters_[index][w].slots) slot.epoch = std::numeric_limits<int64_t>::min();
+            counters_[index][w].ewma = 0.;
+            counters_[index][w].ewmaTime = -1.;
+        }
+    }
+
+    const size_t bucket = GetBucket(value);
+    for (size_t w = 0; w < windows_.size(); ++w) {
+        Window& state = counters_[index][w];
+
+        // Интервал, вышедший за пределы окна, очищается при первой записи в него
+        const int64_t epoch = static_cast<int64_t>(time * kSlots / windows_[w]);
+        Slot& slot = state.slots[static_cast<size_t>(epoch % static_cast<int64_t>(kSlots))];
+        if (slot.epoch != epoch) {
+            slot.epoch = epoch;
+            slot.count = 0.;
+            slot.sum = 0.;
+            slot.min = value;
+            slot.max = value;
+            slot.buckets.fill(0);
+        }
+
+        slot.count += 1.;
+        slot.sum += value;
+        slot.min = std::min(slot.min, value);
+        slot.max = std::max(slot.max, value);
+        ++slot.buckets[bucket];
+
+        // Вес нового значения зависит от времени с предыдущего, поэтому EWMA не зависит от частоты опроса
+        if (0. > state.ewmaTime) state.ewma = value;
+        else state.ewma += (1. - std::exp((state.ewmaTime - time) / windows_[w])) * (value - state.ewma);
+        state.ewmaTime = time;
+    }
+}
+
+} // namespace testtools
@@ -0,0 +1,130 @@
+/// @file
+/// Объявление статистики значений счетчиков в скользящих окнах.
+
+#pragma once
+
+#ifndef TESTTOOLS_SUMMARY_H
+#define TESTTOOLS_SUMMARY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace testtools
+{
+
+/// Статистика значений счетчиков в скользящих окнах (например - 1 минута, 5 минут и 1 час):
+/// количество, минимум, максимум, среднее, экспоненциальное скользящее среднее (EWMA)
+/// и процентили по гистограмме с логарифмическими корзинами (как в HdrHistogram).
+///
+/// Каждое окно разбито на @e kSlots интервалов со своей гистограммой; интервал, вышедший
+/// за пределы окна, очищается и используется повторно. Поэтому объем памяти зависит только
+/// от количества окон и счетчиков, но не от длительности наблюдения, а окно сдвигается
+/// с шагом в 1/kSlots своей длины.
+class Summary final
+{
+public:
+    /// Максимальное количество счетчиков (разрядность маски)
+    static const size_t kMaxCounters = 32;
+    /// Количество интервалов окна
+    static const size_t kSlots = 12;
+    /// Количество бит дробной части значения, различаемых гистограммой
+    /// (16 корзин на каждую степень двойки - относительная погрешность не более 3%)
+    static const int kSubBucketBits = 4;
+    /// Показатель степени двойки наименьшего значения, отличаемого от нуля
+    static const int kMinExponent = -8;
+    /// Показатель степени двойки, начиная с которого значения попадают в последнюю корзину
+    static const int kMaxExponent = 48;
+    /// Количество корзин гистограммы (первая - для значений меньше 2^kMinExponent)
+    static const size_t kBuckets = 1 + (kMaxExponent - kMinExponent) * (1 << kSubBucketBits);
+
+    /// Статистика значений счетчика в окне
+    struct Result
+    {
+        double count;   ///< Количество значений
+        double min;     ///< Минимальное значение
+        double max;     ///< Максимальное значение
+        double mean;    ///< Среднее значение
+        double ewma;    ///< Экспоненциальное скользящее среднее с постоянной времени, равной окну
+        double p50;     ///< Медиана
+        double p90;     ///< 90-й процентиль
+        double p95;     ///< 95-й процентиль
+        double p99;     ///< 99-й процентиль
+    };
+
+public:
+    Summary() = default;
+    Summary(const Summary&) = delete;
+    Summary& operator=(const Summary&) = delete;
+    ~Summary() = default;
+
+    /// Задает окна статистики, сбрасывая накопленные значения
+    /// @param[in] windows Длительности окон в миллисекундах (пустой массив отключает статистику)
+    void Configure(const std::vector<double>& windows);
+
+    /// Проверяет, ведется ли статистика
+    inline bool IsEnabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /// Добавляет значения счетчиков одного опроса
+    /// @param[in] mask Маска счетчиков, значения которых присутствуют
+    /// @param[in] values Значения счетчиков по номеру бита в маске
+    void Add(uint32_t mask, const double* values);
+
+    /// Возвращает статистику значений счетчика в окне
+    /// @param[in] counter Счетчик (один бит маски)
+    /// @param[in] window Длительность окна в миллисекундах (одна из заданных в Configure)
+    /// @param[out] result Статистика
+    /// @return @b false, если окно не задано или в нем нет значений счетчика
+    bool Get(uint32_t counter, double window, Result& result) const;
+
+private:
+    /// Интервал окна
+    struct Slot
+    {
+        int64_t epoch;                                  ///< Номер интервала от начала отсчета времени
+        double count;                                   ///< Количество значений
+        double sum;                                     ///< Сумма значений
+        double min;                                     ///< Минимальное значение
+        double max;                                     ///< Максимальное значение
+        std::array<uint32_t, kBuckets> buckets;         ///< Гистограмма значений
+    };
+
+    /// Окно статистики одного счетчика
+    struct Window
+    {
+        std::array<Slot, kSlots> slots;     ///< Интервалы окна по номеру интервала по модулю kSlots
+        double ewma;                        ///< Экспоненциальное скользящее среднее
+        double ewmaTime;                    ///< Время последнего изменения EWMA (@b -1 - значений не было)
+    };
+
+    /// Возвращает текущее время монотонных часов в миллисекундах
+    static double GetTime() noexcept;
+    /// Возвращает номер корзины гистограммы для значения
+    static size_t GetBucket(double value) noexcept;
+    /// Возвращает значение, представляющее корзину гистограммы (середину ее диапазона)
+    static double GetBucketValue(size_t bucket) noexcept;
+
+    /// Добавляет значение счетчика во все окна (вызывается под блокировкой)
+    /// @param[in] index Номер бита счетчика в маске
+    /// @param[in] value Значение
+    /// @param[in] time Время опроса в миллисекундах
+    void AddValue(size_t index, double value, double time);
+
+private:
+    /// Блокировка статистики (значения добавляются из потока опроса, а читаются из потока Node.JS)
+    mutable std::mutex mutex_;
+    /// Статистика ведется (заданы окна)
+    std::atomic<bool> enabled_{ false };
+    /// Длительности окон в миллисекундах
+    std::vector<double> windows_;
+    /// Окна статистики по номеру бита счетчика (создаются при появлении первого значения счетчика)
+    std::array<std::unique_ptr<Window[]>, kMaxCounters> counters_;
+}; // class Summary
+
+} // namespace testtools
+
+#endif // TESTTOOLS_SUMMARY_H
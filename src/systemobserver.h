@@ -8,7 +8,13 @@
 
 #include "abstractobserver.h"
 
-#include <unordered_map>
+#if defined(TESTTOOLS_LINUX)
+#include "cgroup.h"
+#endif
+
+#include <memory>
+#include <regex>
+#include <vector>
 
 namespace testtools
 {
@@ -27,11 +33,61 @@ public:
         PhysicalMemoryUsageKBytes   = 16,   ///< Потребление физической памяти в килобайтах
         VirtualMemoryUsage          = 32,   ///< Процент потребления виртуальной памяти
         VirtualMemoryUsageKBytes    = 64,   ///< Потребление виртуальной памяти в килобайтах
-        DiskUsage                   = 128   ///< Процент загрузки жесткого диска
+        DiskUsage                   = 128,  ///< Процент загрузки жесткого диска
+        CpuPressure                 = 256,  ///< Процент времени, когда хотя бы одна задача ждала процессора (PSI, только Linux)
+        CpuPressureFull             = 512,  ///< Процент времени, когда все задачи ждали процессора (PSI, только Linux)
+        MemoryPressure              = 1024, ///< Процент времени, когда хотя бы одна задача ждала памяти (PSI, только Linux)
+        MemoryPressureFull          = 2048, ///< Процент времени, когда все задачи ждали памяти (PSI, только Linux)
+        IoPressure                  = 4096, ///< Процент времени, когда хотя бы одна задача ждала ввода-вывода (PSI, только Linux)
+        IoPressureFull              = 8192  ///< Процент времени, когда все задачи ждали ввода-вывода (PSI, только Linux)
+    };
+
+    /// Ресурсы, задержки из-за нехватки которых учитывает ядро (Pressure Stall Information)
+    enum PressureResource
+    {
+        PressureCpu = 0,            ///< Процессор
+        PressureMemory = 1,         ///< Память
+        PressureIo = 2,             ///< Ввод-вывод
+        PressureResourceCount = 3   ///< Количество ресурсов
+    };
+
+    /// Значения из файла /proc/pressure/<ресурс>
+    struct PressureStat
+    {
+        bool available;     ///< Файл доступен (ядро 4.20+ с включенным PSI)
+        double some[4];     ///< Хотя бы одна задача ждала: avg10, avg60, avg300 (в процентах) и total (в мкс)
+        double full[4];     ///< Все задачи ждали: avg10, avg60, avg300 (в процентах) и total (в мкс)
     };
 
     /// Результаты опроса счетчиков
-    typedef std::unordered_map<std::string, double> Result;
+    typedef Sample Result;
+
+    /// Показатели ввода-вывода дискового устройства за интервал между опросами
+    struct DiskSample
+    {
+        std::string name;       ///< Имя устройства (в Windows - имя экземпляра PhysicalDisk)
+        double reads;           ///< Операций чтения в секунду
+        double writes;          ///< Операций записи в секунду
+        double readKBytes;      ///< Прочитано килобайт в секунду
+        double writeKBytes;     ///< Записано килобайт в секунду
+        double readLatency;     ///< Среднее время операции чтения в миллисекундах
+        double writeLatency;    ///< Среднее время операции записи в миллисекундах
+        double usage;           ///< Процент времени, занятого вводом-выводом
+    };
+
+    /// Показатели сетевого интерфейса за интервал между опросами (в расчете на секунду)
+    struct NetworkSample
+    {
+        std::string name;       ///< Имя интерфейса
+        double receiveKBytes;   ///< Принято килобайт
+        double sendKBytes;      ///< Отправлено килобайт
+        double receivePackets;  ///< Принято пакетов
+        double sendPackets;     ///< Отправлено пакетов
+        double receiveDrops;    ///< Отброшено принятых пакетов
+        double sendDrops;       ///< Отброшено отправляемых пакетов
+        double receiveErrors;   ///< Ошибок приема
+        double sendErrors;      ///< Ошибок отправки
+    };
 
 public:
     /// Конструктор по умолчанию
@@ -42,9 +98,73 @@ public:
     /// Возвращает результат опроса счетчиков
     /// @throw SystemError
     /// @param[in] mask Маска счетчиков
-    /// @return Карта значений счетчиков в формате "счетчик=значение"
+    /// @return Значения счетчиков
     Result Poll(Mask mask) const;
 
+    /// Возвращает процент загрузки каждого логического процессора с момента предыдущего вызова
+    /// (при первом вызове - с момента создания наблюдателя)
+    /// @throw AbstractObserver#SystemError
+    /// @param[out] usage Загрузка по номерам процессоров (для отключенных процессоров - NaN)
+    void PollCores(std::vector<double>& usage);
+
+    /// Возвращает показатели ввода-вывода дисковых устройств с момента предыдущего вызова
+    /// (при первом вызове - с момента создания наблюдателя)
+    /// @throw AbstractObserver#SystemError, AbstractObserver#Exception (неверное регулярное выражение)
+    /// @param[in] pattern Регулярное выражение (ECMAScript) для имен устройств; пустая строка -
+    /// только физические диски
+    /// @param[in] ignoreCase Сравнивать имена без учета регистра
+    /// @param[out] disks Показатели устройств, имена которых соответствуют выражению
+    void PollDisks(const std::string& pattern, bool ignoreCase, std::vector<DiskSample>& disks);
+
+    /// Возвращает текущие значения PSI всех ресурсов (без вычислений между опросами)
+    /// @throw AbstractObserver#SystemError
+    /// @param[out] stats Значения по ресурсам (в порядке PressureResource)
+    void PollPressure(std::array<PressureStat, PressureResourceCount>& stats) const;
+
+    /// Возвращает показатели сетевых интерфейсов с момента предыдущего вызова
+    /// (при первом вызове - с момента создания наблюдателя)
+    /// @throw AbstractObserver#SystemError
+    /// @param[out] interfaces Показатели интерфейсов
+    /// @param[out] total Сумма показателей всех интерфейсов, кроме петлевого
+    void PollNetwork(std::vector<NetworkSample>& interfaces, NetworkSample& total);
+
+protected:
+    /// @copydoc AbstractObserver#CollectSamples
+    inline void CollectSamples(Mask mask, std::vector<Sample>& samples, const ProcessSnapshot*) override {
+        samples.push_back(Poll(mask));
+    }
+
+private:
+    /// Запоминает фильтр имен дисковых устройств, если он изменился
+    /// @throw AbstractObserver#Exception
+    /// @param[in] pattern Регулярное выражение для имен устройств
+    /// @param[in] ignoreCase Сравнивать имена без учета регистра
+    /// @return @b true, если фильтр изменился
+    inline bool SetDiskFilter(const std::string& pattern, bool ignoreCase) {
+        if (pattern == diskPattern_ && ignoreCase == diskIgnoreCase_) return false;
+
+        // Выражение компилируется только при смене фильтра, а не при каждом опросе
+        try {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (ignoreCase) flags |= std::regex::icase;
+            diskRegex_.assign(pattern, flags);
+        }
+        catch (const std::regex_error&) {
+            throw Exception("Invalid disk name pattern: " + pattern);
+        }
+
+        diskPattern_ = pattern;
+        diskIgnoreCase_ = ignoreCase;
+        return true;
+    }
+
+    /// Текущий фильтр имен дисковых устройств
+    std::string diskPattern_;
+    /// Текущий фильтр сравнивает имена без учета регистра
+    bool diskIgnoreCase_;
+    /// Скомпилированный фильтр имен дисковых устройств
+    std::regex diskRegex_;
+
 #if defined(TESTTOOLS_WIN)
 private:
     /// Возвращает значение загрузки физической памяти
@@ -69,6 +189,214 @@ private:
     pdh::UniqueCounter processorUsage_;
     /// Счетчик процента загрузки жесткого диска
     pdh::UniqueCounter diskUsage_;
+    /// Запрос загрузки отдельных процессоров. Опрашивается отдельно от остальных
+    /// счетчиков, чтобы не сдвигать интервал, на котором вычисляется их значение.
+    pdh::UniqueQuery coreQuery_;
+    /// Счетчик процента загрузки отдельных процессоров (все экземпляры)
+    pdh::UniqueCounter coreUsage_;
+    /// Буфер для значений счетчика загрузки отдельных процессоров
+    std::vector<char> coreBuffer_;
+
+    /// Запрос показателей ввода-вывода отдельных дисков (все экземпляры PhysicalDisk)
+    pdh::UniqueQuery diskQuery_;
+    /// Счетчики показателей ввода-вывода отдельных дисков (в порядке полей DiskSample)
+    pdh::UniqueCounter diskCounters_[7];
+
+    /// Запрос показателей сетевых интерфейсов (все экземпляры Network Interface)
+    pdh::UniqueQuery networkQuery_;
+    /// Счетчики показателей сетевых интерфейсов (в порядке полей NetworkSample)
+    pdh::UniqueCounter networkCounters_[8];
+    /// Количество отброшенных пакетов и ошибок на момент предыдущего опроса по именам интерфейсов.
+    /// В отличие от остальных, эти счетчики PDH возвращают накопленные значения, а не скорость.
+    std::vector<std::pair<std::string, std::array<double, 4>>> networkTotals_;
+    /// Время предыдущего опроса сетевых интерфейсов в миллисекундах
+    double networkTime_;
+    /// Буфер для значений экземпляров счетчиков дисков и сетевых интерфейсов
+    std::vector<char> valuesBuffer_;
+#endif
+
+#if defined(TESTTOOLS_LINUX)
+private:
+    /// Значения счетчиков времени процессора (в тиках) на момент опроса
+    struct ProcessorTimes
+    {
+        uint64_t busy;      ///< Время работы
+        uint64_t total;     ///< Общее время
+    };
+
+    /// Состояние дискового устройства между опросами
+    struct DiskState
+    {
+        uint64_t device;        ///< Номер устройства (major << 32 | minor)
+        std::string name;       ///< Имя устройства
+        bool matched;           ///< Имя устройства соответствует фильтру
+        uint64_t reads;         ///< Выполнено операций чтения
+        uint64_t readSectors;   ///< Прочитано секторов (по 512 байт)
+        uint64_t readTicks;     ///< Время операций чтения в миллисекундах
+        uint64_t writes;        ///< Выполнено операций записи
+        uint64_t writeSectors;  ///< Записано секторов (по 512 байт)
+        uint64_t writeTicks;    ///< Время операций записи в миллисекундах
+        uint64_t ioTicks;       ///< Время, в течение которого выполнялся ввод-вывод, в миллисекундах
+    };
+
+    /// Состояние сетевого интерфейса между опросами
+    struct NetworkState
+    {
+        uint64_t hash;          ///< Хеш имени интерфейса (для сравнения без сравнения строк)
+        std::string name;       ///< Имя интерфейса
+        bool loopback;          ///< Петлевой интерфейс (не входит в сумму)
+        uint64_t values[8];     ///< Счетчики (байт, пакетов, ошибок и отброшенных пакетов при приеме и отправке)
+    };
+
+    /// Значения счетчиков из /proc/meminfo (в килобайтах)
+    struct MemoryInfo
+    {
+        double total;       ///< Всего физической памяти
+        double available;   ///< Доступно физической памяти
+        double swapTotal;   ///< Всего памяти подкачки
+        double swapFree;    ///< Свободно памяти подкачки
+    };
+
+    /// Возвращает количество запущенных процессов
+    /// @throw AbstractObserver#SystemError
+    /// @return Количество процессов
+    double GetProcessCount() const;
+    /// Возвращает количество потоков во всех процессах
+    /// @throw AbstractObserver#SystemError
+    /// @return Количество потоков
+    double GetThreadCount() const;
+    /// Возвращает процент загрузки процессора с момента предыдущего опроса
+    /// @throw AbstractObserver#SystemError
+    /// @return Процент загрузки процессора
+    double GetProcessorUsage() const;
+    /// Возвращает процент использования лимита процессора группой cgroup с момента предыдущего опроса
+    /// @param[in] limit Лимит процессора группы (количество процессоров)
+    /// @return Процент использования лимита или @b -1, если потребление группы недоступно
+    double GetGroupProcessorUsage(double limit) const;
+    /// Возвращает процент загрузки физических дисков с момента предыдущего опроса
+    /// @throw AbstractObserver#SystemError
+    /// @return Средний по всем физическим дискам процент времени, занятого вводом-выводом
+    double GetDiskUsage() const;
+    /// Считывает значения счетчиков памяти
+    /// @throw AbstractObserver#SystemError
+    /// @return Значения счетчиков памяти
+    MemoryInfo GetMemoryInfo() const;
+
+    /// Вычисляет процент времени задержек ресурса с момента предыдущего опроса
+    /// по приращению накопленного времени задержек (поле total)
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] resource Ресурс
+    /// @param[out] some Процент времени, когда хотя бы одна задача ждала ресурса
+    /// @param[out] full Процент времени, когда все задачи ждали ресурса
+    /// @return @b false, если PSI недоступен
+    bool GetPressure(PressureResource resource, double& some, double& full) const;
+    /// Считывает и разбирает файл /proc/pressure/<ресурс>
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] resource Ресурс
+    /// @param[out] stat Значения PSI
+    void ReadPressure(PressureResource resource, PressureStat& stat) const;
+
+    /// Считывает время процессора из /proc/stat
+    /// @throw AbstractObserver#SystemError
+    /// @return Значения счетчиков времени процессора
+    ProcessorTimes ReadProcessorTimes() const;
+    /// Считывает время отдельных процессоров из /proc/stat в @e coreBusy_ и @e coreTotal_
+    /// (для отсутствующих в файле процессоров - NaN)
+    /// @throw AbstractObserver#SystemError
+    /// @return Количество прочитанных строк процессоров
+    size_t ReadCoreTimes();
+    /// Считывает /proc/diskstats и обновляет состав @e diskStates_, если устройства
+    /// появились или исчезли (значения счетчиков не изменяются)
+    /// @throw AbstractObserver#SystemError
+    /// @param[in] refilter Заново проверить соответствие фильтру имен всех устройств
+    void ReadDiskStates(bool refilter);
+    /// Считывает /proc/net/dev и обновляет состав @e networkStates_, если интерфейсы
+    /// появились или исчезли (значения счетчиков не изменяются)
+    /// @throw AbstractObserver#SystemError
+    void ReadNetworkStates();
+    /// Проверяет соответствие имени устройства текущему фильтру
+    /// @param[in] state Состояние устройства
+    /// @return @b true, если устройство попадает в результат PollDisks
+    bool IsDiskMatched(const DiskState& state) const;
+    /// Считывает суммарное время ввода-вывода физических дисков из /proc/diskstats
+    /// @throw AbstractObserver#SystemError
+    /// @return Суммарное время ввода-вывода в миллисекундах
+    uint64_t ReadDiskTicks() const;
+
+private:
+    /// Каталог /proc (для подсчета процессов)
+    procfs::Directory proc_;
+    /// Файл /proc/stat
+    procfs::File stat_;
+    /// Файл /proc/meminfo
+    procfs::File meminfo_;
+    /// Файл /proc/loadavg
+    procfs::File loadavg_;
+    /// Файл /proc/diskstats
+    procfs::File diskstats_;
+    /// Файл /proc/net/dev
+    procfs::File netdev_;
+    /// Файлы /proc/pressure/{cpu,memory,io} (закрыты, если PSI недоступен)
+    procfs::File pressure_[PressureResourceCount];
+    /// Буфер для чтения файлов procfs
+    mutable procfs::Buffer<32768> buffer_;
+    /// Буфер для чтения /proc/diskstats и /proc/net/dev, размер которых зависит от количества устройств
+    mutable std::vector<char> tableBuffer_;
+
+    /// Номера устройств (major << 32 | minor) физических дисков
+    std::vector<uint64_t> disks_;
+
+    /// Группа cgroup v2 процесса или @b nullptr, если ресурсы не могут быть ограничены
+    std::shared_ptr<testtools::CGroup> cgroup_;
+    /// Процессор, потребленный группой, на момент предыдущего опроса (в микросекундах)
+    mutable double groupProcessorUsec_;
+    /// Время предыдущего опроса процессора группы в миллисекундах
+    mutable double groupProcessorTime_;
+
+    /// Время процессора на момент предыдущего опроса
+    mutable ProcessorTimes processorTimes_;
+    /// Процент загрузки процессора, вычисленный при предыдущем опросе
+    mutable double processorUsage_;
+    /// Суммарное время ввода-вывода дисков на момент предыдущего опроса
+    mutable uint64_t diskTicks_;
+    /// Время предыдущего опроса дисков в миллисекундах
+    mutable double diskTime_;
+    /// Процент загрузки дисков, вычисленный при предыдущем опросе
+    mutable double diskUsage_;
+
+    /// Время работы отдельных процессоров (в тиках) при текущем опросе. Значения хранятся
+    /// как double в отдельных массивах, чтобы разности вычислялись векторными инструкциями.
+    std::vector<double> coreBusy_;
+    /// Общее время отдельных процессоров (в тиках) при текущем опросе
+    std::vector<double> coreTotal_;
+    /// Время работы отдельных процессоров на момент предыдущего опроса
+    std::vector<double> corePrevBusy_;
+    /// Общее время отдельных процессоров на момент предыдущего опроса
+    std::vector<double> corePrevTotal_;
+    /// Процент загрузки отдельных процессоров, вычисленный при предыдущем опросе
+    std::vector<double> coreUsage_;
+
+    /// Накопленное время задержек ресурса на момент предыдущего опроса
+    struct PressureTotals
+    {
+        double some;        ///< Хотя бы одна задача ждала (в мкс)
+        double full;        ///< Все задачи ждали (в мкс)
+        double time;        ///< Время опроса в миллисекундах
+        double someUsage;   ///< Процент, вычисленный при предыдущем опросе
+        double fullUsage;   ///< Процент, вычисленный при предыдущем опросе
+    };
+    /// Накопленное время задержек по ресурсам на момент предыдущего опроса
+    mutable PressureTotals pressureTotals_[PressureResourceCount];
+
+    /// Состояния дисковых устройств в порядке строк /proc/diskstats
+    std::vector<DiskState> diskStates_;
+    /// Время предыдущего опроса дисковых устройств в миллисекундах
+    double diskStatesTime_;
+
+    /// Состояния сетевых интерфейсов в порядке строк /proc/net/dev
+    std::vector<NetworkState> networkStates_;
+    /// Время предыдущего опроса сетевых интерфейсов в миллисекундах
+    double networkTime_;
 #endif
 }; // class SystemObserver
 
@@ -0,0 +1,859 @@
+/// @file
+/// Реализация работы наблюдателя за системой для Linux.
+
+#include "systemobserver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include <dirent.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h> // SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h> // NEON
+#endif
+
+/// Делитель для перевода байт в килобайты
+#define KBYTESDIV 1024
+
+namespace testtools
+{
+
+using std::string;
+using std::vector;
+
+/// Функции-помощники SystemObserver
+namespace
+{
+
+/// Каталог sysfs со списком блочных устройств
+const char* const kSysBlock = "/sys/block";
+/// Размер сектора в /proc/diskstats в килобайтах (всегда 512 байт, независимо от устройства)
+const double kSectorKBytes = 0.5;
+
+/// Возвращает номера устройств физических дисков.
+/// Физическим считается блочное устройство, у которого есть каталог "device" -
+/// у разделов, loop, ram, dm и прочих виртуальных устройств его нет.
+/// @return Номера устройств в формате (major << 32 | minor)
+vector<uint64_t> GetPhysicalDisks()
+{
+    vector<uint64_t> disks = {};
+
+    DIR* dir = ::opendir(kSysBlock);
+    if (nullptr == dir) return disks;
+
+    procfs::Buffer<64> buffer = { '\0' };
+    string path(PATH_MAX, '\0');
+    while (const struct dirent* entry = ::readdir(dir)) {
+        if ('.' == entry->d_name[0]) continue;
+
+        std::snprintf(&path[0], path.size(), "%s/%s/device", kSysBlock, entry->d_name);
+        if (0 != ::access(path.data(), F_OK)) continue;
+
+        std::snprintf(&path[0], path.size(), "%s/%s/dev", kSysBlock, entry->d_name);
+        procfs::File dev;
+        if (!dev.Open(path.data()) || 0 >= dev.Read(buffer)) continue;
+
+        // Формат файла: "major:minor"
+        uint64_t major = 0;
+        uint64_t minor = 0;
+        const char* p = procfs::ParseUInt(buffer.data(), major);
+        if (':' != *p) continue;
+        procfs::ParseUInt(p + 1, minor);
+        disks.push_back((major << 32) | minor);
+    }
+
+    ::closedir(dir);
+
+    std::sort(disks.begin(), disks.end());
+    return disks;
+}
+
+/// Разбирает строку времени процессора из /proc/stat (после метки "cpu" или "cpuN"):
+/// "user nice system idle iowait irq softirq steal guest guest_nice".
+/// Время guest и guest_nice уже учтено в user и nice, поэтому в сумму не входит.
+/// @param[in] p Указатель на первое значение строки
+/// @param[out] busy Время работы в тиках
+/// @param[out] total Общее время в тиках
+void ParseProcessorTimes(const char* p, uint64_t& busy, uint64_t& total) noexcept
+{
+    uint64_t values[8] = { 0 };
+    for (auto& value : values)
+        p = procfs::ParseUInt(p, value);
+
+    total = 0;
+    for (const auto value : values)
+        total += value;
+    busy = total - values[3] - values[4];
+}
+
+/// Вычисляет загрузку процессоров по разностям времени между опросами.
+/// Процессоры, у которых общее время не изменилось (или неизвестно - NaN), сохраняют прежнее значение.
+/// Выбор значения мешает компилятору векторизовать цикл, поэтому для SSE2 и NEON
+/// по два процессора обрабатываются за раз с выбором по маске сравнения.
+/// @param[in] busy Время работы процессоров при текущем опросе
+/// @param[in] total Общее время процессоров при текущем опросе
+/// @param[in] prevBusy Время работы процессоров при предыдущем опросе
+/// @param[in] prevTotal Общее время процессоров при предыдущем опросе
+/// @param[in,out] usage Процент загрузки процессоров
+/// @param[in] count Количество процессоров
+void ComputeCoreUsage(const double* __restrict busy, const double* __restrict total,
+    const double* __restrict prevBusy, const double* __restrict prevTotal, double* __restrict usage, size_t count) noexcept
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d hundred = _mm_set1_pd(100.);
+    for (; i + 2 <= count; i += 2) {
+        const __m128d dbusy = _mm_sub_pd(_mm_loadu_pd(busy + i), _mm_loadu_pd(prevBusy + i));
+        const __m128d dtotal = _mm_sub_pd(_mm_loadu_pd(total + i), _mm_loadu_pd(prevTotal + i));
+        // Сравнение с NaN ложно, поэтому такие процессоры также сохраняют прежнее значение
+        const __m128d mask = _mm_cmpgt_pd(dtotal, zero);
+        const __m128d value = _mm_div_pd(_mm_mul_pd(dbusy, hundred), dtotal);
+        const __m128d previous = _mm_loadu_pd(usage + i);
+        _mm_storeu_pd(usage + i, _mm_or_pd(_mm_and_pd(mask, value), _mm_andnot_pd(mask, previous)));
+    }
+#elif defined(__aarch64__)
+    for (; i + 2 <= count; i += 2) {
+        const float64x2_t dbusy = vsubq_f64(vld1q_f64(busy + i), vld1q_f64(prevBusy + i));
+        const float64x2_t dtotal = vsubq_f64(vld1q_f64(total + i), vld1q_f64(prevTotal + i));
+        // Сравнение с NaN ложно, поэтому такие процессоры также сохраняют прежнее значение
+        const uint64x2_t mask = vcgtq_f64(dtotal, vdupq_n_f64(0.));
+        const float64x2_t value = vdivq_f64(vmulq_n_f64(dbusy, 100.), dtotal);
+        vst1q_f64(usage + i, vbslq_f64(mask, value, vld1q_f64(usage + i)));
+    }
+#endif
+
+    // Остаток (или все процессоры без SSE2 и NEON)
+    for (; i < count; ++i) {
+        const double dbusy = busy[i] - prevBusy[i];
+        const double dtotal = total[i] - prevTotal[i];
+        if (dtotal > 0.) usage[i] = dbusy * 100. / dtotal;
+    }
+}
+
+/// Разбирает начало строки /proc/diskstats: "major minor name"
+/// @param[in] p Указатель на начало строки
+/// @param[out] device Номер устройства (major << 32 | minor)
+/// @param[out] name Указатель на имя устройства
+/// @param[out] length Длина имени устройства
+/// @return Указатель на первый счетчик строки
+const char* ParseDiskHeader(const char* p, uint64_t& device, const char*& name, size_t& length) noexcept
+{
+    uint64_t major = 0;
+    uint64_t minor = 0;
+    p = procfs::SkipSpaces(procfs::ParseUInt(procfs::ParseUInt(p, major), minor));
+    device = (major << 32) | minor;
+
+    name = p;
+    while ('\0' != *p && ' ' != *p && '\n' != *p) ++p;
+    length = static_cast<size_t>(p - name);
+    return p;
+}
+
+/// Разбирает имя интерфейса в строке /proc/net/dev ("  eth0: 123 ...")
+/// @param[in] p Указатель на начало строки
+/// @param[out] hash Хеш имени (FNV-1a), вычисляемый попутно с поиском разделителя
+/// @param[out] name Указатель на имя интерфейса
+/// @param[out] length Длина имени интерфейса
+/// @return Указатель на первый счетчик строки
+const char* ParseNetworkHeader(const char* p, uint64_t& hash, const char*& name, size_t& length) noexcept
+{
+    name = procfs::SkipSpaces(p);
+    hash = 14695981039346656037ull;
+    for (p = name; ':' != *p && '\0' != *p && '\n' != *p; ++p)
+        hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ull;
+
+    length = static_cast<size_t>(p - name);
+    return ':' == *p ? p + 1 : p;
+}
+
+/// Разбирает счетчики интерфейса в строке /proc/net/dev
+/// @param[in] p Указатель на первый счетчик строки
+/// @param[out] values Байт, пакетов, ошибок и отброшенных пакетов при приеме, затем - при отправке
+void ParseNetworkValues(const char* p, uint64_t (&values)[8]) noexcept
+{
+    // Формат: "bytes packets errs drop fifo frame compressed multicast" для приема
+    // и "bytes packets errs drop fifo colls carrier compressed" для отправки
+    uint64_t fields[16] = { 0 };
+    for (auto& field : fields)
+        p = procfs::ParseUInt(p, field);
+
+    for (size_t i = 0; i < 4; ++i) {
+        values[i] = fields[i];
+        values[4 + i] = fields[8 + i];
+    }
+}
+
+/// Файлы PSI по ресурсам (в порядке SystemObserver::PressureResource)
+const char* const kPressureFiles[] = { "pressure/cpu", "pressure/memory", "pressure/io" };
+
+/// Разбирает строку PSI: "some avg10=0.12 avg60=0.05 avg300=0.01 total=12345"
+/// @param[in] p Указатель на первое поле после метки строки
+/// @param[out] values avg10, avg60, avg300 и total
+void ParsePressureLine(const char* p, double (&values)[4]) noexcept
+{
+    for (auto& value : values) {
+        while ('\0' != *p && '\n' != *p && '=' != *p) ++p;
+        if ('=' != *p) return;
+
+        uint64_t integer = 0;
+        p = procfs::ParseUInt(p + 1, integer);
+        value = static_cast<double>(integer);
+        if ('.' == *p) {
+            double scale = 0.1;
+            for (++p; '0' <= *p && '9' >= *p; ++p, scale /= 10)
+                value += (*p - '0') * scale;
+        }
+    }
+}
+
+/// Возвращает разность значений счетчика с учетом его переполнения
+/// (в ядрах до 4.19 часть счетчиков /proc/diskstats 32-разрядные)
+/// @param[in] current Текущее значение
+/// @param[in] previous Предыдущее значение
+/// @return Разность значений или @b 0, если счетчик переполнился
+inline double Delta(uint64_t current, uint64_t previous) noexcept
+{
+    return current >= previous ? static_cast<double>(current - previous) : 0.;
+}
+
+/// Формирует полный путь к файлу procfs
+/// @param[in] name Имя файла относительно корня procfs
+/// @return Полный путь
+string GetProcPath(const char* name)
+{
+    return string(procfs::GetRoot()) + '/' + name;
+}
+
+} // namespace
+
+SystemObserver::SystemObserver()
+    : AbstractObserver(System, "System")
+    , diskPattern_()
+    , diskIgnoreCase_(false)
+    , diskRegex_()
+    , proc_(procfs::GetRoot())
+    , stat_(GetProcPath("stat").data())
+    , meminfo_(GetProcPath("meminfo").data())
+    , loadavg_(GetProcPath("loadavg").data())
+    , diskstats_()
+    , buffer_({ '\0' })
+    , tableBuffer_()
+    , disks_(GetPhysicalDisks())
+    , cgroup_(CGroup::GetCurrent())
+    , groupProcessorUsec_(0.)
+    , groupProcessorTime_(0.)
+    , processorTimes_({ 0, 0 })
+    , processorUsage_(0.)
+    , diskTicks_(0)
+    , diskTime_(0.)
+    , diskUsage_(0.)
+    , pressureTotals_()
+    , diskStatesTime_(0.)
+    , networkTime_(0.)
+{
+    // /proc/diskstats может отсутствовать, если ядро собрано без поддержки блочных устройств
+    diskstats_.Open(GetProcPath("diskstats").data());
+
+    // Запоминаем начальные значения, чтобы первый опрос вернул загрузку с момента создания наблюдателя
+    processorTimes_ = ReadProcessorTimes();
+    if (cgroup_) {
+        groupProcessorUsec_ = cgroup_->GetCpuUsage();
+        groupProcessorTime_ = procfs::GetMonotonicTime();
+    }
+    diskTicks_ = ReadDiskTicks();
+    diskTime_ = procfs::GetMonotonicTime();
+
+    ReadCoreTimes();
+    coreBusy_.swap(corePrevBusy_);
+    coreTotal_.swap(corePrevTotal_);
+
+    if (diskstats_.IsOpen()) {
+        ReadDiskStates(true);
+        diskStatesTime_ = procfs::GetMonotonicTime();
+    }
+
+    // /proc/pressure отсутствует в ядрах до 4.20 и при загрузке с psi=0: такие счетчики не возвращаются
+    for (size_t i = 0; i < PressureResourceCount; ++i) {
+        if (!pressure_[i].Open(GetProcPath(kPressureFiles[i]).data())) continue;
+
+        PressureStat stat = {};
+        ReadPressure(static_cast<PressureResource>(i), stat);
+        pressureTotals_[i].some = stat.some[3];
+        pressureTotals_[i].full = stat.full[3];
+        pressureTotals_[i].time = procfs::GetMonotonicTime();
+    }
+
+    // /proc/net/dev отсутствует, если ядро собрано без поддержки сети
+    if (netdev_.Open(GetProcPath("net/dev").data())) {
+        ReadNetworkStates();
+        networkTime_ = procfs::GetMonotonicTime();
+    }
+}
+
+SystemObserver::Result SystemObserver::Poll(Mask mask) const
+{
+    Result presult;
+    if (ProcessCount & mask)
+        presult.Set(ProcessCount, GetProcessCount());
+    if (ThreadCount & mask)
+        presult.Set(ThreadCount, GetThreadCount());
+    if (ProcessorUsage & mask)
+        presult.Set(ProcessorUsage, GetProcessorUsage());
+
+    if ((PhysicalMemoryUsage | PhysicalMemoryUsageKBytes | VirtualMemoryUsage | VirtualMemoryUsageKBytes) & mask) {
+        const MemoryInfo info = GetMemoryInfo();
+        const double pused = info.total - info.available;
+        // Виртуальной памятью в Linux считаем физическую память вместе с памятью подкачки
+        const double vtotal = info.total + info.swapTotal;
+        const double vused = vtotal - info.available - info.swapFree;
+
+        if (PhysicalMemoryUsage & mask)
+            presult.Set(PhysicalMemoryUsage, std::floor((pused * 100) / info.total));
+        if (PhysicalMemoryUsageKBytes & mask)
+            presult.Set(PhysicalMemoryUsageKBytes, pused);
+        if (VirtualMemoryUsage & mask)
+            presult.Set(VirtualMemoryUsage, std::floor((vused * 100) / vtotal));
+        if (VirtualMemoryUsageKBytes & mask)
+            presult.Set(VirtualMemoryUsageKBytes, vused);
+    }
+
+    if (DiskUsage & mask)
+        presult.Set(DiskUsage, GetDiskUsage());
+
+    // Для каждого ресурса оба значения (some и full) получаются одним чтением файла
+    static const Mask kPressureCounters[][2] = {
+        { CpuPressure, CpuPressureFull }, { MemoryPressure, MemoryPressureFull }, { IoPressure, IoPressureFull }
+    };
+    for (size_t i = 0; i < PressureResourceCount; ++i) {
+        const Mask some = kPressureCounters[i][0];
+        const Mask full = kPressureCounters[i][1];
+        if (0 == ((some | full) & mask)) continue;
+
+        double someUsage = 0.;
+        double fullUsage = 0.;
+        if (!GetPressure(static_cast<PressureResource>(i), someUsage, fullUsage)) continue;
+        if (some & mask) presult.Set(some, someUsage);
+        if (full & mask) presult.Set(full, fullUsage);
+    }
+
+    return presult;
+}
+
+void SystemObserver::PollPressure(std::array<PressureStat, PressureResourceCount>& stats) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t i = 0; i < PressureResourceCount; ++i) {
+        stats[i] = PressureStat();
+        if (pressure_[i].IsOpen()) ReadPressure(static_cast<PressureResource>(i), stats[i]);
+    }
+}
+
+void SystemObserver::PollCores(vector<double>& usage)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const size_t lines = ReadCoreTimes();
+    const size_t count = coreTotal_.size();
+
+    // Процессор мог появиться после предыдущего опроса (hotplug): его прежние значения неизвестны
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    corePrevBusy_.resize(count, nan);
+    corePrevTotal_.resize(count, nan);
+    coreUsage_.resize(count, nan);
+
+    ComputeCoreUsage(coreBusy_.data(), coreTotal_.data(), corePrevBusy_.data(), corePrevTotal_.data(),
+        coreUsage_.data(), count);
+
+    // Отключенные процессоры отсутствуют в /proc/stat, их загрузка неизвестна
+    if (lines != count) {
+        for (size_t i = 0; i < count; ++i)
+            if (std::isnan(coreTotal_[i])) coreUsage_[i] = nan;
+    }
+
+    coreBusy_.swap(corePrevBusy_);
+    coreTotal_.swap(corePrevTotal_);
+    usage.assign(coreUsage_.begin(), coreUsage_.end());
+}
+
+void SystemObserver::PollDisks(const string& pattern, bool ignoreCase, vector<DiskSample>& disks)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    disks.clear();
+    const bool refilter = SetDiskFilter(pattern, ignoreCase);
+    if (!diskstats_.IsOpen()) return;
+
+    ReadDiskStates(refilter);
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - diskStatesTime_;
+    diskStatesTime_ = time;
+
+    // Формат строки: "major minor name" и далее счетчики: чтений, объединенных чтений, секторов
+    // прочитано, мс на чтение, записей, объединенных записей, секторов записано, мс на запись,
+    // операций в процессе, мс ввода-вывода (io_ticks), ...
+    size_t index = 0;
+    for (const char* p = tableBuffer_.data(); '\0' != *p && index < diskStates_.size(); p = procfs::NextLine(p), ++index) {
+        DiskState& state = diskStates_[index];
+
+        uint64_t device = 0;
+        const char* name = nullptr;
+        size_t length = 0;
+        const char* v = ParseDiskHeader(p, device, name, length);
+
+        uint64_t values[10] = { 0 };
+        for (auto& value : values)
+            v = procfs::ParseUInt(v, value);
+
+        if (state.matched && 0. < elapsed) {
+            const double reads = Delta(values[0], state.reads);
+            const double writes = Delta(values[4], state.writes);
+            const double rate = 1000. / elapsed;
+
+            DiskSample disk = {};
+            disk.name = state.name;
+            disk.reads = reads * rate;
+            disk.writes = writes * rate;
+            disk.readKBytes = Delta(values[2], state.readSectors) * kSectorKBytes * rate;
+            disk.writeKBytes = Delta(values[6], state.writeSectors) * kSectorKBytes * rate;
+            disk.readLatency = 0. < reads ? Delta(values[3], state.readTicks) / reads : 0.;
+            disk.writeLatency = 0. < writes ? Delta(values[7], state.writeTicks) / writes : 0.;
+            disk.usage = std::min(Delta(values[9], state.ioTicks) * 100. / elapsed, 100.);
+            disks.push_back(std::move(disk));
+        }
+
+        state.reads = values[0];
+        state.readSectors = values[2];
+        state.readTicks = values[3];
+        state.writes = values[4];
+        state.writeSectors = values[6];
+        state.writeTicks = values[7];
+        state.ioTicks = values[9];
+    }
+}
+
+void SystemObserver::PollNetwork(vector<NetworkSample>& interfaces, NetworkSample& total)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    interfaces.clear();
+    total = NetworkSample();
+    total.name = "total";
+    if (!netdev_.IsOpen()) return;
+
+    ReadNetworkStates();
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - networkTime_;
+    networkTime_ = time;
+
+    // Первые две строки файла - заголовки таблицы
+    const char* p = procfs::NextLine(procfs::NextLine(tableBuffer_.data()));
+    for (size_t index = 0; '\0' != *p && index < networkStates_.size(); p = procfs::NextLine(p), ++index) {
+        NetworkState& state = networkStates_[index];
+
+        uint64_t hash = 0;
+        const char* name = nullptr;
+        size_t length = 0;
+        uint64_t values[8] = { 0 };
+        ParseNetworkValues(ParseNetworkHeader(p, hash, name, length), values);
+
+        if (0. < elapsed) {
+            const double rate = 1000. / elapsed;
+            double deltas[8] = { 0. };
+            for (size_t i = 0; i < 8; ++i)
+                deltas[i] = Delta(values[i], state.values[i]) * rate;
+
+            NetworkSample sample = {};
+            sample.name = state.name;
+            sample.receiveKBytes = deltas[0] / KBYTESDIV;
+            sample.receivePackets = deltas[1];
+            sample.receiveErrors = deltas[2];
+            sample.receiveDrops = deltas[3];
+            sample.sendKBytes = deltas[4] / KBYTESDIV;
+            sample.sendPackets = deltas[5];
+            sample.sendErrors = deltas[6];
+            sample.sendDrops = deltas[7];
+
+            if (!state.loopback) {
+                total.receiveKBytes += sample.receiveKBytes;
+                total.sendKBytes += sample.sendKBytes;
+                total.receivePackets += sample.receivePackets;
+                total.sendPackets += sample.sendPackets;
+                total.receiveDrops += sample.receiveDrops;
+                total.sendDrops += sample.sendDrops;
+                total.receiveErrors += sample.receiveErrors;
+                total.sendErrors += sample.sendErrors;
+            }
+            interfaces.push_back(std::move(sample));
+        }
+
+        std::copy(std::begin(values), std::end(values), std::begin(state.values));
+    }
+}
+
+double SystemObserver::GetProcessCount() const
+{
+    // Каждому процессу соответствует числовой каталог в /proc
+    size_t processes = 0;
+    if (!proc_.ForEachId([&processes](uint32_t) { processes++; }))
+        throw SystemError(static_cast<errno_t>(errno));
+
+    return static_cast<double>(processes);
+}
+
+double SystemObserver::GetThreadCount() const
+{
+    if (-1 == loadavg_.Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Формат файла: "0.20 0.18 0.12 1/80 11206" - четвертое поле содержит
+    // количество выполняемых и общее количество сущностей планировщика (потоков).
+    const char* p = procfs::SkipField(procfs::SkipField(procfs::SkipField(buffer_.data())));
+    p = std::strchr(p, '/');
+
+    uint64_t threads = 0;
+    if (nullptr != p) procfs::ParseUInt(p + 1, threads);
+
+    return static_cast<double>(threads);
+}
+
+double SystemObserver::GetProcessorUsage() const
+{
+    // В контейнере с лимитом процессора загрузка считается относительно лимита, а не всех процессоров узла
+    const double limit = cgroup_ ? cgroup_->GetCpuLimit() : 0.;
+    if (0. < limit) {
+        const double usage = GetGroupProcessorUsage(limit);
+        if (0. <= usage) {
+            // Пока загрузка считается по группе, значения /proc/stat не считываются и устаревают:
+            // сбрасываем их, чтобы после снятия лимита первый опрос не охватил весь этот период
+            processorTimes_ = { 0, 0 };
+            return usage;
+        }
+    }
+
+    // То же для значений группы: лимит может появиться снова
+    groupProcessorUsec_ = -1.;
+
+    const ProcessorTimes times = ReadProcessorTimes();
+    const uint64_t total = times.total - processorTimes_.total;
+    const uint64_t busy = times.busy - processorTimes_.busy;
+
+    /// @note Если между опросами не прошло ни одного тика или предыдущие значения сброшены -
+    /// возвращаем предыдущее значение, по аналогии с обработкой ошибок вычисления в GetPdhValue для Windows.
+    if (0 != processorTimes_.total && 0 != total && times.total > processorTimes_.total && times.busy >= processorTimes_.busy)
+        processorUsage_ = static_cast<double>(busy) * 100. / static_cast<double>(total);
+
+    processorTimes_ = times;
+    return processorUsage_;
+}
+
+double SystemObserver::GetGroupProcessorUsage(double limit) const
+{
+    const double usec = cgroup_->GetCpuUsage();
+    if (0. > usec) return -1.;
+
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - groupProcessorTime_;
+
+    // Лимит может превышать количество процессоров узла - больше них группа не получит
+    const double processors = std::min(limit, static_cast<double>(::sysconf(_SC_NPROCESSORS_ONLN)));
+    if (0. < elapsed && 0. <= groupProcessorUsec_ && usec >= groupProcessorUsec_)
+        processorUsage_ = std::min((usec - groupProcessorUsec_) * 0.1 / (elapsed * processors), 100.);
+
+    groupProcessorUsec_ = usec;
+    groupProcessorTime_ = time;
+    return processorUsage_;
+}
+
+double SystemObserver::GetDiskUsage() const
+{
+    const uint64_t ticks = ReadDiskTicks();
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - diskTime_;
+
+    if (!disks_.empty() && 0. < elapsed && ticks >= diskTicks_) {
+        const double usage = static_cast<double>(ticks - diskTicks_) * 100. / (elapsed * disks_.size());
+        diskUsage_ = std::min(usage, 100.);
+    }
+
+    diskTicks_ = ticks;
+    diskTime_ = time;
+    return diskUsage_;
+}
+
+SystemObserver::MemoryInfo SystemObserver::GetMemoryInfo() const
+{
+    if (-1 == meminfo_.Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Ключи в /proc/meminfo идут в фиксированном порядке, поэтому каждый следующий
+    // ищем с позиции предыдущего. MemAvailable отсутствует в ядрах до 3.14.
+    uint64_t total = 0, free = 0, available = 0, buffers = 0, cached = 0, swapTotal = 0, swapFree = 0;
+    const char* p = buffer_.data();
+    const char* v = nullptr;
+    if (nullptr != (v = procfs::FindLine(p, "MemTotal:"))) p = procfs::ParseUInt(v, total);
+    if (nullptr != (v = procfs::FindLine(p, "MemFree:"))) p = procfs::ParseUInt(v, free);
+
+    const char* a = procfs::FindLine(p, "MemAvailable:");
+    if (nullptr != a) p = procfs::ParseUInt(a, available);
+    if (nullptr != (v = procfs::FindLine(p, "Buffers:"))) p = procfs::ParseUInt(v, buffers);
+    if (nullptr != (v = procfs::FindLine(p, "Cached:"))) p = procfs::ParseUInt(v, cached);
+    if (nullptr != (v = procfs::FindLine(p, "SwapTotal:"))) p = procfs::ParseUInt(v, swapTotal);
+    if (nullptr != (v = procfs::FindLine(p, "SwapFree:"))) p = procfs::ParseUInt(v, swapFree);
+
+    if (nullptr == a) available = free + buffers + cached;
+    if (0 == total) throw Exception("Unable to parse /proc/meminfo.");
+
+    MemoryInfo info = { 0 };
+    info.total = static_cast<double>(total);
+    info.available = static_cast<double>(std::min(available, total));
+
+    // В контейнере с лимитом памяти физическая память - это лимит группы, а занятая - memory.current,
+    // иначе процент занятой памяти отражал бы весь узел и не предупреждал о приближении OOM
+    const double limit = cgroup_ ? cgroup_->GetMemoryLimit() / KBYTESDIV : 0.;
+    if (0. < limit && limit < info.total) {
+        const double used = cgroup_->GetMemoryUsage() / KBYTESDIV;
+        if (0. <= used) {
+            info.total = limit;
+            info.available = std::max(limit - used, 0.);
+        }
+    }
+    info.swapTotal = static_cast<double>(swapTotal);
+    info.swapFree = static_cast<double>(std::min(swapFree, swapTotal));
+
+    return info;
+}
+
+bool SystemObserver::GetPressure(PressureResource resource, double& some, double& full) const
+{
+    if (!pressure_[resource].IsOpen()) return false;
+
+    PressureStat stat = {};
+    ReadPressure(resource, stat);
+
+    PressureTotals& totals = pressureTotals_[resource];
+    const double time = procfs::GetMonotonicTime();
+    const double elapsed = time - totals.time;
+
+    // Накопленное время задержек измеряется в микросекундах, интервал - в миллисекундах
+    if (0. < elapsed) {
+        if (stat.some[3] >= totals.some)
+            totals.someUsage = std::min((stat.some[3] - totals.some) / (elapsed * 10.), 100.);
+        if (stat.full[3] >= totals.full)
+            totals.fullUsage = std::min((stat.full[3] - totals.full) / (elapsed * 10.), 100.);
+
+        totals.some = stat.some[3];
+        totals.full = stat.full[3];
+        totals.time = time;
+    }
+
+    some = totals.someUsage;
+    full = totals.fullUsage;
+    return true;
+}
+
+void SystemObserver::ReadPressure(PressureResource resource, PressureStat& stat) const
+{
+    if (-1 == pressure_[resource].Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Строка "full" для процессора появилась только в ядре 5.13
+    stat.available = true;
+    const char* p = nullptr;
+    if (nullptr != (p = procfs::FindLine(buffer_.data(), "some "))) ParsePressureLine(p, stat.some);
+    if (nullptr != (p = procfs::FindLine(buffer_.data(), "full "))) ParsePressureLine(p, stat.full);
+}
+
+SystemObserver::ProcessorTimes SystemObserver::ReadProcessorTimes() const
+{
+    if (-1 == stat_.Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Первая строка файла содержит суммарное время всех процессоров: "cpu  user nice system ..."
+    const char* p = procfs::FindLine(buffer_.data(), "cpu ");
+    if (nullptr == p) throw Exception("Unable to parse /proc/stat.");
+
+    ProcessorTimes times = { 0, 0 };
+    ParseProcessorTimes(p, times.busy, times.total);
+
+    return times;
+}
+
+size_t SystemObserver::ReadCoreTimes()
+{
+    if (-1 == stat_.Read(buffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Строки "cpuN ..." идут подряд сразу за суммарной строкой "cpu ...", поэтому
+    // разбор заканчивается на первой строке с другой меткой, не доходя до длинной строки "intr".
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const size_t count = std::max(coreTotal_.size(), corePrevTotal_.size());
+    coreBusy_.assign(count, nan);
+    coreTotal_.assign(count, nan);
+
+    size_t lines = 0;
+    for (const char* p = procfs::NextLine(buffer_.data()); 0 == std::strncmp(p, "cpu", 3); p = procfs::NextLine(p)) {
+        uint64_t index = 0;
+        const char* v = procfs::ParseUInt(p + 3, index);
+        if (' ' != *v) continue;
+
+        if (coreTotal_.size() <= index) {
+            coreBusy_.resize(index + 1, nan);
+            coreTotal_.resize(index + 1, nan);
+        }
+
+        uint64_t busy = 0;
+        uint64_t total = 0;
+        ParseProcessorTimes(v, busy, total);
+        coreBusy_[index] = static_cast<double>(busy);
+        coreTotal_[index] = static_cast<double>(total);
+        lines++;
+    }
+
+    return lines;
+}
+
+void SystemObserver::ReadDiskStates(bool refilter)
+{
+    if (-1 == diskstats_.Read(tableBuffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Пока устройства не появляются и не исчезают, номера устройств в строках совпадают
+    // с сохраненными построчно, и состояния перестраивать не нужно.
+    size_t index = 0;
+    bool changed = false;
+    for (const char* p = tableBuffer_.data(); '\0' != *p; p = procfs::NextLine(p), ++index) {
+        uint64_t major = 0;
+        uint64_t minor = 0;
+        procfs::ParseUInt(procfs::ParseUInt(p, major), minor);
+        if (diskStates_.size() <= index || diskStates_[index].device != ((major << 32) | minor)) {
+            changed = true;
+            break;
+        }
+    }
+
+    if (changed || diskStates_.size() != index) {
+        std::unordered_map<uint64_t, DiskState> previous = {};
+        for (auto& state : diskStates_)
+            previous.emplace(state.device, std::move(state));
+
+        vector<DiskState> states = {};
+        for (const char* p = tableBuffer_.data(); '\0' != *p; p = procfs::NextLine(p)) {
+            DiskState state = {};
+            const char* name = nullptr;
+            size_t length = 0;
+            const char* v = ParseDiskHeader(p, state.device, name, length);
+
+            const auto it = previous.find(state.device);
+            if (previous.end() != it && 0 == it->second.name.compare(0, string::npos, name, length)) {
+                states.push_back(std::move(it->second));
+                continue;
+            }
+
+            // Новое устройство: текущие значения счетчиков становятся начальными
+            uint64_t values[10] = { 0 };
+            for (auto& value : values)
+                v = procfs::ParseUInt(v, value);
+
+            state.name.assign(name, length);
+            state.matched = IsDiskMatched(state);
+            state.reads = values[0];
+            state.readSectors = values[2];
+            state.readTicks = values[3];
+            state.writes = values[4];
+            state.writeSectors = values[6];
+            state.writeTicks = values[7];
+            state.ioTicks = values[9];
+            states.push_back(std::move(state));
+        }
+
+        diskStates_.swap(states);
+    }
+
+    if (refilter) {
+        for (auto& state : diskStates_)
+            state.matched = IsDiskMatched(state);
+    }
+}
+
+void SystemObserver::ReadNetworkStates()
+{
+    if (-1 == netdev_.Read(tableBuffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Пока интерфейсы не появляются и не исчезают, хеши имен в строках совпадают
+    // с сохраненными построчно: строки имен при этом не сравниваются и не копируются.
+    const char* first = procfs::NextLine(procfs::NextLine(tableBuffer_.data()));
+    size_t index = 0;
+    bool changed = false;
+    for (const char* p = first; '\0' != *p; p = procfs::NextLine(p), ++index) {
+        uint64_t hash = 0;
+        const char* name = nullptr;
+        size_t length = 0;
+        ParseNetworkHeader(p, hash, name, length);
+        if (networkStates_.size() <= index || networkStates_[index].hash != hash) {
+            changed = true;
+            break;
+        }
+    }
+    if (!changed && networkStates_.size() == index) return;
+
+    vector<NetworkState> states = {};
+    for (const char* p = first; '\0' != *p; p = procfs::NextLine(p)) {
+        NetworkState state = {};
+        const char* name = nullptr;
+        size_t length = 0;
+        const char* v = ParseNetworkHeader(p, state.hash, name, length);
+
+        // Новый интерфейс: текущие значения счетчиков становятся начальными
+        state.name.assign(name, length);
+        const auto it = std::find_if(networkStates_.begin(), networkStates_.end(),
+            [&state](const NetworkState& other) { return other.hash == state.hash && other.name == state.name; });
+        if (networkStates_.end() != it) {
+            states.push_back(std::move(*it));
+            continue;
+        }
+
+        ParseNetworkValues(v, state.values);
+        state.loopback = "lo" == state.name;
+        states.push_back(std::move(state));
+    }
+
+    networkStates_.swap(states);
+}
+
+bool SystemObserver::IsDiskMatched(const DiskState& state) const
+{
+    // Без фильтра в результат попадают только физические диски - как и для счетчика DiskUsage
+    if (diskPattern_.empty())
+        return std::binary_search(disks_.begin(), disks_.end(), state.device);
+
+    return std::regex_search(state.name, diskRegex_);
+}
+
+uint64_t SystemObserver::ReadDiskTicks() const
+{
+    if (!diskstats_.IsOpen() || disks_.empty()) return 0;
+    if (-1 == diskstats_.Read(tableBuffer_)) throw SystemError(static_cast<errno_t>(errno));
+
+    // Формат строки: "major minor name" и далее счетчики, десятый из которых -
+    // время (в миллисекундах), в течение которого устройство выполняло ввод-вывод.
+    uint64_t ticks = 0;
+    for (const char* p = tableBuffer_.data(); '\0' != *p; p = procfs::NextLine(p)) {
+        uint64_t major = 0;
+        uint64_t minor = 0;
+        const char* field = procfs::ParseUInt(procfs::ParseUInt(p, major), minor);
+        if (!std::binary_search(disks_.begin(), disks_.end(), (major << 32) | minor)) continue;
+
+        field = procfs::SkipField(field);
+        for (int i = 0; i < 9; ++i)
+            field = procfs::SkipField(field);
+
+        uint64_t value = 0;
+        procfs::ParseUInt(field, value);
+        ticks += value;
+    }
+
+    return ticks;
+}
+
+} // namespace testtools
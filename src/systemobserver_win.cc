@@ -3,20 +3,75 @@
 
 #include "systemobserver.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
 #define KBYTESDIV 1024
 
 namespace testtools
 {
 
 using std::string;
-using std::unordered_map;
+
+/// Функции-помощники SystemObserver
+namespace
+{
+
+/// Считывает значения всех экземпляров счетчика
+/// @throw AbstractObserver#SystemError
+/// @param[in] counter Дескриптор счетчика
+/// @param[in,out] buffer Буфер для значений (увеличивается при необходимости и переиспользуется)
+/// @param[out] count Количество экземпляров
+/// @return Указатель на значения экземпляров в буфере
+const PDH_FMT_COUNTERVALUE_ITEM_A* GetPdhValues(pdh::Counter counter, std::vector<char>& buffer, DWORD& count)
+{
+    // Размер буфера зависит от количества экземпляров счетчика и длины их имен
+    DWORD size = static_cast<DWORD>(buffer.size());
+    pdh::Result result = ERROR_SUCCESS;
+    for (;;) {
+        auto items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_A*>(buffer.data());
+        result = ::PdhGetFormattedCounterArrayA(counter, PDH_FMT_DOUBLE, &size, &count, items);
+        if (PDH_MORE_DATA != result) break;
+        buffer.resize(size);
+    }
+    if (ERROR_SUCCESS != result) throw SystemObserver::SystemError(static_cast<errno_t>(result));
+
+    return reinterpret_cast<const PDH_FMT_COUNTERVALUE_ITEM_A*>(buffer.data());
+}
+
+/// Возвращает значение экземпляра счетчика.
+/// Ошибки вычисления значения игнорируются так же, как в AbstractObserver#GetPdhValue.
+/// @param[in] item Значение экземпляра счетчика
+/// @return Значение или @b 0, если его не удалось вычислить
+inline double GetPdhItemValue(const PDH_FMT_COUNTERVALUE_ITEM_A& item)
+{
+    const DWORD status = item.FmtValue.CStatus;
+    const bool valid = PDH_CSTATUS_VALID_DATA == status || PDH_CSTATUS_NEW_DATA == status;
+    return valid ? item.FmtValue.doubleValue : 0.;
+}
+
+} // namespace
 
 SystemObserver::SystemObserver()
     : AbstractObserver(System, "System")
+    , diskPattern_()
+    , diskIgnoreCase_(false)
+    , diskRegex_()
     , processCount_(nullptr)
     , threadCount_(nullptr)
     , processorUsage_(nullptr)
     , diskUsage_(nullptr)
+    , coreQuery_(nullptr)
+    , coreUsage_(nullptr)
+    , coreBuffer_()
+    , diskQuery_(nullptr)
+    , diskCounters_()
+    , networkQuery_(nullptr)
+    , networkCounters_()
+    , networkTotals_()
+    , networkTime_(0.)
+    , valuesBuffer_()
 {
     static const char* const kProcessCount = "\\System\\Processes";
     static const char* const kThreadCount = "\\System\\Threads";
@@ -28,8 +83,61 @@ SystemObserver::SystemObserver()
     processorUsage_.reset(AddPdhCounter(query_.get(), kProcessorUsage));
     diskUsage_.reset(AddPdhCounter(query_.get(), kDiskUsage));
 
-    const pdh::Result result = ::PdhCollectQueryData(query_.get());
+    pdh::Result result = ::PdhCollectQueryData(query_.get());
     if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    static const char* const kCoreUsage = "\\Processor(*)\\% Processor Time";
+
+    pdh::Query query = nullptr;
+    result = ::PdhOpenQueryA(nullptr, 0, &query);
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+    coreQuery_.reset(query);
+    coreUsage_.reset(AddPdhCounter(coreQuery_.get(), kCoreUsage));
+
+    result = ::PdhCollectQueryData(coreQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    // Порядок счетчиков совпадает с порядком полей DiskSample
+    static const char* const kDiskCounters[] = {
+        "\\PhysicalDisk(*)\\Disk Reads/sec",
+        "\\PhysicalDisk(*)\\Disk Writes/sec",
+        "\\PhysicalDisk(*)\\Disk Read Bytes/sec",
+        "\\PhysicalDisk(*)\\Disk Write Bytes/sec",
+        "\\PhysicalDisk(*)\\Avg. Disk sec/Read",
+        "\\PhysicalDisk(*)\\Avg. Disk sec/Write",
+        "\\PhysicalDisk(*)\\% Idle Time"
+    };
+
+    result = ::PdhOpenQueryA(nullptr, 0, &query);
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+    diskQuery_.reset(query);
+    for (size_t i = 0; i < sizeof(kDiskCounters) / sizeof(kDiskCounters[0]); ++i)
+        diskCounters_[i].reset(AddPdhCounter(diskQuery_.get(), kDiskCounters[i]));
+
+    result = ::PdhCollectQueryData(diskQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    // Порядок счетчиков совпадает с порядком полей NetworkSample
+    static const char* const kNetworkCounters[] = {
+        "\\Network Interface(*)\\Bytes Received/sec",
+        "\\Network Interface(*)\\Bytes Sent/sec",
+        "\\Network Interface(*)\\Packets Received/sec",
+        "\\Network Interface(*)\\Packets Sent/sec",
+        "\\Network Interface(*)\\Packets Received Discarded",
+        "\\Network Interface(*)\\Packets Outbound Discarded",
+        "\\Network Interface(*)\\Packets Received Errors",
+        "\\Network Interface(*)\\Packets Outbound Errors"
+    };
+
+    result = ::PdhOpenQueryA(nullptr, 0, &query);
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+    networkQuery_.reset(query);
+    for (size_t i = 0; i < sizeof(kNetworkCounters) / sizeof(kNetworkCounters[0]); ++i)
+        networkCounters_[i].reset(AddPdhCounter(networkQuery_.get(), kNetworkCounters[i]));
+
+    result = ::PdhCollectQueryData(networkQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+    networkTime_ = pdh::GetMonotonicTime();
 }
 
 SystemObserver::Result SystemObserver::Poll(Mask mask) const
@@ -37,27 +145,178 @@ SystemObserver::Result SystemObserver::Poll(Mask mask) const
     const pdh::Result result = ::PdhCollectQueryData(query_.get());
     if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
 
-    Result presult = {};
+    Result presult;
     if (ProcessCount & mask)
-        presult.emplace(std::make_pair("processes", GetPdhValue(processCount_.get())));
+        presult.Set(ProcessCount, GetPdhValue(processCount_.get()));
     if (ThreadCount & mask)
-        presult.emplace(std::make_pair("threads", GetPdhValue(threadCount_.get())));
+        presult.Set(ThreadCount, GetPdhValue(threadCount_.get()));
     if (ProcessorUsage & mask)
-        presult.emplace(std::make_pair("procusage", GetPdhValue(processorUsage_.get())));
+        presult.Set(ProcessorUsage, GetPdhValue(processorUsage_.get()));
     if (PhysicalMemoryUsage & mask)
-        presult.emplace(std::make_pair("pmemusage", GetPhysicalMemoryUsage(false)));
+        presult.Set(PhysicalMemoryUsage, GetPhysicalMemoryUsage(false));
     if (PhysicalMemoryUsageKBytes & mask)
-        presult.emplace(std::make_pair("pmemusagekb", GetPhysicalMemoryUsage(true)));
+        presult.Set(PhysicalMemoryUsageKBytes, GetPhysicalMemoryUsage(true));
     if (VirtualMemoryUsage & mask)
-        presult.emplace(std::make_pair("vmemusage", GetVirtualMemoryUsage(false)));
+        presult.Set(VirtualMemoryUsage, GetVirtualMemoryUsage(false));
     if (VirtualMemoryUsageKBytes & mask)
-        presult.emplace(std::make_pair("vmemusagekb", GetVirtualMemoryUsage(true)));
+        presult.Set(VirtualMemoryUsageKBytes, GetVirtualMemoryUsage(true));
     if (DiskUsage & mask)
-        presult.emplace(std::make_pair("diskusage", GetPdhValue(diskUsage_.get())));
+        presult.Set(DiskUsage, GetPdhValue(diskUsage_.get()));
 
     return presult;
 }
 
+void SystemObserver::PollPressure(std::array<PressureStat, PressureResourceCount>& stats) const
+{
+    // Pressure Stall Information есть только в Linux
+    for (auto& stat : stats)
+        stat = PressureStat();
+}
+
+void SystemObserver::PollCores(std::vector<double>& usage)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    pdh::Result result = ::PdhCollectQueryData(coreQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    // Экземпляры счетчика называются номерами процессоров, кроме суммарного "_Total"
+    DWORD count = 0;
+    const auto items = GetPdhValues(coreUsage_.get(), coreBuffer_, count);
+    usage.clear();
+    for (DWORD i = 0; i < count; ++i) {
+        const char* name = items[i].szName;
+        if ('0' > name[0] || '9' < name[0]) continue;
+
+        const size_t index = static_cast<size_t>(std::strtoul(name, nullptr, 10));
+        if (usage.size() <= index) usage.resize(index + 1, std::numeric_limits<double>::quiet_NaN());
+        usage[index] = GetPdhItemValue(items[i]);
+    }
+}
+
+void SystemObserver::PollDisks(const std::string& pattern, bool ignoreCase, std::vector<DiskSample>& disks)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    disks.clear();
+    SetDiskFilter(pattern, ignoreCase);
+
+    const pdh::Result result = ::PdhCollectQueryData(diskQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    const size_t count = sizeof(diskCounters_) / sizeof(diskCounters_[0]);
+    for (size_t i = 0; i < count; ++i) {
+        // Список дисков формируется по первому счетчику, значения остальных
+        // сопоставляются с ним по имени экземпляра (дисков обычно единицы)
+        DWORD items = 0;
+        const auto values = GetPdhValues(diskCounters_[i].get(), valuesBuffer_, items);
+        for (DWORD j = 0; j < items; ++j) {
+            const char* name = values[j].szName;
+            if (0 == std::strcmp(name, "_Total")) continue;
+
+            const double value = GetPdhItemValue(values[j]);
+
+            if (0 == i) {
+                if (!diskPattern_.empty() && !std::regex_search(name, diskRegex_)) continue;
+                DiskSample disk = {};
+                disk.name = name;
+                disk.reads = value;
+                disks.push_back(std::move(disk));
+                continue;
+            }
+
+            auto disk = std::find_if(disks.begin(), disks.end(),
+                [name](const DiskSample& disk) { return disk.name == name; });
+            if (disks.end() == disk) continue;
+
+            switch (i) {
+            case 1: disk->writes = value; break;
+            case 2: disk->readKBytes = value / KBYTESDIV; break;
+            case 3: disk->writeKBytes = value / KBYTESDIV; break;
+            case 4: disk->readLatency = value * 1000.; break;
+            case 5: disk->writeLatency = value * 1000.; break;
+            case 6: disk->usage = std::max(100. - value, 0.); break;
+            }
+        }
+    }
+}
+
+void SystemObserver::PollNetwork(std::vector<NetworkSample>& interfaces, NetworkSample& total)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    interfaces.clear();
+    total = NetworkSample();
+    total.name = "total";
+
+    const pdh::Result result = ::PdhCollectQueryData(networkQuery_.get());
+    if (ERROR_SUCCESS != result) throw SystemError(static_cast<errno_t>(result));
+
+    const double time = pdh::GetMonotonicTime();
+    const double elapsed = time - networkTime_;
+    networkTime_ = time;
+
+    // Петлевой интерфейс в счетчиках Network Interface отсутствует, поэтому в сумму входят все
+    std::vector<std::pair<std::string, std::array<double, 4>>> totals = {};
+    const size_t count = sizeof(networkCounters_) / sizeof(networkCounters_[0]);
+    for (size_t i = 0; i < count; ++i) {
+        DWORD items = 0;
+        const auto values = GetPdhValues(networkCounters_[i].get(), valuesBuffer_, items);
+        for (DWORD j = 0; j < items; ++j) {
+            const char* name = values[j].szName;
+            double value = GetPdhItemValue(values[j]);
+
+            if (0 == i) {
+                NetworkSample sample = {};
+                sample.name = name;
+                sample.receiveKBytes = value / KBYTESDIV;
+                interfaces.push_back(std::move(sample));
+                totals.emplace_back(name, std::array<double, 4>());
+                continue;
+            }
+
+            const auto it = std::find_if(interfaces.begin(), interfaces.end(),
+                [name](const NetworkSample& sample) { return sample.name == name; });
+            if (interfaces.end() == it) continue;
+            NetworkSample& sample = *it;
+
+            // Отброшенные пакеты и ошибки - накопленные значения: переводим в скорость сами
+            if (4 <= i) {
+                const size_t k = i - 4;
+                const size_t index = static_cast<size_t>(it - interfaces.begin());
+                totals[index].second[k] = value;
+
+                const auto previous = std::find_if(networkTotals_.begin(), networkTotals_.end(),
+                    [name](const std::pair<std::string, std::array<double, 4>>& item) { return item.first == name; });
+                const bool known = networkTotals_.end() != previous && 0. < elapsed && value >= previous->second[k];
+                value = known ? (value - previous->second[k]) * 1000. / elapsed : 0.;
+            }
+
+            switch (i) {
+            case 1: sample.sendKBytes = value / KBYTESDIV; break;
+            case 2: sample.receivePackets = value; break;
+            case 3: sample.sendPackets = value; break;
+            case 4: sample.receiveDrops = value; break;
+            case 5: sample.sendDrops = value; break;
+            case 6: sample.receiveErrors = value; break;
+            case 7: sample.sendErrors = value; break;
+            }
+        }
+    }
+    networkTotals_.swap(totals);
+
+    for (const auto& sample : interfaces) {
+        total.receiveKBytes += sample.receiveKBytes;
+        total.sendKBytes += sample.sendKBytes;
+        total.receivePackets += sample.receivePackets;
+        total.sendPackets += sample.sendPackets;
+        total.receiveDrops += sample.receiveDrops;
+        total.sendDrops += sample.sendDrops;
+        total.receiveErrors += sample.receiveErrors;
+        total.sendErrors += sample.sendErrors;
+    }
+}
+
 double SystemObserver::GetPhysicalMemoryUsage(bool kbytes)
 {
     MEMORYSTATUSEX msx = { 0 };